@@ -0,0 +1,44 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+// Counts every heap allocation made by the process, for benchmarks that
+// report allocations per operation. It replaces the global operator new and
+// delete, so include it in exactly one file of a program: the benchmark's
+// own source file.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace dtq
+{
+    namespace bench
+    {
+
+        inline std::atomic<long long> &allocationCounter()
+        {
+            static std::atomic<long long> count{0};
+            return count;
+        }
+
+        // Heap allocations made so far
+        inline long long allocations()
+        {
+            return allocationCounter().load(std::memory_order_relaxed);
+        }
+
+    } // namespace bench
+} // namespace dtq
+
+void *operator new(std::size_t size)
+{
+    dtq::bench::allocationCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+#endif // ALLOCCOUNTER_H
@@ -0,0 +1,89 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+// Small helpers shared by the standalone benchmark programs in bench/.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace dtq
+{
+    namespace bench
+    {
+
+        inline long long nowNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Nearest-rank percentile, p in [0, 100]. Sorts the samples in place.
+        inline double percentile(std::vector<double> &samples, double p)
+        {
+            if (samples.empty())
+                return 0.0;
+            std::sort(samples.begin(), samples.end());
+            size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+            return samples[std::min(rank, samples.size() - 1)];
+        }
+
+        // Reads "--name=value" from argv, falling back to a default.
+        inline long long argInt(int argc, char **argv, const std::string &name, long long fallback)
+        {
+            std::string prefix = "--" + name + "=";
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string arg(argv[i]);
+                if (arg.compare(0, prefix.size(), prefix) == 0)
+                    return std::atoll(arg.c_str() + prefix.size());
+            }
+            return fallback;
+        }
+
+        // Calibrates a batch size, then times reps batches. batch(n) performs n
+        // operations and returns the nanoseconds they took, so setup stays out of
+        // the measurement. The batch size grows until one batch takes minNs.
+        // Returns ns/op of each repetition, sorted ascending; a batch that returns
+        // a negative time has failed and yields just that value.
+        template <typename Batch>
+        std::vector<double> sampleNsPerOp(Batch &&batch, long long minNs, int reps)
+        {
+            long long iterations = 1;
+            for (;;)
+            {
+                long long elapsed = batch(iterations);
+                if (elapsed < 0)
+                    return {static_cast<double>(elapsed)};
+                if (elapsed >= minNs || iterations >= (1LL << 40))
+                    break;
+                // Jump close to the target once the timing is meaningful
+                long long scale = elapsed > minNs / 100 ? minNs / elapsed + 1 : 2;
+                iterations *= std::max(2LL, std::min(scale, 100LL));
+            }
+            std::vector<double> samples;
+            for (int r = 0; r < reps; ++r)
+                samples.push_back(static_cast<double>(batch(iterations)) / iterations);
+            std::sort(samples.begin(), samples.end());
+            return samples;
+        }
+
+        inline std::string argString(int argc, char **argv, const std::string &name, const std::string &fallback)
+        {
+            std::string prefix = "--" + name + "=";
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string arg(argv[i]);
+                if (arg.compare(0, prefix.size(), prefix) == 0)
+                    return arg.substr(prefix.size());
+            }
+            return fallback;
+        }
+
+    } // namespace bench
+} // namespace dtq
+
+#endif // BENCHUTIL_H
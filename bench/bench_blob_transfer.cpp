@@ -0,0 +1,153 @@
+// Sending large tasks to a worker socket, as assignTasks() does. "copy"
+// keeps the payload on the heap, encodes the task into a string and copies
+// that into the connection's output buffer; "sendfile" keeps the payload in
+// a BlobStore segment and sends the encoded head from memory and the payload
+// straight from the segment's file. A reader thread drains the other end of
+// a socketpair. Reports throughput and heap allocations per frame. Linux only.
+//
+//   bench_blob_transfer [--frames=2000] [--payload=1048576] [--dir=/tmp]
+
+#include "AllocCounter.h"
+#include "BenchUtil.h"
+#include "BlobStore.h"
+#include "Logger.h"
+#include "Network.h"
+#include "Task.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace dtq;
+
+#ifdef __linux__
+namespace
+{
+    bool sendAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool sendFileAll(int fd, const BlobRef &blob)
+    {
+        off_t at = static_cast<off_t>(blob.offset);
+        size_t left = blob.size;
+        while (left > 0)
+        {
+            ssize_t n = ::sendfile(fd, blob.segment->fd(), &at, left);
+            if (n <= 0)
+                return false;
+            left -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    FrameHeader header(size_t size)
+    {
+        FrameHeader frame;
+        frame.type = static_cast<int32_t>(MessageType::SERVER_ASSIGN_TASK);
+        frame.requestId = 1;
+        frame.size = static_cast<int32_t>(size);
+        return frame;
+    }
+
+    void run(bool spliced, long long frames, size_t payloadSize, BlobStore &blobs)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            std::perror("socketpair");
+            return;
+        }
+        std::atomic<long long> received{0};
+        std::thread reader([&]() {
+            static char buffer[1 << 16];
+            ssize_t n;
+            while ((n = ::recv(fds[1], buffer, sizeof(buffer), 0)) > 0)
+                received.fetch_add(n, std::memory_order_relaxed);
+        });
+
+        Task task;
+        task.taskId = 1;
+        if (spliced)
+            task.payloadBlob = blobs.put(std::string(payloadSize, 'p'));
+        else
+            task.payload.assign(payloadSize, 'p');
+        std::string outBuf;
+
+        long long allocsBefore = bench::allocations();
+        long long start = bench::nowNs();
+        for (long long i = 0; i < frames; ++i)
+        {
+            if (spliced)
+            {
+                SplicedPayload reply;
+                task.serializeTo(reply);
+                FrameHeader frame = header(reply.size());
+                reply.bytes.insert(0, reinterpret_cast<const char *>(&frame), sizeof(frame));
+                sendAll(fds[0], reply.bytes.data(), reply.bytes.size());
+                sendFileAll(fds[0], reply.splices[0].blob);
+            }
+            else
+            {
+                std::string reply = task.serialize();
+                FrameHeader frame = header(reply.size());
+                outBuf.append(reinterpret_cast<const char *>(&frame), sizeof(frame));
+                outBuf.append(reply);
+                sendAll(fds[0], outBuf.data(), outBuf.size());
+                outBuf.clear();
+            }
+        }
+        ::shutdown(fds[0], SHUT_WR);
+        reader.join();
+        long long elapsed = bench::nowNs() - start;
+        long long allocs = bench::allocations() - allocsBefore;
+        ::close(fds[0]);
+        ::close(fds[1]);
+
+        std::printf("%-9s %10zu %10.2f %14.1f %14.2f\n", spliced ? "sendfile" : "copy", payloadSize,
+                    static_cast<double>(received.load()) / static_cast<double>(elapsed),
+                    static_cast<double>(elapsed) / static_cast<double>(frames) / 1000.0,
+                    static_cast<double>(allocs) / static_cast<double>(frames));
+    }
+} // namespace
+#endif
+
+int main(int argc, char **argv)
+{
+#ifdef __linux__
+    long long frames = bench::argInt(argc, argv, "frames", 2000);
+    size_t payloadSize = static_cast<size_t>(bench::argInt(argc, argv, "payload", 1 << 20));
+    std::string dir = bench::argString(argc, argv, "dir", "/tmp");
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    BlobStore blobs(dir);
+    if (!blobs.open())
+    {
+        std::fprintf(stderr, "%s\n", blobs.getLastError().c_str());
+        return 1;
+    }
+    std::printf("%-9s %10s %10s %14s %14s\n", "path", "payload", "GB/s", "us/frame", "allocs/frame");
+    run(false, frames, payloadSize, blobs);
+    run(true, frames, payloadSize, blobs);
+    return 0;
+#else
+    std::printf("bench_blob_transfer needs sendfile (Linux)\n");
+    return 0;
+#endif
+}
@@ -0,0 +1,213 @@
+// Socket calls and throughput per frame over loopback TCP. "fields" sends
+// and receives each header field and the payload with its own send()/recv(),
+// as Connection used to; "connection" is Network::Connection, which gathers a
+// frame into one write and parses frames out of a receive buffer. "stream"
+// sends frames back to back to a reader, "round trip" waits for each echo.
+//
+//   bench_connection_io [--frames=200000] [--round-trips=20000]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "Network.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#undef ERROR
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace dtq;
+
+namespace
+{
+    // Both ends of one loopback TCP connection, Nagle off as in the transports
+    bool openLoopback(SOCKET &a, SOCKET &b)
+    {
+        SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+#ifdef _WIN32
+        int len = sizeof(addr);
+#else
+        socklen_t len = sizeof(addr);
+#endif
+        a = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == INVALID_SOCKET || a == INVALID_SOCKET ||
+            bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listener, 1) != 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len) != 0 ||
+            connect(a, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            Network::closeSocket(listener);
+            return false;
+        }
+        b = accept(listener, nullptr, nullptr);
+        Network::closeSocket(listener);
+        int noDelay = 1;
+        setsockopt(a, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&noDelay), sizeof(noDelay));
+        setsockopt(b, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&noDelay), sizeof(noDelay));
+        return b != INVALID_SOCKET;
+    }
+
+    // The frame layout sent one field at a time, counting socket calls
+    struct FieldSocket
+    {
+        SOCKET sock;
+        long long sends = 0;
+        long long recvs = 0;
+
+        ~FieldSocket() { Network::closeSocket(sock); }
+
+        bool sendBytes(const char *data, size_t size)
+        {
+            while (size > 0)
+            {
+                int n = ::send(sock, data, static_cast<int>(size), 0);
+                ++sends;
+                if (n <= 0)
+                    return false;
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool recvBytes(char *data, size_t size)
+        {
+            while (size > 0)
+            {
+                int n = ::recv(sock, data, static_cast<int>(size), 0);
+                ++recvs;
+                if (n <= 0)
+                    return false;
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool sendMessage(MessageType type, uint32_t requestId, const std::string &payload)
+        {
+            int32_t size = static_cast<int32_t>(payload.size());
+            return sendBytes(reinterpret_cast<const char *>(&type), sizeof(type)) &&
+                   sendBytes(reinterpret_cast<const char *>(&requestId), sizeof(requestId)) &&
+                   sendBytes(reinterpret_cast<const char *>(&size), sizeof(size)) &&
+                   sendBytes(payload.data(), payload.size());
+        }
+
+        bool receiveMessage(MessageType &type, uint32_t &requestId, std::string &payload)
+        {
+            int32_t size = 0;
+            if (!recvBytes(reinterpret_cast<char *>(&type), sizeof(type)) ||
+                !recvBytes(reinterpret_cast<char *>(&requestId), sizeof(requestId)) ||
+                !recvBytes(reinterpret_cast<char *>(&size), sizeof(size)) || size < 0)
+                return false;
+            payload.resize(static_cast<size_t>(size));
+            return recvBytes(&payload[0], payload.size());
+        }
+
+        long long sendCalls() const { return sends; }
+        long long recvCalls() const { return recvs; }
+    };
+
+    struct ConnectionSocket
+    {
+        explicit ConnectionSocket(SOCKET sock) : conn(sock) {}
+        Network::Connection conn;
+
+        bool sendMessage(MessageType type, uint32_t requestId, const std::string &payload)
+        {
+            return conn.sendMessage(type, requestId, payload);
+        }
+        bool receiveMessage(MessageType &type, uint32_t &requestId, std::string &payload)
+        {
+            return conn.receiveMessage(type, requestId, payload);
+        }
+        long long sendCalls() const { return static_cast<long long>(conn.sendCalls()); }
+        long long recvCalls() const { return static_cast<long long>(conn.recvCalls()); }
+    };
+
+    template <typename Endpoint>
+    void run(const char *name, bool roundTrip, long long frames, size_t payloadSize)
+    {
+        SOCKET a, b;
+        if (!openLoopback(a, b))
+        {
+            std::printf("%-11s loopback setup failed\n", name);
+            return;
+        }
+        // Endpoints own (and close) their sockets
+        std::unique_ptr<Endpoint> sender(new Endpoint{a});
+        std::unique_ptr<Endpoint> receiver(new Endpoint{b});
+        const std::string payload(payloadSize, 'p');
+        long long start = bench::nowNs();
+        std::thread peer([&]() {
+            MessageType type;
+            uint32_t requestId = 0;
+            std::string body;
+            for (long long i = 0; i < frames && receiver->receiveMessage(type, requestId, body); ++i)
+            {
+                if (roundTrip)
+                    receiver->sendMessage(MessageType::SERVER_TASK_ACCEPTED, requestId, std::string());
+            }
+        });
+        MessageType type;
+        uint32_t requestId = 0;
+        std::string reply;
+        for (long long i = 0; i < frames; ++i)
+        {
+            sender->sendMessage(MessageType::CLIENT_ADD_TASK, static_cast<uint32_t>(i), payload);
+            if (roundTrip)
+                sender->receiveMessage(type, requestId, reply);
+        }
+        peer.join();
+        long long elapsed = bench::nowNs() - start;
+
+        // Per frame carried one way: the round trip's reply is counted with its request
+        double n = static_cast<double>(frames);
+        std::printf("%-11s %-11s %9zu %12.0f %12.2f %12.2f\n", name, roundTrip ? "round trip" : "stream",
+                    payloadSize, n * 1e9 / static_cast<double>(elapsed),
+                    static_cast<double>(sender->sendCalls() + receiver->sendCalls()) / n,
+                    static_cast<double>(sender->recvCalls() + receiver->recvCalls()) / n);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long frames = bench::argInt(argc, argv, "frames", 200000);
+    long long roundTrips = bench::argInt(argc, argv, "round-trips", 20000);
+    if (!Network::initialize())
+    {
+        std::fprintf(stderr, "Failed to initialize network\n");
+        return 1;
+    }
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-11s %-11s %9s %12s %12s %12s\n", "io", "pattern", "payload", "frames/s", "sends/frame",
+                "recvs/frame");
+    for (size_t payloadSize : {64, 4096, 1 << 20})
+    {
+        long long n = payloadSize >= (1 << 20) ? frames / 200 : frames;
+        run<FieldSocket>("fields", false, n, payloadSize);
+        run<ConnectionSocket>("connection", false, n, payloadSize);
+    }
+    run<FieldSocket>("fields", true, roundTrips, 64);
+    run<ConnectionSocket>("connection", true, roundTrips, 64);
+
+    Network::cleanup();
+    return 0;
+}
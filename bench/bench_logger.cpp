@@ -0,0 +1,91 @@
+// Logger overhead benchmark: N threads log as fast as they can, synchronous
+// logger vs. async (queue + background writer). Reports the cost seen by the
+// calling thread; stdout is discarded and lines go to --file, so the numbers
+// reflect the file write path the server and worker use.
+//
+//   bench_logger [--lines=100000] [--max-threads=16] [--file=bench_logger.log]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    };
+
+    struct Result
+    {
+        double nsPerLog; // caller-side, averaged over all lines
+        double p99Ns;
+        double totalSec; // until every line was written
+    };
+
+    Result run(bool async, int threads, long long lines)
+    {
+        Logger &logger = Logger::getInstance();
+        logger.setAsync(async);
+        std::vector<std::vector<double>> latencies(threads);
+
+        long long start = bench::nowNs();
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                std::vector<double> &samples = latencies[t];
+                for (long long i = t; i < lines; i += threads)
+                {
+                    long long begin = bench::nowNs();
+                    logger.log(LogLevel::INFO, "Task " + std::to_string(i) + " dequeued. Queue size=42");
+                    samples.push_back(static_cast<double>(bench::nowNs() - begin));
+                }
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        long long callersDone = bench::nowNs();
+        logger.setAsync(false); // drains
+        long long elapsed = bench::nowNs() - start;
+
+        std::vector<double> all;
+        for (auto &samples : latencies)
+            all.insert(all.end(), samples.begin(), samples.end());
+        return {static_cast<double>(callersDone - start) * threads / lines, bench::percentile(all, 99), elapsed / 1e9};
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long lines = bench::argInt(argc, argv, "lines", 100000);
+    int maxThreads = static_cast<int>(bench::argInt(argc, argv, "max-threads", 16));
+    std::string file = bench::argString(argc, argv, "file", "bench_logger.log");
+
+    NullBuffer discard;
+    std::streambuf *stdoutBuffer = std::cout.rdbuf(&discard);
+    Logger::getInstance().setLogFile(file);
+
+    std::printf("%-8s %-6s %12s %12s %10s\n", "threads", "mode", "ns/log", "p99 (ns)", "total (s)");
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        for (bool async : {false, true})
+        {
+            Result r = run(async, threads, lines);
+            std::printf("%-8d %-6s %12.0f %12.0f %10.3f\n", threads, async ? "async" : "sync", r.nsPerLog, r.p99Ns,
+                        r.totalSec);
+        }
+    }
+    std::cout.rdbuf(stdoutBuffer);
+    return 0;
+}
@@ -0,0 +1,397 @@
+// Core data-path microbenchmarks: TaskQueue enqueue/dequeue (alone and under
+// producer/consumer contention), Task encode/decode across payload sizes,
+// Logger::log and Connection sendMessage/receiveMessage over loopback.
+//
+// Each case calibrates its batch size to --min-ms, then reports the median of
+// --reps batches in ns/op and ops/s with the min..max spread, so single runs
+// are stable enough to compare. --save writes "case<TAB>ns/op" lines that a
+// later run (e.g. on another commit) reads with --baseline to print the change.
+//
+//   bench_micro [--filter=queue] [--reps=7] [--min-ms=100] [--save=base.tsv] [--baseline=base.tsv]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "Network.h"
+#include "Task.h"
+#include "TaskQueue.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#undef ERROR
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    volatile long long gSink = 0;
+
+    // batch(n) runs n operations and returns the elapsed nanoseconds
+    using Batch = std::function<long long(long long)>;
+
+    struct Case
+    {
+        std::string name;
+        Batch batch;
+    };
+
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    };
+
+    Task makeTask(size_t payloadSize)
+    {
+        Task task;
+        task.taskId = 12345;
+        task.payload.assign(payloadSize, 'p');
+        task.result = "Processed by Worker 1 in 750ms";
+        task.enqueueTimeMs = 1712650000000LL;
+        return task;
+    }
+
+    // Single thread, queue kept near empty: the uncontended cost of one
+    // enqueue plus one dequeue
+    Batch queueRoundTrip(QueueBackend backend)
+    {
+        return [backend](long long n) {
+            TaskQueue queue(backend);
+            Task task = makeTask(64);
+            long long start = bench::nowNs();
+            for (long long i = 0; i < n; ++i)
+            {
+                task.taskId = static_cast<int>(i & 0xffff);
+                queue.enqueue(task);
+                gSink += queue.dequeue()->taskId;
+            }
+            return bench::nowNs() - start;
+        };
+    }
+
+    // pairs producers and pairs consumers share one queue; an op is one task
+    // passing through it
+    Batch queueContended(QueueBackend backend, int pairs)
+    {
+        return [backend, pairs](long long n) {
+            TaskQueue queue(backend);
+            std::atomic<long long> consumed{0};
+            std::atomic<bool> go{false};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < pairs; ++t)
+            {
+                threads.emplace_back([&, t]() {
+                    Task task = makeTask(64);
+                    while (!go.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+                    for (long long i = t; i < n; i += pairs)
+                    {
+                        task.taskId = static_cast<int>(i & 0xffff);
+                        while (!queue.enqueue(task))
+                            std::this_thread::yield();
+                    }
+                });
+                threads.emplace_back([&]() {
+                    while (!go.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+                    while (consumed.load(std::memory_order_relaxed) < n)
+                    {
+                        if (queue.dequeue())
+                            consumed.fetch_add(1, std::memory_order_relaxed);
+                        else
+                            std::this_thread::yield();
+                    }
+                });
+            }
+            long long start = bench::nowNs();
+            go.store(true, std::memory_order_release);
+            for (auto &thread : threads)
+                thread.join();
+            return bench::nowNs() - start;
+        };
+    }
+
+    Batch taskEncode(size_t payloadSize, WireFormat format)
+    {
+        return [payloadSize, format](long long n) {
+            Task task = makeTask(payloadSize);
+            long long start = bench::nowNs();
+            for (long long i = 0; i < n; ++i)
+                gSink += task.serialize(format).size();
+            return bench::nowNs() - start;
+        };
+    }
+
+    Batch taskDecode(size_t payloadSize, WireFormat format)
+    {
+        return [payloadSize, format](long long n) {
+            const std::string data = makeTask(payloadSize).serialize(format);
+            long long start = bench::nowNs();
+            for (long long i = 0; i < n; ++i)
+                gSink += Task::deserialize(data).taskId;
+            return bench::nowNs() - start;
+        };
+    }
+
+    // Async batches include the final flush(), so they measure sustained
+    // throughput rather than only the enqueue on the calling thread
+    Batch loggerLog(bool async, int threads)
+    {
+        return [async, threads](long long n) {
+            Logger &logger = Logger::getInstance();
+            logger.setAsync(async);
+            long long start = bench::nowNs();
+            std::vector<std::thread> writers;
+            for (int t = 0; t < threads; ++t)
+            {
+                writers.emplace_back([&logger, t, threads, n]() {
+                    for (long long i = t; i < n; i += threads)
+                        logger.log(LogLevel::INFO, "Task " + std::to_string(i) + " dequeued. Queue size=42");
+                });
+            }
+            for (auto &writer : writers)
+                writer.join();
+            logger.flush();
+            long long elapsed = bench::nowNs() - start;
+            logger.setAsync(false);
+            return elapsed;
+        };
+    }
+
+    // A call site below the minimum level: what DTQ_LOG costs when filtered
+    Batch loggerFiltered()
+    {
+        return [](long long n) {
+            Logger &logger = Logger::getInstance();
+            logger.setMinLevel(LogLevel::WARN);
+            long long start = bench::nowNs();
+            for (long long i = 0; i < n; ++i)
+                DTQ_LOG(INFO, "Task " + std::to_string(i) + " dequeued");
+            long long elapsed = bench::nowNs() - start;
+            logger.setMinLevel(LogLevel::INFO);
+            return elapsed;
+        };
+    }
+
+    // Both ends of one loopback TCP connection, as plain Connections
+    struct LoopbackPair
+    {
+        std::unique_ptr<Network::Connection> client;
+        std::unique_ptr<Network::Connection> server;
+
+        bool open()
+        {
+            SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+#ifdef _WIN32
+            int len = sizeof(addr);
+#else
+            socklen_t len = sizeof(addr);
+#endif
+            if (listener == INVALID_SOCKET || bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+                listen(listener, 1) != 0 || getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+            {
+                Network::closeSocket(listener);
+                return false;
+            }
+            client = std::make_unique<Network::Connection>("127.0.0.1", ntohs(addr.sin_port));
+            bool connected = client->connect();
+            SOCKET accepted = connected ? accept(listener, nullptr, nullptr) : INVALID_SOCKET;
+            Network::closeSocket(listener);
+            if (accepted == INVALID_SOCKET)
+                return false;
+            // Same as the server transports
+            int noDelay = 1;
+            setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char *>(&noDelay), sizeof(noDelay));
+            server = std::make_unique<Network::Connection>(accepted);
+            return true;
+        }
+    };
+
+    // Request/response: client sends, server echoes, client receives. An op is
+    // one full round trip.
+    Batch connectionRoundTrip(size_t payloadSize)
+    {
+        return [payloadSize](long long n) -> long long {
+            LoopbackPair pair;
+            if (!pair.open())
+                return -1;
+            std::thread echo([&pair, n]() {
+                MessageType type;
+                uint32_t requestId = 0;
+                std::string payload;
+                for (long long i = 0; i < n && pair.server->receiveMessage(type, requestId, payload); ++i)
+                    pair.server->sendMessage(MessageType::SERVER_TASK_ACCEPTED, requestId, payload);
+            });
+            const std::string payload(payloadSize, 'p');
+            MessageType type;
+            uint32_t requestId = 0;
+            std::string reply;
+            long long start = bench::nowNs();
+            for (long long i = 0; i < n; ++i)
+            {
+                pair.client->sendMessage(MessageType::CLIENT_ADD_TASK, static_cast<uint32_t>(i), payload);
+                pair.client->receiveMessage(type, requestId, reply);
+            }
+            long long elapsed = bench::nowNs() - start;
+            echo.join();
+            return elapsed;
+        };
+    }
+
+    // One-way stream: client sends back to back, server receives. An op is one
+    // message delivered.
+    Batch connectionStream(size_t payloadSize)
+    {
+        return [payloadSize](long long n) -> long long {
+            LoopbackPair pair;
+            if (!pair.open())
+                return -1;
+            long long start = bench::nowNs();
+            std::thread sender([&pair, payloadSize, n]() {
+                const std::string payload(payloadSize, 'p');
+                for (long long i = 0; i < n; ++i)
+                    pair.client->sendMessage(MessageType::CLIENT_ADD_TASK, static_cast<uint32_t>(i), payload);
+            });
+            MessageType type;
+            uint32_t requestId = 0;
+            std::string payload;
+            for (long long i = 0; i < n && pair.server->receiveMessage(type, requestId, payload); ++i)
+                gSink += static_cast<long long>(payload.size());
+            long long elapsed = bench::nowNs() - start;
+            sender.join();
+            return elapsed;
+        };
+    }
+
+    std::vector<Case> allCases()
+    {
+        std::vector<Case> cases;
+        for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing})
+        {
+            std::string name = backend == QueueBackend::Mutex ? "mutex" : "ring";
+            cases.push_back({"queue/" + name + "/enqueue+dequeue", queueRoundTrip(backend)});
+            for (int pairs : {1, 4})
+            {
+                cases.push_back({"queue/" + name + "/contended " + std::to_string(pairs) + "p" + std::to_string(pairs) + "c",
+                                 queueContended(backend, pairs)});
+            }
+        }
+        for (size_t payloadSize : {64, 1024, 16384})
+        {
+            for (WireFormat format : {WireFormat::Binary, WireFormat::Text})
+            {
+                std::string suffix = std::string(format == WireFormat::Binary ? "binary" : "text") + "/" +
+                                     std::to_string(payloadSize) + "B";
+                cases.push_back({"task/serialize " + suffix, taskEncode(payloadSize, format)});
+                cases.push_back({"task/deserialize " + suffix, taskDecode(payloadSize, format)});
+            }
+        }
+        cases.push_back({"logger/sync 1 thread", loggerLog(false, 1)});
+        cases.push_back({"logger/async 1 thread", loggerLog(true, 1)});
+        cases.push_back({"logger/async 4 threads", loggerLog(true, 4)});
+        cases.push_back({"logger/filtered", loggerFiltered()});
+        for (size_t payloadSize : {64, 4096})
+        {
+            cases.push_back({"connection/round trip " + std::to_string(payloadSize) + "B", connectionRoundTrip(payloadSize)});
+            cases.push_back({"connection/stream " + std::to_string(payloadSize) + "B", connectionStream(payloadSize)});
+        }
+        return cases;
+    }
+
+    std::map<std::string, double> loadBaseline(const std::string &path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t tab = line.rfind('\t');
+            if (tab != std::string::npos)
+                baseline[line.substr(0, tab)] = std::atof(line.c_str() + tab + 1);
+        }
+        return baseline;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string filter = bench::argString(argc, argv, "filter", "");
+    int reps = static_cast<int>(std::max(1LL, bench::argInt(argc, argv, "reps", 7)));
+    long long minNs = bench::argInt(argc, argv, "min-ms", 100) * 1000000LL;
+    std::string savePath = bench::argString(argc, argv, "save", "");
+    std::map<std::string, double> baseline = loadBaseline(bench::argString(argc, argv, "baseline", ""));
+
+    if (!Network::initialize())
+    {
+        std::cerr << "Failed to initialize network" << std::endl;
+        return 1;
+    }
+    // Log lines go to a scratch file only; the console copy is discarded
+    NullBuffer discard;
+    std::streambuf *stdoutBuffer = std::cout.rdbuf(&discard);
+    Logger::getInstance().setLogFile(bench::argString(argc, argv, "log-file", "bench_micro.log"));
+
+    std::ofstream save;
+    if (!savePath.empty())
+        save.open(savePath);
+
+    std::printf("%-38s %12s %14s %16s %8s\n", "case", "ns/op", "ops/s", "spread (min..max)", "vs base");
+    for (const Case &c : allCases())
+    {
+        if (c.name.find(filter) == std::string::npos)
+            continue;
+        // Queue logging is per task; keep it out of the queue numbers
+        bool quiet = c.name.compare(0, 6, "queue/") == 0;
+        Logger::getInstance().setMinLevel(quiet ? LogLevel::ERR : LogLevel::INFO);
+
+        std::vector<double> samples = bench::sampleNsPerOp(c.batch, minNs, reps);
+        if (samples.front() < 0)
+        {
+            std::printf("%-38s failed\n", c.name.c_str());
+            continue;
+        }
+        double median = samples[samples.size() / 2];
+        char spread[32];
+        std::snprintf(spread, sizeof(spread), "%.1f..%.1f", samples.front(), samples.back());
+        char delta[16] = "";
+        auto base = baseline.find(c.name);
+        if (base != baseline.end() && base->second > 0)
+            std::snprintf(delta, sizeof(delta), "%+.1f%%", (median / base->second - 1) * 100);
+        std::printf("%-38s %12.1f %14.0f %16s %8s\n", c.name.c_str(), median, 1e9 / median, spread, delta);
+        std::fflush(stdout);
+        if (save)
+            save << c.name << '\t' << median << '\n';
+    }
+
+    Logger::getInstance().setMinLevel(LogLevel::INFO);
+    std::cout.rdbuf(stdoutBuffer);
+    Network::cleanup();
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Mixed-priority scheduling benchmark. A producer submits a steady stream of
+// mostly bulk tasks (priority 0, long service time) with some interactive ones
+// (top priority, short service time, tight deadline) while consumers drain the
+// queue and "run" each task by spinning for its service time. Reports queueing
+// latency (enqueue to dequeue) per class, FIFO vs. the priority scheduler.
+//
+//   bench_priority [--tasks=20000] [--consumers=2] [--interactive-pct=10] [--load-pct=95]
+
+#include "BenchUtil.h"
+#include "Config.h"
+#include "Logger.h"
+#include "TaskQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    const long long kBulkServiceNs = 200000;      // 200us
+    const long long kInteractiveServiceNs = 20000; // 20us
+
+    void spinFor(long long ns)
+    {
+        long long until = bench::nowNs() + ns;
+        while (bench::nowNs() < until)
+        {
+        }
+    }
+
+    long long wallClockMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void run(QueueBackend backend, int tasks, int consumers, int interactivePct, int loadPct)
+    {
+        TaskQueue queue(backend, static_cast<size_t>(tasks));
+        std::vector<long long> enqueuedAt(tasks), dequeuedAt(tasks);
+        std::vector<bool> interactive(tasks);
+        std::mt19937 rng(42);
+        for (int i = 0; i < tasks; ++i)
+            interactive[i] = static_cast<int>(rng() % 100) < interactivePct;
+
+        // Arrival gap that keeps the consumers loadPct busy on average
+        double meanServiceNs = (interactivePct * kInteractiveServiceNs + (100 - interactivePct) * kBulkServiceNs) / 100.0;
+        long long gapNs = static_cast<long long>(meanServiceNs / consumers * 100.0 / loadPct);
+
+        std::atomic<int> consumed{0};
+        std::vector<std::thread> workers;
+        for (int c = 0; c < consumers; ++c)
+        {
+            workers.emplace_back([&]() {
+                while (consumed.load() < tasks)
+                {
+                    std::optional<Task> task = queue.dequeueFor(std::chrono::milliseconds(10));
+                    if (!task)
+                        continue;
+                    dequeuedAt[task->taskId] = bench::nowNs();
+                    spinFor(interactive[task->taskId] ? kInteractiveServiceNs : kBulkServiceNs);
+                    consumed.fetch_add(1);
+                }
+            });
+        }
+
+        long long next = bench::nowNs();
+        for (int i = 0; i < tasks; ++i)
+        {
+            while (bench::nowNs() < next)
+                std::this_thread::yield();
+            next += gapNs;
+
+            Task task;
+            task.taskId = i;
+            if (interactive[i])
+            {
+                task.priority = Config::PriorityLevels - 1;
+                task.deadlineMs = wallClockMs() + 50;
+            }
+            enqueuedAt[i] = bench::nowNs();
+            queue.enqueue(std::move(task));
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        std::vector<double> waitUs[2];
+        for (int i = 0; i < tasks; ++i)
+            waitUs[interactive[i] ? 1 : 0].push_back((dequeuedAt[i] - enqueuedAt[i]) / 1000.0);
+        const char *names[2] = {"bulk", "interactive"};
+        for (int cls = 1; cls >= 0; --cls)
+        {
+            std::vector<double> &w = waitUs[cls];
+            std::printf("%-10s %-12s %8zu %12.1f %12.1f\n", backend == QueueBackend::Priority ? "priority" : "fifo",
+                        names[cls], w.size(), bench::percentile(w, 50), bench::percentile(w, 99));
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int tasks = static_cast<int>(bench::argInt(argc, argv, "tasks", 20000));
+    int consumers = static_cast<int>(bench::argInt(argc, argv, "consumers", 2));
+    int interactivePct = static_cast<int>(bench::argInt(argc, argv, "interactive-pct", 10));
+    int loadPct = static_cast<int>(bench::argInt(argc, argv, "load-pct", 95));
+
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-10s %-12s %8s %12s %12s\n", "scheduler", "class", "tasks", "p50 wait(us)", "p99 wait(us)");
+    run(QueueBackend::Mutex, tasks, consumers, interactivePct, loadPct);
+    run(QueueBackend::Priority, tasks, consumers, interactivePct, loadPct);
+    return 0;
+}
@@ -0,0 +1,102 @@
+// TaskQueue contention benchmark: N producer and N consumer threads hammer one
+// queue, for N from 1 up to --max-threads, mutex backend vs. lock-free ring.
+// Queue logging is turned down to errors so the logger's own lock does not
+// dominate the measurement.
+//
+//   bench_queue [--tasks=200000] [--max-threads=64] [--payload=64]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "TaskQueue.h"
+
+#include <atomic>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    struct Result
+    {
+        double opsPerSec; // completed enqueue+dequeue pairs per second
+        double p99Ns;     // per-dequeue latency, including empty-queue retries
+    };
+
+    Result run(QueueBackend backend, int threads, long long tasks, size_t payloadSize)
+    {
+        TaskQueue queue(backend);
+        std::atomic<long long> consumed{0};
+        std::atomic<bool> go{false};
+        std::vector<std::vector<double>> latencies(threads);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                Task task;
+                task.payload.assign(payloadSize, 'p');
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (long long i = t; i < tasks; i += threads)
+                {
+                    task.taskId = static_cast<int>(i);
+                    while (!queue.enqueue(task)) // full: let consumers catch up
+                        std::this_thread::yield();
+                }
+            });
+            workers.emplace_back([&, t]() {
+                std::vector<double> &samples = latencies[t];
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                while (consumed.load(std::memory_order_relaxed) < tasks)
+                {
+                    long long start = bench::nowNs();
+                    std::optional<Task> task = queue.dequeue();
+                    if (!task)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    samples.push_back(static_cast<double>(bench::nowNs() - start));
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        long long start = bench::nowNs();
+        go.store(true, std::memory_order_release);
+        for (auto &worker : workers)
+            worker.join();
+        long long elapsed = bench::nowNs() - start;
+
+        std::vector<double> all;
+        for (auto &samples : latencies)
+            all.insert(all.end(), samples.begin(), samples.end());
+        return {tasks * 1e9 / elapsed, bench::percentile(all, 99)};
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long tasks = bench::argInt(argc, argv, "tasks", 200000);
+    int maxThreads = static_cast<int>(bench::argInt(argc, argv, "max-threads", 64));
+    size_t payloadSize = static_cast<size_t>(bench::argInt(argc, argv, "payload", 64));
+
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-8s %-8s %14s %12s\n", "threads", "backend", "tasks/s", "p99 deq(ns)");
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        for (QueueBackend backend : {QueueBackend::Mutex, QueueBackend::LockFreeRing})
+        {
+            Result r = run(backend, threads, tasks, payloadSize);
+            std::printf("%-8d %-8s %14.0f %12.0f\n", threads, backend == QueueBackend::Mutex ? "mutex" : "ring",
+                        r.opsPerSec, r.p99Ns);
+        }
+    }
+    return 0;
+}
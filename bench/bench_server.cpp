@@ -0,0 +1,122 @@
+// Connection-handling benchmark: the epoll reactor against the old
+// thread-per-connection accept loop, both serving the one-request-per-connection
+// CLIENT_ADD_TASK exchange over loopback.
+//
+//   bench_server [--clients=16] [--seconds=3] [--threads=4]
+
+#include "BenchUtil.h"
+#include "Network.h"
+#include "TcpServer.h"
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    class AcceptHandler : public SessionHandler
+    {
+    public:
+        void onMessage(const SessionPtr &session, MessageType /*type*/, uint32_t requestId, std::string &/*payload*/) override
+        {
+            session->send(MessageType::SERVER_TASK_ACCEPTED, requestId, "");
+            session->close();
+        }
+    };
+
+    struct Result
+    {
+        double connsPerSec;
+        double p50Us;
+        double p99Us;
+        long long failures;
+    };
+
+    Result runMode(ServerMode mode, int clients, int seconds, int threads)
+    {
+        TcpServer server(0, mode, threads);
+        if (!server.start([]() { return std::make_unique<AcceptHandler>(); }))
+        {
+            std::cerr << "server start failed: " << server.getLastError() << std::endl;
+            return Result{0, 0, 0, 0};
+        }
+        int port = server.boundPort();
+
+        std::atomic<bool> stop{false};
+        std::atomic<long long> failures{0};
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<std::thread> workers;
+        std::string payload(64, 'x');
+
+        for (int c = 0; c < clients; ++c)
+        {
+            workers.emplace_back([&, c]() {
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    long long start = bench::nowNs();
+                    Network::Connection conn("127.0.0.1", port);
+                    MessageType type;
+                    std::string reply;
+                    if (!conn.connect() || !conn.sendMessage(MessageType::CLIENT_ADD_TASK, payload) ||
+                        !conn.receiveMessage(type, reply))
+                    {
+                        failures++;
+                        continue;
+                    }
+                    conn.disconnect();
+                    latencies[c].push_back((bench::nowNs() - start) / 1000.0);
+                }
+            });
+        }
+
+        long long begin = bench::nowNs();
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop.store(true);
+        for (auto &t : workers)
+            t.join();
+        double elapsedSec = (bench::nowNs() - begin) / 1e9;
+        server.stop();
+
+        std::vector<double> all;
+        for (auto &l : latencies)
+            all.insert(all.end(), l.begin(), l.end());
+
+        Result r;
+        r.connsPerSec = all.size() / elapsedSec;
+        r.p50Us = bench::percentile(all, 50);
+        r.p99Us = bench::percentile(all, 99);
+        r.failures = failures.load();
+        return r;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int clients = static_cast<int>(bench::argInt(argc, argv, "clients", 16));
+    int seconds = static_cast<int>(bench::argInt(argc, argv, "seconds", 3));
+    int threads = static_cast<int>(bench::argInt(argc, argv, "threads", 4));
+
+    if (!Network::initialize())
+    {
+        std::cerr << "Network init failed" << std::endl;
+        return 1;
+    }
+
+    std::printf("%-22s %12s %10s %10s %9s\n", "mode", "conns/s", "p50(us)", "p99(us)", "failures");
+    std::vector<std::pair<const char *, ServerMode>> modes = {{"thread-per-connection", ServerMode::ThreadPerConnection}};
+#ifdef __linux__
+    modes.push_back({"epoll-event-loop", ServerMode::EventLoop});
+#endif
+    for (auto &m : modes)
+    {
+        Result r = runMode(m.second, clients, seconds, threads);
+        std::printf("%-22s %12.0f %10.1f %10.1f %9lld\n", m.first, r.connsPerSec, r.p50Us, r.p99Us, r.failures);
+    }
+
+    Network::cleanup();
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Sharded queue scaling benchmark: T threads each enqueue a batch to their home
+// shard and drain it again, against one shared TaskQueue and against a
+// ShardedTaskQueue with one shard per thread. Scaling is throughput relative
+// to the single-thread run of the same queue; linear scaling is T.
+//
+//   bench_sharded_queue [--tasks=400000] [--max-threads=32] [--batch=16] [--backend=ring|mutex]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "ShardedTaskQueue.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    // Every thread works against shard `home` of the queue it was given
+    double run(ShardedTaskQueue &queue, int threads, long long tasks, size_t batch)
+    {
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                size_t home = queue.shardFor(static_cast<uint64_t>(t));
+                Task task;
+                task.payload.assign(64, 'p');
+                std::vector<Task> out;
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (long long done = 0; done < tasks / threads;)
+                {
+                    out.assign(batch, task);
+                    size_t accepted = queue.enqueueBulk(home, std::move(out));
+                    size_t taken = 0;
+                    while (taken < accepted)
+                        taken += queue.dequeueBulk(home, accepted - taken).size();
+                    done += static_cast<long long>(taken);
+                }
+            });
+        }
+
+        long long start = bench::nowNs();
+        go.store(true, std::memory_order_release);
+        for (auto &worker : workers)
+            worker.join();
+        return tasks * 1e9 / (bench::nowNs() - start);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long tasks = bench::argInt(argc, argv, "tasks", 400000);
+    int maxThreads = static_cast<int>(bench::argInt(argc, argv, "max-threads", 32));
+    size_t batch = static_cast<size_t>(bench::argInt(argc, argv, "batch", 16));
+    QueueBackend backend = bench::argString(argc, argv, "backend", "ring") == "mutex" ? QueueBackend::Mutex
+                                                                                      : QueueBackend::LockFreeRing;
+
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-8s %14s %8s %14s %8s\n", "threads", "single tasks/s", "scaling", "sharded tasks/s", "scaling");
+    double singleBase = 0, shardedBase = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ShardedTaskQueue single(1, backend);
+        ShardedTaskQueue sharded(static_cast<size_t>(threads), backend);
+        double singleRate = run(single, threads, tasks, batch);
+        double shardedRate = run(sharded, threads, tasks, batch);
+        if (threads == 1)
+        {
+            singleBase = singleRate;
+            shardedBase = shardedRate;
+        }
+        std::printf("%-8d %14.0f %8.2f %14.0f %8.2f\n", threads, singleRate, singleRate / singleBase,
+                    shardedRate, shardedRate / shardedBase);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Task wire-format microbenchmark: legacy text vs. binary encoding, and binary
+// decoding into an owning Task vs. a zero-copy TaskView.
+//
+//   bench_task_codec [--iterations=200000]
+
+#include "AllocCounter.h"
+#include "BenchUtil.h"
+#include "Task.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace dtq;
+
+namespace
+{
+    volatile long long gSink = 0;
+
+    template <typename Fn>
+    void measure(const char *name, size_t payloadSize, long long iterations, Fn &&fn)
+    {
+        for (long long i = 0; i < iterations / 10; ++i)
+            fn(); // warm-up
+
+        long long allocsBefore = bench::allocations();
+        long long start = bench::nowNs();
+        for (long long i = 0; i < iterations; ++i)
+            fn();
+        long long elapsed = bench::nowNs() - start;
+        long long allocs = bench::allocations() - allocsBefore;
+
+        std::printf("%-26s %8zu %12.1f %14.2f\n", name, payloadSize,
+                    static_cast<double>(elapsed) / iterations, static_cast<double>(allocs) / iterations);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long iterations = bench::argInt(argc, argv, "iterations", 200000);
+
+    std::printf("%-26s %8s %12s %14s\n", "case", "payload", "ns/task", "allocs/task");
+    for (size_t payloadSize : {16, 256, 4096, 65536})
+    {
+        Task task;
+        task.taskId = 12345;
+        task.payload.assign(payloadSize, 'p');
+        task.status = TaskStatus::PENDING;
+        task.result = "Processed by Worker 1 in 750ms";
+        task.retryCount = 1;
+        task.enqueueTimeMs = 1712650000000LL;
+
+        const std::string text = task.serialize(WireFormat::Text);
+        const std::string binary = task.serialize(WireFormat::Binary);
+        std::string scratch;
+
+        measure("encode text", payloadSize, iterations, [&]() {
+            gSink += task.serialize(WireFormat::Text).size();
+        });
+        measure("encode binary", payloadSize, iterations, [&]() {
+            gSink += task.serialize(WireFormat::Binary).size();
+        });
+        measure("encode binary (reused)", payloadSize, iterations, [&]() {
+            scratch.clear();
+            task.serializeTo(scratch, WireFormat::Binary);
+            gSink += scratch.size();
+        });
+        measure("decode text -> Task", payloadSize, iterations, [&]() {
+            gSink += Task::deserialize(text).taskId;
+        });
+        measure("decode binary -> Task", payloadSize, iterations, [&]() {
+            gSink += Task::deserialize(binary).taskId;
+        });
+        measure("decode binary -> TaskView", payloadSize, iterations, [&]() {
+            TaskView view;
+            Task::decode(binary, view);
+            gSink += view.taskId + static_cast<long long>(view.payload.size());
+        });
+    }
+    return 0;
+}
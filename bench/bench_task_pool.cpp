@@ -0,0 +1,130 @@
+// Allocations and time per task along the server's hot path: decode a
+// submitted batch, enqueue it, dequeue it, lease each task and settle its
+// result. "copy" builds every Task afresh and copies it into its lease, as
+// the server used to; "pooled" decodes into TaskPool tasks, moves them into
+// their leases and hands them back to the pool once their results are in.
+// Both reuse the lease and store map nodes.
+//
+//   bench_task_pool [--rounds=20000] [--batch=64] [--payload=256]
+
+#include "AllocCounter.h"
+#include "BenchUtil.h"
+#include "LeaseTable.h"
+#include "Logger.h"
+#include "Task.h"
+#include "TaskPool.h"
+#include "TaskQueue.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    const char *backendName(QueueBackend backend)
+    {
+        switch (backend)
+        {
+        case QueueBackend::Mutex:
+            return "mutex";
+        case QueueBackend::LockFreeRing:
+            return "ring";
+        case QueueBackend::Priority:
+            return "priority";
+        }
+        return "?";
+    }
+
+    void run(QueueBackend backend, bool pooled, long long rounds, size_t batch, size_t payloadSize)
+    {
+        // A small result budget keeps the store evicting, as a long-running server does
+        TaskQueue queue(backend, batch * 4, std::make_shared<TaskStore>(16, 64 * 1024, Config::ResultTtl));
+        LeaseTable leases(std::chrono::seconds(30), 0);
+        TaskPool pool;
+
+        std::vector<Task> submitted(batch);
+        for (Task &task : submitted)
+        {
+            task.payload.assign(payloadSize, 'p');
+        }
+        const std::string encoded = Task::serializeBatch(submitted);
+        const std::string result = "Processed by Worker 1 in 750ms";
+
+        std::vector<TaskView> views;
+        std::vector<Task> tasks;
+        tasks.reserve(batch);
+        int nextId = 1;
+        size_t queuedBytes = 0;
+        auto round = [&](int64_t nowMs) {
+            views.clear();
+            Task::decodeBatch(encoded, views);
+            tasks.clear();
+            for (TaskView &view : views)
+            {
+                view.taskId = nextId++;
+                tasks.push_back(pooled ? pool.acquire(view) : Task::fromView(view));
+            }
+            queue.enqueueBulk(std::move(tasks));
+            queuedBytes = queue.bytesQueued();
+            std::vector<Task> taken = queue.dequeueBulk(batch);
+            for (Task &task : taken)
+            {
+                int taskId = task.taskId;
+                if (pooled)
+                {
+                    leases.grant(std::move(task), nowMs);
+                }
+                else
+                {
+                    leases.grant(task, nowMs);
+                }
+                queue.updateTaskResult(taskId, result, TaskStatus::COMPLETED);
+                if (pooled)
+                {
+                    std::optional<Task> leased = leases.revoke(taskId);
+                    pool.release(std::move(*leased));
+                }
+                else
+                {
+                    leases.release(taskId);
+                }
+            }
+        };
+
+        // Warm-up fills the pool, the spare nodes and the store's budget
+        for (long long i = 0; i < rounds / 10 + 100; ++i)
+            round(i);
+
+        long long allocsBefore = bench::allocations();
+        long long start = bench::nowNs();
+        for (long long i = 0; i < rounds; ++i)
+            round(i);
+        long long elapsed = bench::nowNs() - start;
+        long long allocs = bench::allocations() - allocsBefore;
+
+        double perTask = static_cast<double>(rounds) * static_cast<double>(batch);
+        std::printf("%-8s %-9s %8zu %12.1f %14.3f %14zu\n", pooled ? "pooled" : "copy", backendName(backend),
+                    payloadSize, static_cast<double>(elapsed) / perTask, static_cast<double>(allocs) / perTask,
+                    queuedBytes / batch);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    long long rounds = bench::argInt(argc, argv, "rounds", 20000);
+    size_t batch = static_cast<size_t>(bench::argInt(argc, argv, "batch", 64));
+    size_t payloadSize = static_cast<size_t>(bench::argInt(argc, argv, "payload", 256));
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-8s %-9s %8s %12s %14s %14s\n", "path", "backend", "payload", "ns/task", "allocs/task",
+                "bytes/queued");
+    for (QueueBackend backend : {QueueBackend::LockFreeRing, QueueBackend::Mutex, QueueBackend::Priority})
+    {
+        run(backend, false, rounds, batch, payloadSize);
+        run(backend, true, rounds, batch, payloadSize);
+    }
+    return 0;
+}
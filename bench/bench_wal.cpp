@@ -0,0 +1,145 @@
+// Write-ahead log benchmark.
+//  1. Throughput: C connections each submit tasks and wait for their
+//     acknowledgment, as the server does: without a WAL, with a WAL and no
+//     commit window (each fsync takes whoever is waiting), and with the
+//     group-commit window. Reports tasks/s and tasks per fsync.
+//  2. Recovery: writes a log of N records (every 10th task left live, the rest
+//     completed) and times replay.
+//
+//   bench_wal [--dir=.] [--tasks=20000] [--max-conns=64] [--window-us=200] [--recovery-entries=10000000]
+
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "TaskQueue.h"
+#include "WriteAheadLog.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    struct Result
+    {
+        double tasksPerSec;
+        double tasksPerSync;
+    };
+
+    Result runThroughput(const std::string &path, int conns, long long tasks, long long windowUs)
+    {
+        std::remove(path.c_str());
+        TaskQueue queue(QueueBackend::LockFreeRing, static_cast<size_t>(tasks));
+        std::unique_ptr<WriteAheadLog> wal;
+        if (windowUs >= 0)
+        {
+            wal = std::make_unique<WriteAheadLog>(std::chrono::microseconds(windowUs));
+            WriteAheadLog::Recovered recovered;
+            if (!wal->open(path, recovered))
+            {
+                std::fprintf(stderr, "%s\n", wal->getLastError().c_str());
+                return {0, 0};
+            }
+        }
+
+        std::vector<std::thread> threads;
+        long long start = bench::nowNs();
+        for (int c = 0; c < conns; ++c)
+        {
+            threads.emplace_back([&, c]() {
+                Task task;
+                task.payload.assign(64, 'p');
+                for (long long i = c; i < tasks; i += conns)
+                {
+                    task.taskId = static_cast<int>(i);
+                    uint64_t lsn = wal ? wal->logEnqueue(task) : 0;
+                    queue.enqueue(task);
+                    if (wal)
+                        wal->waitDurable(lsn); // the client's ack waits for this
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        double seconds = (bench::nowNs() - start) / 1e9;
+
+        double syncs = wal ? static_cast<double>(wal->syncCount()) : 0;
+        if (wal)
+            wal->close();
+        std::remove(path.c_str());
+        return {tasks / seconds, syncs > 0 ? tasks / syncs : 0};
+    }
+
+    void runRecovery(const std::string &path, long long entries)
+    {
+        std::remove(path.c_str());
+        {
+            WriteAheadLog wal(std::chrono::microseconds(100000));
+            WriteAheadLog::Recovered none;
+            if (!wal.open(path, none))
+            {
+                std::fprintf(stderr, "%s\n", wal.getLastError().c_str());
+                return;
+            }
+            Task task;
+            task.payload.assign(32, 'p');
+            long long written = 0;
+            for (int id = 0; written < entries; ++id)
+            {
+                task.taskId = id;
+                wal.logEnqueue(task);
+                ++written;
+                if (id % 10 != 0 && written < entries)
+                {
+                    wal.logComplete(id, TaskStatus::COMPLETED, "ok");
+                    ++written;
+                }
+            }
+        } // close() flushes
+
+        long long start = bench::nowNs();
+        WriteAheadLog::Recovered recovered;
+        std::string error;
+        if (!WriteAheadLog::replay(path, recovered, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return;
+        }
+        double seconds = (bench::nowNs() - start) / 1e9;
+        std::printf("recovery: %zu records, %zu live tasks in %.2fs (%.0f records/s)\n", recovered.records,
+                    recovered.pending.size(), seconds, recovered.records / seconds);
+        std::remove(path.c_str());
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string path = bench::argString(argc, argv, "dir", ".") + "/bench_wal.wal";
+    long long tasks = bench::argInt(argc, argv, "tasks", 20000);
+    int maxConns = static_cast<int>(bench::argInt(argc, argv, "max-conns", 64));
+    long long windowUs = bench::argInt(argc, argv, "window-us", 200);
+    long long recoveryEntries = bench::argInt(argc, argv, "recovery-entries", 10000000);
+
+    Logger::getInstance().setMinLevel(LogLevel::ERR);
+
+    std::printf("%-6s %-18s %12s %12s\n", "conns", "mode", "tasks/s", "tasks/fsync");
+    for (int conns = 1; conns <= maxConns; conns *= 4)
+    {
+        struct Mode
+        {
+            const char *name;
+            long long windowUs; // -1: no WAL
+        } modes[] = {{"in-memory", -1}, {"wal, no window", 0}, {"wal, group commit", windowUs}};
+        for (const Mode &mode : modes)
+        {
+            Result r = runThroughput(path, conns, tasks, mode.windowUs);
+            std::printf("%-6d %-18s %12.0f %12.1f\n", conns, mode.name, r.tasksPerSec, r.tasksPerSync);
+        }
+    }
+
+    runRecovery(path, recoveryEntries);
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Worker pipelining benchmark. Tasks are "run" by sleeping for their service
+// time and every server round trip is a sleep of --rtt-us, so the numbers show
+// how much of each compute thread's time is spent waiting on the network.
+//
+//   serialized: each thread polls a batch, then runs and submits its tasks one
+//               by one, a round trip per result (the worker before WorkerPool)
+//   pipelined:  WorkerPool threads only compute; one I/O thread keeps
+//               --prefetch tasks queued and one submitter sends each batch of
+//               results in a single pipelined round trip
+//
+// Utilization is time spent running tasks over threads x elapsed time.
+//
+//   bench_worker_pool [--tasks=4000] [--threads=4] [--task-us=200] [--rtt-us=500]
+//                     [--batch=8] [--prefetch=16]
+
+#include "BenchUtil.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    struct Options
+    {
+        long long tasks;
+        int threads;
+        long long taskUs;
+        long long rttUs;
+        int batch;
+        int prefetch;
+    };
+
+    struct Result
+    {
+        double tasksPerSec;
+        double utilization;
+    };
+
+    void roundTrip(const Options &options)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(options.rttUs));
+    }
+
+    void runTask(Task &task, const Options &options)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(options.taskUs));
+        task.status = TaskStatus::COMPLETED;
+    }
+
+    Result serialized(const Options &options)
+    {
+        std::atomic<long long> remaining{options.tasks};
+        std::atomic<long long> busyNs{0};
+        long long start = bench::nowNs();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < options.threads; ++t)
+        {
+            threads.emplace_back([&]() {
+                for (;;)
+                {
+                    long long taken = std::min<long long>(options.batch, remaining.fetch_sub(options.batch));
+                    if (taken <= 0)
+                        return;
+                    roundTrip(options); // poll
+                    for (long long i = 0; i < taken; ++i)
+                    {
+                        Task task;
+                        long long begin = bench::nowNs();
+                        runTask(task, options);
+                        busyNs.fetch_add(bench::nowNs() - begin);
+                        roundTrip(options); // submit and wait for the confirmation
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        double elapsedNs = static_cast<double>(bench::nowNs() - start);
+        return {options.tasks / (elapsedNs / 1e9), busyNs.load() / (elapsedNs * options.threads)};
+    }
+
+    Result pipelined(const Options &options)
+    {
+        WorkerPool pool(static_cast<size_t>(options.threads), [&](Task &task, int) { runTask(task, options); });
+        long long start = bench::nowNs();
+
+        std::thread fetcher([&]() {
+            long long fetched = 0;
+            while (fetched < options.tasks)
+            {
+                pool.waitForRoom(static_cast<size_t>(options.prefetch), std::chrono::milliseconds(100));
+                size_t room = static_cast<size_t>(options.prefetch) - std::min(pool.queued(), static_cast<size_t>(options.prefetch));
+                long long count = std::min<long long>({static_cast<long long>(std::max<size_t>(room, 1)), options.batch,
+                                                       options.tasks - fetched});
+                roundTrip(options); // poll
+                std::vector<Task> tasks(static_cast<size_t>(count));
+                for (Task &task : tasks)
+                    task.taskId = static_cast<int>(fetched++);
+                pool.submit(std::move(tasks));
+            }
+        });
+
+        long long submitted = 0;
+        while (submitted < options.tasks)
+        {
+            std::vector<Task> results = pool.takeResults(std::chrono::milliseconds(100));
+            if (results.empty())
+                continue;
+            roundTrip(options); // every result of the batch in flight at once
+            submitted += static_cast<long long>(results.size());
+        }
+        double elapsedNs = static_cast<double>(bench::nowNs() - start);
+        fetcher.join();
+        pool.stop();
+        return {options.tasks / (elapsedNs / 1e9), pool.busyUs() * 1000.0 / (elapsedNs * options.threads)};
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    options.tasks = bench::argInt(argc, argv, "tasks", 4000);
+    options.threads = static_cast<int>(bench::argInt(argc, argv, "threads", 4));
+    options.taskUs = bench::argInt(argc, argv, "task-us", 200);
+    options.rttUs = bench::argInt(argc, argv, "rtt-us", 500);
+    options.batch = static_cast<int>(bench::argInt(argc, argv, "batch", 8));
+    options.prefetch = static_cast<int>(bench::argInt(argc, argv, "prefetch", 16));
+
+    std::printf("%lld tasks of %lldus, %d threads, %lldus round trips, batch %d, prefetch %d\n", options.tasks,
+                options.taskUs, options.threads, options.rttUs, options.batch, options.prefetch);
+    std::printf("%-12s %12s %12s\n", "mode", "tasks/s", "utilization");
+    Result before = serialized(options);
+    std::printf("%-12s %12.0f %11.1f%%\n", "serialized", before.tasksPerSec, before.utilization * 100);
+    Result after = pipelined(options);
+    std::printf("%-12s %12.0f %11.1f%%\n", "pipelined", after.tasksPerSec, after.utilization * 100);
+    return 0;
+}
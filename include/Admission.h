@@ -0,0 +1,60 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace dtq
+{
+
+    // How long a client turned away by an overloaded queue should wait: the
+    // time the queue needs at drainPerSec to get from depth back down to
+    // targetDepth, clamped to [Config::RetryAfterMin, Config::RetryAfterMax].
+    // With nothing draining it is the maximum.
+    uint32_t retryAfterMs(size_t depth, size_t targetDepth, double drainPerSec);
+
+    // SERVER_TASK_REJECTED payload: u32 retry-after ms, then the reason. A
+    // retry-after of 0 means resending the same request will not help.
+    std::string encodeRejection(uint32_t retryAfterMs, std::string_view reason);
+    bool decodeRejection(std::string_view payload, uint32_t &retryAfterMs, std::string &reason);
+
+    // Client-side submission rate with additive increase and multiplicative
+    // decrease. Accepted tasks raise the rate by increasePerSec for every
+    // second's worth of them; a rejection cuts it by decreaseFactor, at most
+    // once per retry-after, and pauses sending until the retry-after passes.
+    // Sending is paced by a token bucket holding up to 100ms of tokens. Not
+    // thread-safe: one submitting thread owns it.
+    class AimdRate
+    {
+    public:
+        AimdRate(double initialPerSec, double minPerSec, double maxPerSec, double increasePerSec,
+                 double decreaseFactor = 0.5);
+
+        // Tasks that may be sent now; take() the ones actually sent
+        size_t available(int64_t nowUs);
+        void take(size_t n);
+        void onAccepted(size_t n);
+        void onRejected(uint32_t retryAfterMs, int64_t nowUs);
+
+        double perSecond() const { return rate; }
+        // Time at which available() may next be nonzero
+        int64_t nextSendUs() const;
+
+    private:
+        double rate;
+        double minRate;
+        double maxRate;
+        double increase;
+        double decrease;
+        double tokens = 1.0;
+        int64_t lastRefillUs = 0;
+        int64_t pausedUntilUs = 0;
+        int64_t lastDecreaseUs = 0;
+        int64_t decreaseHoldUs = 0;
+    };
+
+} // namespace dtq
+
+#endif // ADMISSION_H
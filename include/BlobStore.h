@@ -0,0 +1,142 @@
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dtq
+{
+
+    // One memory-mapped segment file of a BlobStore. The file is unlinked as
+    // soon as it is created, so its disk space is returned when the last
+    // BlobRef into it goes away, and nothing is left behind after a crash.
+    class BlobSegment
+    {
+    public:
+        BlobSegment(int fd, char *data, size_t capacity, std::shared_ptr<std::atomic<uint64_t>> liveBytes)
+            : fileFd(fd), mapped(data), mappedBytes(capacity), liveBytes(std::move(liveBytes)) {}
+        ~BlobSegment();
+        BlobSegment(const BlobSegment &) = delete;
+        BlobSegment &operator=(const BlobSegment &) = delete;
+
+        int fd() const { return fileFd; }
+        const char *data() const { return mapped; }
+        char *data() { return mapped; }
+        size_t capacity() const { return mappedBytes; }
+
+    private:
+        int fileFd;
+        char *mapped;
+        size_t mappedBytes;
+        std::shared_ptr<std::atomic<uint64_t>> liveBytes;
+    };
+
+    // A blob's bytes inside a segment. Copies share the segment, which stays
+    // mapped while any of them is alive; an empty ref (size 0) holds nothing.
+    struct BlobRef
+    {
+        std::shared_ptr<BlobSegment> segment;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+
+        bool empty() const { return size == 0; }
+        std::string_view view() const
+        {
+            return segment ? std::string_view(segment->data() + offset, size) : std::string_view();
+        }
+    };
+
+    // A message payload of in-memory bytes with blobs spliced in, so a
+    // transport can send the blobs straight from their files (sendfile)
+    // instead of copying them into its output buffer.
+    struct SplicedPayload
+    {
+        struct Splice
+        {
+            size_t at; // the blob goes before bytes[at]
+            BlobRef blob;
+        };
+
+        std::string bytes;
+        std::vector<Splice> splices;
+
+        void appendBlob(BlobRef blob)
+        {
+            if (!blob.empty())
+            {
+                splices.push_back({bytes.size(), std::move(blob)});
+            }
+        }
+
+        size_t size() const
+        {
+            size_t total = bytes.size();
+            for (const Splice &splice : splices)
+            {
+                total += splice.blob.size;
+            }
+            return total;
+        }
+
+        // The whole payload in one string, for transports that cannot splice
+        std::string flatten() const
+        {
+            std::string out;
+            out.reserve(size());
+            size_t from = 0;
+            for (const Splice &splice : splices)
+            {
+                out.append(bytes, from, splice.at - from);
+                out.append(splice.blob.view());
+                from = splice.at;
+            }
+            out.append(bytes, from, std::string::npos);
+            return out;
+        }
+    };
+
+    // Server-side store for large task payloads and results, so they are not
+    // held on the heap while queued. Blobs are appended to memory-mapped
+    // segment files of Config::BlobSegmentBytes in dir (a blob larger than
+    // that gets a segment of its own); a segment's file is freed once the
+    // store has moved past it and no BlobRef into it is left. Mapped file
+    // pages are page cache, which the kernel can write back and reclaim under
+    // memory pressure. Thread-safe. POSIX only: open() fails on Windows.
+    class BlobStore
+    {
+    public:
+        explicit BlobStore(std::string dir, size_t segmentBytes = 0);
+
+        // Checks that segment files can be created in dir
+        bool open();
+        // Copies bytes into the store; an empty ref if they could not be stored
+        BlobRef put(std::string_view bytes);
+
+        // Total size of the live segments; their files are sparse, so disk use
+        // is closer to the bytes actually put
+        uint64_t bytesStored() const { return liveBytes->load(std::memory_order_relaxed); }
+        const std::string &getLastError() const { return lastError; }
+
+    private:
+        std::shared_ptr<BlobSegment> createSegment(size_t capacity);
+
+        std::string directory;
+        size_t segmentBytes;
+        std::mutex mutex;
+        std::shared_ptr<BlobSegment> current; // segment put() appends to
+        size_t used = 0;                      // bytes of current handed out
+        uint64_t nextSegment = 0;
+        std::shared_ptr<std::atomic<uint64_t>> liveBytes = std::make_shared<std::atomic<uint64_t>>(0);
+        std::string lastError;
+    };
+
+} // namespace dtq
+
+#endif // BLOBSTORE_H
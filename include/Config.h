@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include <chrono>
+#include <cstddef>
 #include <string>
 
 namespace dtq
@@ -12,10 +13,32 @@ namespace dtq
     {
     public:
         static const int MaxQueueSize;
+        static const std::chrono::milliseconds QueueLatencyInterval;
+        static const std::chrono::milliseconds RetryAfterMin;
+        static const std::chrono::milliseconds RetryAfterMax;
         static const int ThreadPoolSize;
         static const std::chrono::milliseconds NetworkTimeout;
+        static const size_t MaxFrameBytes;
         static const int TaskRetryLimit;
+        static const std::chrono::milliseconds LeaseTimeout;
+        static const std::chrono::milliseconds RetryBackoffBase;
+        static const std::chrono::milliseconds RetryBackoffMax;
+        static const size_t DeadLetterCapacity;
         static const std::chrono::milliseconds HeartbeatInterval;
+        static const int HeartbeatMissLimit;
+        static const int BatchSize;
+        static const int WorkerPrefetch;
+        static const size_t TaskPoolCapacity;
+        static const size_t BlobThresholdBytes;
+        static const size_t BlobSegmentBytes;
+        static const std::chrono::milliseconds LongPollTimeout;
+        static const int PriorityLevels;
+        static const std::chrono::milliseconds PriorityAgingInterval;
+        static const std::chrono::milliseconds DefaultTaskDeadline;
+        static const size_t ResultStoreBudgetBytes;
+        static const std::chrono::milliseconds ResultTtl;
+        static const std::chrono::microseconds WalCommitWindow;
+        static const size_t MaxDelayedTasks;
 
         static bool loadConfig(const std::string &filename);
     };
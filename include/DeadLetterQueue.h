@@ -0,0 +1,53 @@
+#ifndef DEADLETTERQUEUE_H
+#define DEADLETTERQUEUE_H
+
+#include "Task.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // Delay before retry number `retry` (1 for the first): Config::RetryBackoffBase
+    // doubled for every earlier retry, capped at Config::RetryBackoffMax, of
+    // which the upper half is scaled by jitter in [0, 1) so tasks that failed
+    // together do not all come back at once.
+    int64_t retryBackoffMs(int retry, double jitter);
+
+    // Tasks that used up their retries, kept for inspection and manual requeue.
+    // Bounded: once full, the oldest entry is dropped to make room. Not
+    // durable; the task store keeps each task's FAILED status and last error.
+    class DeadLetterQueue
+    {
+    public:
+        // 0 means Config::DeadLetterCapacity
+        explicit DeadLetterQueue(size_t capacity = 0);
+
+        // A task already present is replaced. Returns false if an older
+        // entry had to be dropped.
+        bool add(Task &&task);
+        // Copies of up to max entries (0 for all), oldest first
+        std::vector<Task> list(size_t max);
+        // Removes and returns the listed tasks that are present, oldest first;
+        // an empty list takes everything
+        std::vector<Task> take(const std::vector<int> &taskIds);
+
+        size_t size();
+        uint64_t dropped();
+        size_t capacity() const { return maxSize; }
+
+    private:
+        size_t maxSize;
+        std::mutex mutex;
+        std::list<Task> entries; // oldest first
+        std::unordered_map<int, std::list<Task>::iterator> byId;
+        uint64_t droppedCount = 0;
+    };
+
+} // namespace dtq
+
+#endif // DEADLETTERQUEUE_H
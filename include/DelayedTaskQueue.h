@@ -0,0 +1,47 @@
+#ifndef DELAYEDTASKQUEUE_H
+#define DELAYEDTASKQUEUE_H
+
+#include "Task.h"
+#include "TimingWheel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace dtq
+{
+
+    // Tasks submitted with a not-before time, held outside the ready queue
+    // until they come due. Tasks sit in one slab indexed by a TimingWheel, so
+    // holding one costs a Task and a wheel node, scheduling is O(1), and
+    // takeDue() hands back everything due in one batch for a bulk enqueue.
+    // Nothing runs per task; a caller polls takeDue() once per tick.
+    class DelayedTaskQueue
+    {
+    public:
+        // Times are milliseconds on the caller's monotonic clock, starting at
+        // nowMs. capacity 0 means Config::MaxDelayedTasks.
+        DelayedTaskQueue(int64_t nowMs, size_t capacity = 0,
+                         std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+
+        // Holds the task until dueMs; false (task untouched) when full
+        bool schedule(Task &&task, int64_t dueMs);
+        // Removes every task due by nowMs, earliest tick first
+        std::vector<Task> takeDue(int64_t nowMs);
+
+        size_t size();
+        size_t capacity() const { return maxSize; }
+
+    private:
+        size_t maxSize;
+        std::mutex mutex;
+        TimingWheel wheel;
+        std::vector<Task> slots; // wheel keys index this
+        std::vector<uint32_t> freeSlots;
+        std::vector<uint64_t> dueKeys; // scratch for takeDue()
+    };
+
+} // namespace dtq
+
+#endif // DELAYEDTASKQUEUE_H
@@ -0,0 +1,71 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // A single-threaded epoll reactor. All fd callbacks run on the thread that
+    // calls run(); other threads hand work over with post().
+    class EventLoop
+    {
+    public:
+        using IoCallback = std::function<void(uint32_t events)>;
+
+        EventLoop();
+        ~EventLoop();
+        EventLoop(const EventLoop &) = delete;
+        EventLoop &operator=(const EventLoop &) = delete;
+
+        bool valid() const { return epollFd >= 0 && wakeFd >= 0; }
+
+        // Register / update / drop interest in a file descriptor. Loop thread only.
+        bool add(int fd, uint32_t events, IoCallback callback);
+        bool modify(int fd, uint32_t events);
+        void remove(int fd);
+
+        // Queue a function to run on the loop thread (thread-safe).
+        void post(std::function<void()> fn);
+
+        void run();
+        void stop();
+        bool isInLoopThread() const { return std::this_thread::get_id() == loopThread.load(); }
+
+    private:
+        struct Channel
+        {
+            int fd;
+            IoCallback callback;
+            bool removed;
+        };
+
+        void wake();
+        void runPosted();
+
+        int epollFd;
+        int wakeFd;
+        std::atomic<bool> running{false};
+        std::atomic<std::thread::id> loopThread;
+        std::unordered_map<int, std::unique_ptr<Channel>> channels;
+        // Channels removed while dispatching a batch stay alive until the batch ends
+        std::vector<std::unique_ptr<Channel>> retired;
+
+        std::mutex postMutex;
+        std::vector<std::function<void()>> posted;
+    };
+
+} // namespace dtq
+
+#endif // __linux__
+
+#endif // EVENTLOOP_H
@@ -0,0 +1,65 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dtq
+{
+
+    // Lock-free log-linear histogram in the style of HdrHistogram. Values below
+    // 64 get a bucket each; above that every power of two is split into 32
+    // buckets, so a reported percentile is at most ~3% above the true value.
+    // record() is one relaxed atomic add per counter and never allocates.
+    class Histogram
+    {
+    public:
+        static constexpr int kSubBucketBits = 5;
+        static constexpr int kMaxExponent = 40; // ~12.7 days in microseconds
+        static constexpr size_t kBuckets = static_cast<size_t>(kMaxExponent - kSubBucketBits + 1) << kSubBucketBits;
+
+        // Copy of the counters; concurrent records may or may not be included
+        struct Snapshot
+        {
+            std::vector<uint64_t> counts;
+            uint64_t total = 0;
+            int64_t sum = 0;
+
+            // Smallest bucket bound with at least p percent of values at or below it
+            int64_t percentile(double p) const;
+            int64_t max() const;
+            double mean() const;
+            // Values recorded between earlier and this snapshot
+            Snapshot since(const Snapshot &earlier) const;
+            void merge(const Snapshot &other);
+        };
+
+        Histogram() = default;
+        Histogram(const Histogram &) = delete;
+        Histogram &operator=(const Histogram &) = delete;
+
+        // Negative values count as 0; values past the range land in the last bucket
+        void record(int64_t value)
+        {
+            uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+            counts[bucketFor(v)].fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(static_cast<int64_t>(v), std::memory_order_relaxed);
+        }
+
+        Snapshot snapshot() const;
+
+        static size_t bucketFor(uint64_t value);
+        // Largest value that maps to bucket
+        static uint64_t upperBound(size_t bucket);
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+        std::atomic<int64_t> sum{0};
+    };
+
+} // namespace dtq
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,77 @@
+#ifndef LEASETABLE_H
+#define LEASETABLE_H
+
+#include "Task.h"
+#include "TimingWheel.h"
+#include "MapNodeCache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // Tasks handed to workers, each held under a lease with a visibility
+    // timeout. A lease ends when the worker's result arrives (release) or when
+    // it runs out, in which case expire() returns the task for redelivery.
+    // Deadlines are kept in a TimingWheel, so granting, releasing and expiring
+    // a lease cost O(1) however many are outstanding. Each lease records its
+    // holder (the server passes the worker's session id), so a worker whose
+    // lease expired cannot end the lease of the one the task went to next.
+    class LeaseTable
+    {
+    public:
+        // Times are milliseconds on the caller's monotonic clock, starting at nowMs
+        LeaseTable(std::chrono::milliseconds timeout, int64_t nowMs,
+                   std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+
+        // Starts the lease for owner, or restarts it (passing it to owner) if
+        // the task already holds one. The table keeps the task until the
+        // lease ends; pass it as an rvalue to avoid copying its payload.
+        void grant(const Task &task, int64_t nowMs, uint64_t owner = 0);
+        void grant(Task &&task, int64_t nowMs, uint64_t owner = 0);
+        // False if the task holds no lease (never granted, released or expired)
+        bool release(int taskId);
+        // Ends the lease early and returns its task, e.g. when its worker is
+        // known to be gone; nullopt if the task holds no lease
+        std::optional<Task> revoke(int taskId);
+        // As revoke(taskId), but only if owner holds the lease; nullopt,
+        // leaving the lease alone, if another owner does
+        std::optional<Task> revoke(int taskId, uint64_t owner);
+        // Removes and returns every task whose lease ran out by nowMs
+        std::vector<Task> expire(int64_t nowMs);
+
+        size_t size();
+        std::chrono::milliseconds timeout() const { return leaseTimeout; }
+
+    private:
+        struct Lease
+        {
+            Task task;
+            TimingWheel::TimerId timer = 0;
+            uint64_t owner = 0;
+        };
+        using LeaseMap = std::unordered_map<int, Lease>;
+
+        // Ended leases whose map nodes are kept for the next grants
+        static constexpr size_t kSpareLeases = 1024;
+
+        template <typename T>
+        void put(T &&task, int64_t nowMs, uint64_t owner);
+        std::optional<Task> take(LeaseMap::iterator it);
+
+        std::chrono::milliseconds leaseTimeout;
+        std::mutex mutex;
+        TimingWheel wheel;
+        LeaseMap leases;
+        MapNodeCache<LeaseMap> spareLeases;
+        std::vector<uint64_t> expiredKeys; // scratch for expire()
+    };
+
+} // namespace dtq
+
+#endif // LEASETABLE_H
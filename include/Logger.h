@@ -1,9 +1,28 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <fstream>
 #include <mutex>
+#include <thread>
+
+// Levels below this are compiled out of DTQ_LOG call sites (0 = INFO, 1 = WARN, 2 = ERR)
+#ifndef DTQ_MIN_LOG_LEVEL
+#define DTQ_MIN_LOG_LEVEL 0
+#endif
+
+// Logs through Logger::getInstance(), but only builds the message if the level
+// is enabled, both at compile time and at run time. Usage: DTQ_LOG(INFO, "x=" + s)
+#define DTQ_LOG(level, ...)                                                                  \
+    do                                                                                       \
+    {                                                                                        \
+        if (static_cast<int>(::dtq::LogLevel::level) >= DTQ_MIN_LOG_LEVEL &&                 \
+            ::dtq::Logger::getInstance().isEnabled(::dtq::LogLevel::level))                  \
+            ::dtq::Logger::getInstance().log(::dtq::LogLevel::level, __VA_ARGS__);           \
+    } while (0)
 
 namespace dtq
 {
@@ -14,12 +33,24 @@ namespace dtq
         ERR
     };
 
+    // Writes "<ctime> [LEVEL] message" lines to stdout and, if set, a log file.
+    // Synchronous by default. In async mode log() only queues the record on a
+    // lock-free list; a background thread formats and writes whole batches with
+    // one flush per batch.
     class Logger
     {
     public:
         static Logger &getInstance();
         void log(LogLevel level, const std::string &message);
         void setLogFile(const std::string &filename);
+        // Messages below this level are dropped before formatting
+        void setMinLevel(LogLevel level);
+        bool isEnabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+        // Switching off drains everything queued first
+        void setAsync(bool enabled);
+        // Returns once every record logged so far has been written
+        void flush();
 
     private:
         Logger();
@@ -27,9 +58,44 @@ namespace dtq
         Logger(const Logger &) = delete;
         Logger &operator=(const Logger &) = delete;
 
+        struct Record
+        {
+            std::atomic<Record *> next{nullptr};
+            LogLevel level = LogLevel::INFO;
+            std::chrono::system_clock::time_point time;
+            std::string message;
+        };
+
+        void write(const std::string &lines);
+        void appendLine(std::string &out, LogLevel level, std::chrono::system_clock::time_point time,
+                        const std::string &message);
+        bool drain(std::string &batch);
+        void writerLoop();
+        void stopWriter();
+
         std::ofstream logFile;
-        std::mutex logMutex;
+        std::mutex logMutex; // guards logFile and output ordering
+        std::atomic<LogLevel> minLevel{LogLevel::INFO};
         std::string levelToString(LogLevel level);
+
+        // Timestamp text for the last second formatted (under logMutex or on the writer)
+        long long cachedSecond = -1;
+        std::string cachedStamp;
+
+        // Async mode: producers push onto head; the writer owns tail (a stub node)
+        std::atomic<bool> async{false};
+        std::atomic<Record *> head;
+        Record *tail;
+        std::atomic<unsigned long long> queued{0};
+        std::atomic<unsigned long long> written{0};
+        std::atomic<int> producers{0}; // log() calls that may be queueing
+        std::atomic<bool> writerSleeping{false};
+        bool stopping = false;
+        std::mutex modeMutex; // serializes setAsync()
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        std::thread writer;
     };
 
 } // namespace dtq
@@ -0,0 +1,68 @@
+#ifndef MAPNODECACHE_H
+#define MAPNODECACHE_H
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace dtq
+{
+
+    // Spare nodes of a node-based map (std::unordered_map, std::map), kept
+    // when entries are erased and reused by later inserts, so a map whose size
+    // holds steady stops allocating. A reused node still holds its old mapped
+    // value, and any buffers in it, for the caller to overwrite. Not
+    // thread-safe: guard it with the map.
+    template <typename Map>
+    class MapNodeCache
+    {
+    public:
+        using Iterator = typename Map::iterator;
+
+        explicit MapNodeCache(size_t capacity) : maxSpare(capacity)
+        {
+            spare.reserve(capacity);
+        }
+
+        // Erases it, keeping its node if there is room; returns the next entry
+        Iterator erase(Map &map, Iterator it)
+        {
+            if (spare.size() >= maxSpare)
+            {
+                return map.erase(it);
+            }
+            Iterator next = std::next(it);
+            spare.push_back(map.extract(it));
+            return next;
+        }
+
+        // The entry for key, inserted from a spare node (mapped value left as
+        // it was) or a new default-constructed one; second is true if inserted
+        std::pair<Iterator, bool> findOrInsert(Map &map, const typename Map::key_type &key)
+        {
+            Iterator it = map.find(key);
+            if (it != map.end())
+            {
+                return {it, false};
+            }
+            if (spare.empty())
+            {
+                return map.try_emplace(key);
+            }
+            typename Map::node_type node = std::move(spare.back());
+            spare.pop_back();
+            node.key() = key;
+            return {map.insert(std::move(node)).position, true};
+        }
+
+        size_t size() const { return spare.size(); }
+
+    private:
+        size_t maxSpare;
+        std::vector<typename Map::node_type> spare;
+    };
+
+} // namespace dtq
+
+#endif // MAPNODECACHE_H
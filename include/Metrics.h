@@ -0,0 +1,146 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "Histogram.h"
+#include "Task.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dtq
+{
+
+    // Intervals between consecutive TaskTrace stamps, plus the whole trip
+    enum class Stage
+    {
+        Submit,   // client submit -> server enqueue
+        Queue,    // server enqueue -> assignment
+        Dispatch, // assignment -> worker receipt
+        Execute,  // worker receipt -> completion (includes waiting behind earlier tasks of a batch)
+        Report,   // worker completion -> server confirms the result
+        EndToEnd, // client submit -> server confirms the result
+        Count
+    };
+
+    const char *stageName(Stage stage);
+
+    // Monotonic counter striped over cache-line-sized slots. Each thread adds to
+    // its own slot, so hot paths never share a cache line; value() sums the
+    // slots and may miss adds that race with it.
+    class Counter
+    {
+    public:
+        void add(uint64_t n = 1);
+        uint64_t value() const;
+
+    private:
+        static constexpr size_t kSlots = 32;
+
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> value{0};
+        };
+
+        std::array<Slot, kSlots> slots;
+    };
+
+    // Events per second over a sliding window of whole seconds. Each slot packs
+    // (second, count) into one atomic word, so add() is a single CAS loop and a
+    // slot left over from an earlier lap is recognised by its second.
+    class ThroughputWindow
+    {
+    public:
+        static constexpr int kSlots = 64;
+
+        // windowSeconds is clamped to [1, kSlots - 1]
+        explicit ThroughputWindow(int windowSeconds = 10, int64_t nowUs = monotonicUs());
+
+        void add(uint64_t n = 1, int64_t nowUs = monotonicUs());
+        // Average over the last complete seconds of the window (fewer right after start)
+        double perSecond(int64_t nowUs = monotonicUs()) const;
+
+    private:
+        int window;
+        int64_t startSecond;
+        std::array<std::atomic<uint64_t>, kSlots> slots{};
+    };
+
+    // Per-stage latency histograms (microseconds) of completed tasks and the
+    // completion rate. Everything is lock-free, so recording from session
+    // threads never contends on a metrics lock.
+    class LifecycleMetrics
+    {
+    public:
+        // Records every stage whose two stamps are set and ordered
+        void recordCompletion(const TaskTrace &trace, int64_t confirmedUs);
+
+        Histogram::Snapshot snapshot(Stage stage) const;
+        double completedPerSecond() const { return completions.perSecond(); }
+
+        // "queue n=12 p50=80us p90=... p99=... p999=..." for one stage
+        static std::string describe(Stage stage, const Histogram::Snapshot &snapshot);
+
+    private:
+        std::array<Histogram, static_cast<size_t>(Stage::Count)> stages;
+        ThroughputWindow completions;
+    };
+
+    // Server state returned by CLIENT_GET_STATS and rendered for the metrics
+    // endpoint. Latencies are in microseconds, cumulative since startup.
+    struct StatsSnapshot
+    {
+        struct StageStats
+        {
+            uint64_t count = 0;
+            int64_t sumUs = 0;
+            int64_t p50 = 0;
+            int64_t p90 = 0;
+            int64_t p99 = 0;
+            int64_t p999 = 0;
+        };
+
+        struct WorkerStats
+        {
+            uint64_t sessionId = 0;
+            uint64_t completed = 0;
+            double tasksPerSec = 0.0;
+        };
+
+        uint64_t queueDepth = 0;
+        uint64_t queueBytes = 0; // memory the queued tasks take, payloads included
+        uint64_t blobBytes = 0;  // blob store segments alive, for payloads and results kept there
+        uint64_t delayed = 0; // waiting for their not-before time
+        uint64_t retried = 0;     // failures and lease expiries sent back with backoff
+        uint64_t deadLetters = 0; // out of retries, waiting in the dead-letter queue
+        uint64_t shed = 0;        // rejected for the queue latency target; included in rejected
+        uint64_t inFlight = 0; // assigned and neither finished nor requeued
+        uint64_t accepted = 0;
+        uint64_t rejected = 0;
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+        double tasksPerSec = 0.0;
+        std::vector<uint64_t> shardDepths;
+        std::array<StageStats, static_cast<size_t>(Stage::Count)> stages;
+        std::vector<WorkerStats> workers;
+
+        void setStage(Stage stage, const Histogram::Snapshot &snapshot);
+
+        // Body: u64 depth, inFlight, accepted, rejected, completed, failed; f64 tasks/s;
+        // u32 n + u64 shard depths; u32 n + (u64 count, i64 sum, p50, p90, p99, p999)
+        // per stage; u32 n + (u64 session, u64 completed, f64 tasks/s) per worker;
+        // u64 delayed; u64 retried, deadLetters; u64 shed; u64 queueBytes; u64 blobBytes
+        // (each group absent from older servers)
+        void encode(std::string &out) const;
+        static bool decode(std::string_view data, StatsSnapshot &stats);
+
+        // Prometheus text exposition format
+        std::string toPrometheus() const;
+    };
+
+} // namespace dtq
+
+#endif // METRICS_H
@@ -0,0 +1,49 @@
+#ifndef METRICSHTTPSERVER_H
+#define METRICSHTTPSERVER_H
+
+#include "Network.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace dtq
+{
+
+    // Minimal plaintext HTTP listener for metrics scrapers. One thread accepts
+    // and answers connections one at a time: GET /metrics returns render()'s
+    // output, anything else a 404. Scrapes are rare and small, so there is no
+    // keep-alive, pipelining or request body handling.
+    class MetricsHttpServer
+    {
+    public:
+        using Render = std::function<std::string()>;
+
+        // port 0 binds an ephemeral port, see boundPort()
+        explicit MetricsHttpServer(int port);
+        ~MetricsHttpServer();
+        MetricsHttpServer(const MetricsHttpServer &) = delete;
+        MetricsHttpServer &operator=(const MetricsHttpServer &) = delete;
+
+        bool start(Render render);
+        void stop();
+
+        int boundPort() const { return listenPort; }
+        const std::string &getLastError() const { return lastError; }
+
+    private:
+        void acceptLoop();
+        void serve(SOCKET client);
+
+        int listenPort;
+        SOCKET listenSocket;
+        Render render;
+        std::atomic<bool> stopping{false};
+        std::thread acceptThread;
+        std::string lastError;
+    };
+
+} // namespace dtq
+
+#endif // METRICSHTTPSERVER_H
@@ -0,0 +1,126 @@
+#ifndef MPMCRING_H
+#define MPMCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace dtq
+{
+
+    // Bounded lock-free multi-producer multi-consumer ring (Vyukov's
+    // sequence-numbered design). Each cell carries a sequence number that says
+    // whether it is free for the producer at position pos (sequence == pos) or
+    // holds a value for the consumer at pos (sequence == pos + 1). Producers and
+    // consumers only contend on their own position counter, and values are moved
+    // in and out of the cells rather than copied.
+    template <typename T>
+    class MpmcRing
+    {
+    public:
+        explicit MpmcRing(size_t capacity)
+            : cap(capacity > 0 ? capacity : 1), cells(new Cell[cap])
+        {
+            for (size_t i = 0; i < cap; ++i)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            enqueuePos.store(0, std::memory_order_relaxed);
+            dequeuePos.store(0, std::memory_order_relaxed);
+        }
+
+        MpmcRing(const MpmcRing &) = delete;
+        MpmcRing &operator=(const MpmcRing &) = delete;
+
+        // Returns false (leaving value untouched) if the ring is full
+        template <typename U>
+        bool tryPush(U &&value)
+        {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;)
+            {
+                cell = &cells[pos % cap];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false; // the consumer one lap behind has not freed this cell
+                }
+                else
+                {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::forward<U>(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Returns false if the ring is empty
+        bool tryPop(T &out)
+        {
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;)
+            {
+                cell = &cells[pos % cap];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+            out = std::move(cell->value);
+            // Free the cell for the producer one lap ahead
+            cell->sequence.store(pos + cap, std::memory_order_release);
+            return true;
+        }
+
+        // Exact when no push or pop is in flight
+        size_t sizeApprox() const
+        {
+            size_t tail = dequeuePos.load(std::memory_order_acquire);
+            size_t head = enqueuePos.load(std::memory_order_acquire);
+            return head > tail ? head - tail : 0;
+        }
+
+        size_t capacity() const { return cap; }
+
+    private:
+        static constexpr size_t kCacheLine = 64;
+
+        struct alignas(kCacheLine) Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t cap;
+        std::unique_ptr<Cell[]> cells;
+        // Producers and consumers each get their own cache line
+        alignas(kCacheLine) std::atomic<size_t> enqueuePos;
+        alignas(kCacheLine) std::atomic<size_t> dequeuePos;
+        char padding[kCacheLine - sizeof(std::atomic<size_t>)];
+    };
+
+} // namespace dtq
+
+#endif // MPMCRING_H
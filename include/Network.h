@@ -1,11 +1,28 @@
 #ifndef NETWORK_H
 #define NETWORK_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
 #include <winsock2.h>
+#else
+typedef int SOCKET;
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+#ifndef SOCKET_ERROR
+#define SOCKET_ERROR (-1)
+#endif
 #endif
 
 namespace dtq
@@ -17,18 +34,62 @@ namespace dtq
         WORKER_SUBMIT_RESULT = 3,
         SERVER_ASSIGN_TASK = 4,
         SERVER_TASK_ACCEPTED = 5,
-        SERVER_TASK_REJECTED = 6,
+        SERVER_TASK_REJECTED = 6,     // payload: u32 retry-after ms (0: do not retry as is), then the reason
         WORKER_TASK_RECEIVED = 7,
         SERVER_RESULT_CONFIRMED = 8,
+        CLIENT_ADD_TASK_BATCH = 9,    // payload: task batch (Task::serializeBatch)
+        WORKER_REQUEST_TASKS = 10,    // payload: u32 max tasks
+        SERVER_TASK_BATCH_RESULT = 11, // payload: u32 count, one u8 per task (1 = accepted), u32 retry-after ms for the rest
+        SERVER_ASSIGN_TASKS = 12,     // payload: task batch, possibly empty; acked by one WORKER_TASK_RECEIVED
+        WORKER_POLL_TASKS = 13,       // payload: u32 max tasks, u32 timeout ms; long-poll variant of WORKER_REQUEST_TASKS
+        CLIENT_GET_RESULT = 14,       // payload: i32 taskId
+        SERVER_TASK_RESULT = 15,      // payload: one TaskStore record (i32 taskId, u8 found, u8 status, bytes result)
+        CLIENT_GET_RESULTS_BATCH = 16, // payload: u32 count, then i32 taskIds
+        SERVER_TASK_RESULTS = 17,     // payload: u32 count, then one TaskStore record per requested id
+        CLIENT_GET_STATS = 18,        // no payload
+        SERVER_STATS = 19,            // payload: StatsSnapshot::encode()
+        WORKER_REPORT_FAILURE = 20,   // payload: the task, result holding the error; acked by SERVER_RESULT_CONFIRMED
+        CLIENT_GET_DEAD_LETTERS = 21, // payload: u32 max tasks, 0 for all
+        SERVER_DEAD_LETTERS = 22,     // payload: task batch, oldest first; each result holds the last error
+        CLIENT_REQUEUE_DEAD_LETTERS = 23, // payload: u32 count, then i32 taskIds; count 0 requeues all
+        SERVER_DEAD_LETTERS_REQUEUED = 24, // payload: u32 tasks requeued
+        WORKER_REGISTER = 25,         // payload: u32 credits (tasks the worker can take); switches it to pushed tasks
+        SERVER_WORKER_REGISTERED = 26, // payload: u32 heartbeat interval ms
+        WORKER_HEARTBEAT = 27,        // one-way; payload: u32 credits freed since the last heartbeat
+        SERVER_PUSH_TASKS = 28,       // server-initiated task batch; acked by WORKER_TASK_RECEIVED with its requestId
         INVALID = 99
     };
 
+    // Wire frame: header followed by `size` payload bytes. A response carries the
+    // requestId of the request it answers; 0 means "uncorrelated".
+    // Frames the server sends unprompted (SERVER_PUSH_TASKS) have this bit set
+    // in their requestId, which client requestIds never do.
+    constexpr uint32_t kServerRequestBit = 0x80000000u;
+
+    struct FrameHeader
+    {
+        int32_t type;
+        uint32_t requestId;
+        int32_t size;
+    };
+
+    struct Message
+    {
+        MessageType type = MessageType::INVALID;
+        uint32_t requestId = 0;
+        std::string payload;
+    };
+
     class Network
     {
     public:
         static bool initialize();
         static void cleanup();
 
+        // Portable helpers shared by the blocking client and the server transports
+        static void closeSocket(SOCKET sock);
+        static int lastSocketError();
+
         class Connection
         {
         public:
@@ -46,16 +107,43 @@ namespace dtq
 #endif
             
             ~Connection() { disconnect(); }
+            Connection(const Connection &) = delete;
+            Connection &operator=(const Connection &) = delete;
             
             bool connect();
             void disconnect();
+            // Wakes a thread blocked in receiveMessage(); the socket stays open until disconnect()
+            void shutdown();
+            bool isConnected() const { return socketDescriptor != INVALID_SOCKET; }
+            // 0 disables the timeout; persistent connections idle between requests
+            bool setReceiveTimeout(std::chrono::milliseconds timeout);
+            // One frame per socket write (header and payload gathered together)
             bool sendMessage(MessageType type, const std::string &payload);
+            bool sendMessage(MessageType type, uint32_t requestId, const std::string &payload);
+            // Frames are parsed out of a per-connection buffer, so pipelined
+            // frames that arrive together take one recv(). Fails on a frame over
+            // Config::MaxFrameBytes.
             bool receiveMessage(MessageType &type, std::string &payload);
-            const std::string &getLastError() const { return lastError; }
+            bool receiveMessage(MessageType &type, uint32_t &requestId, std::string &payload);
+            // Sends and receives may fail on different threads, so the error
+            // is kept under its own lock and returned by value
+            std::string getLastError() const;
+
+            // Socket send and receive calls made so far, for benchmarks
+            uint64_t sendCalls() const { return sendCallCount; }
+            uint64_t recvCalls() const { return recvCallCount; }
+
+            // Bodies up to this size are read through the receive buffer; larger
+            // ones go straight into the caller's string
+            static constexpr size_t kReceiveBufferBytes = 64 * 1024;
 
         private:
-            bool send(const char* data, int size);
-            bool recvAll(char* buffer, int size);
+            bool sendFrame(const FrameHeader &header, const std::string &payload);
+            // Makes at least bytes (<= kReceiveBufferBytes) unread bytes buffered
+            bool fillBuffer(size_t bytes);
+            // One recv() into buffer; the byte count, or <= 0 with lastError set
+            long long receiveSome(char *buffer, size_t size);
+            void setLastError(const std::string &error);
             
             std::string serverAddress;
             int serverPort;
@@ -64,6 +152,64 @@ namespace dtq
 #else
             int socketDescriptor;
 #endif
+            mutable std::mutex errorMutex;
+            std::string lastError;
+            std::unique_ptr<char[]> recvBuffer; // allocated on first receive
+            size_t recvBegin = 0;               // unread bytes are [recvBegin, recvEnd)
+            size_t recvEnd = 0;
+            uint64_t sendCallCount = 0;
+            uint64_t recvCallCount = 0;
+        };
+
+        // Long-lived, multiplexed connection. Any number of threads may have
+        // requests in flight on one socket; a reader thread matches responses to
+        // requests by requestId, so they may arrive in any order.
+        class Client
+        {
+        public:
+            Client(const std::string &serverAddr, int port);
+            ~Client();
+            Client(const Client &) = delete;
+            Client &operator=(const Client &) = delete;
+
+            // Returns true immediately if already connected
+            bool connect();
+            void disconnect();
+            bool isConnected() const { return connected.load(); }
+            // Counts successful connects; a change means the connection was re-established
+            uint64_t generation() const { return connects.load(); }
+
+            // The future yields a Message of type INVALID if the connection drops
+            std::future<Message> request(MessageType type, const std::string &payload);
+            // request() + wait; false on timeout or connection loss
+            bool call(MessageType type, const std::string &payload, Message &response,
+                      std::chrono::milliseconds timeout);
+            // One-way message, e.g. an acknowledgment echoing an earlier requestId
+            bool notify(MessageType type, uint32_t requestId, const std::string &payload);
+            // Receives frames the server pushes (requestId with kServerRequestBit),
+            // on the reader thread. Set before connect().
+            void setPushHandler(std::function<void(Message &&)> handler) { pushHandler = std::move(handler); }
+
+            std::string getLastError();
+
+        private:
+            void readerLoop();
+            void failPending(const std::string &reason);
+            void setLastError(const std::string &error);
+
+            Connection conn;
+            // connect() and disconnect() hold connectMutex, and sendMutex too
+            // while they replace the socket, so no send uses a closed one
+            std::mutex connectMutex;
+            std::mutex sendMutex;
+            std::mutex pendingMutex;
+            std::unordered_map<uint32_t, std::promise<Message>> pending;
+            std::atomic<uint32_t> nextRequestId{0};
+            std::atomic<bool> connected{false};
+            std::atomic<uint64_t> connects{0};
+            std::function<void(Message &&)> pushHandler;
+            std::thread reader;
+            std::mutex errorMutex;
             std::string lastError;
         };
     };
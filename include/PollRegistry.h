@@ -0,0 +1,78 @@
+#ifndef POLLREGISTRY_H
+#define POLLREGISTRY_H
+
+#include "Task.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // Long-poll requests parked until tasks arrive or their timeout expires.
+    // A parked poll is just an entry here: it holds no thread, and a single
+    // reaper thread answers every poll whose deadline passes.
+    class PollRegistry
+    {
+    public:
+        using PollId = uint64_t;
+        // Receives the tasks for the poll; an empty vector means it timed out
+        using Deliver = std::function<void(std::vector<Task> &&tasks)>;
+        // Takes up to n tasks from the ready queue, starting at the home shard
+        using TakeTasks = std::function<std::vector<Task>(size_t home, size_t n)>;
+
+        explicit PollRegistry(TakeTasks takeTasks);
+        ~PollRegistry();
+
+        void start();
+        // Answers every parked poll with an empty batch
+        void stop();
+
+        // Serves the poll immediately if tasks are ready, otherwise parks it.
+        // Returns 0 if it was served immediately.
+        PollId park(size_t home, size_t maxTasks, std::chrono::milliseconds timeout, Deliver deliver);
+        // Drops a parked poll without answering it (e.g. its connection closed)
+        void cancel(PollId id);
+        // Call after tasks were added to the ready queue
+        void onTasksAvailable();
+
+        size_t parkedCount();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Poll
+        {
+            PollId id;
+            size_t home;
+            size_t maxTasks;
+            Clock::time_point deadline;
+            Deliver deliver;
+            std::multimap<Clock::time_point, PollId>::iterator byDeadline;
+        };
+
+        void reaperLoop();
+        void eraseLocked(std::list<Poll>::iterator it);
+
+        TakeTasks takeTasks;
+        std::mutex mutex;
+        std::condition_variable reaperWake;
+        std::list<Poll> polls; // arrival order, served first-come first-served
+        std::unordered_map<PollId, std::list<Poll>::iterator> byId;
+        std::multimap<Clock::time_point, PollId> deadlines;
+        PollId nextId = 0;
+        bool running = false;
+        std::thread reaper;
+    };
+
+} // namespace dtq
+
+#endif // POLLREGISTRY_H
@@ -0,0 +1,75 @@
+#ifndef PRIORITYSCHEDULER_H
+#define PRIORITYSCHEDULER_H
+
+#include "Task.h"
+#include "MapNodeCache.h"
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // Orders tasks by priority level (higher first) and earliest deadline first
+    // within a level. Tasks without a deadline get arrival + defaultDeadlineMs.
+    // A task that has waited agingIntervalMs on its level moves up one level, so
+    // low-priority work is not starved. push and pop are O(log n); each task is
+    // promoted at most levels - 1 times. Nodes of popped tasks are kept for
+    // the next pushes, so a scheduler whose size holds steady does not allocate.
+    // Not thread-safe: TaskQueue guards it with its mutex. Times are wall-clock
+    // ms, the same clock as Task::deadlineMs.
+    class PriorityScheduler
+    {
+    public:
+        PriorityScheduler(int levels, long long agingIntervalMs, long long defaultDeadlineMs);
+
+        void push(Task task, long long nowMs);
+        bool pop(Task &out, long long nowMs);
+        size_t size() const { return entries.size(); }
+
+    private:
+        struct Key
+        {
+            long long timeMs;
+            uint64_t seq; // FIFO among equal times
+            bool operator<(const Key &other) const
+            {
+                return timeMs < other.timeMs || (timeMs == other.timeMs && seq < other.seq);
+            }
+        };
+
+        struct Entry
+        {
+            Task task;
+            long long deadlineMs = 0;
+            long long levelSinceMs = 0; // when it entered its current level
+        };
+        using EntryMap = std::unordered_map<uint64_t, Entry>;
+        using KeySet = std::set<Key>;
+
+        struct Level
+        {
+            KeySet byDeadline;
+            KeySet byWait;
+        };
+
+        static constexpr size_t kSpareNodes = 1024;
+
+        void age(long long nowMs);
+        void insertKey(KeySet &keys, Key key);
+        void eraseKey(KeySet &keys, KeySet::iterator it);
+
+        std::vector<Level> levels;
+        EntryMap entries;
+        MapNodeCache<EntryMap> spareEntries{kSpareNodes};
+        std::vector<KeySet::node_type> spareKeys; // two per task, one in each set
+        long long agingIntervalMs;
+        long long defaultDeadlineMs;
+        uint64_t nextSeq = 0;
+    };
+
+} // namespace dtq
+
+#endif // PRIORITYSCHEDULER_H
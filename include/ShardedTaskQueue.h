@@ -0,0 +1,63 @@
+#ifndef SHARDEDTASKQUEUE_H
+#define SHARDEDTASKQUEUE_H
+
+#include "TaskQueue.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace dtq
+{
+
+    // N independent TaskQueue shards sharing Config::MaxQueueSize between them.
+    // Callers pass a home shard (e.g. a connection hashed with shardFor()):
+    // producers enqueue there and consumers dequeue there first, stealing a
+    // batch from the next non-empty sibling when home runs dry. Order is FIFO
+    // per shard, so only approximately FIFO overall.
+    class ShardedTaskQueue
+    {
+    public:
+        explicit ShardedTaskQueue(size_t shards, QueueBackend backend = QueueBackend::Mutex);
+
+        size_t shardCount() const { return shards.size(); }
+        size_t shardFor(uint64_t key) const { return static_cast<size_t>(key % shards.size()); }
+
+        // Spills to siblings when the home shard is full
+        bool enqueue(size_t home, const Task &task);
+        bool enqueue(size_t home, Task &&task);
+        // Accepts a prefix of tasks, like TaskQueue::enqueueBulk
+        size_t enqueueBulk(size_t home, std::vector<Task> &&tasks);
+
+        std::optional<Task> dequeue(size_t home);
+        std::vector<Task> dequeueBulk(size_t home, size_t maxTasks);
+
+        size_t size();
+        size_t bytesQueued() const;
+        // Current depth of each shard
+        std::vector<size_t> shardDepths();
+
+        // Sets TaskQueue::setLatencyTarget on every shard. Tasks spill past a
+        // shedding shard, so the queue as a whole sheds only when all do.
+        void setLatencyTarget(std::chrono::microseconds target,
+                              std::chrono::microseconds interval = Config::QueueLatencyInterval);
+        bool shedding() const;
+        uint64_t shed() const;
+
+        // One TaskStore is shared by every shard, so results are found
+        // regardless of which shard ran the task
+        bool updateTaskResult(int taskId, const std::string &result, TaskStatus status,
+                              BlobRef resultBlob = BlobRef());
+        TaskStore &store() { return *taskStore; }
+
+    private:
+        template <typename T>
+        bool push(size_t home, T &&task);
+
+        std::shared_ptr<TaskStore> taskStore;
+        std::vector<std::unique_ptr<TaskQueue>> shards;
+    };
+
+} // namespace dtq
+
+#endif // SHARDEDTASKQUEUE_H
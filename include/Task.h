@@ -1,8 +1,13 @@
 #ifndef TASK_H
 #define TASK_H
 
+#include "BlobStore.h"
+
+#include <chrono>
+#include <cstdint>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <vector>
 
 namespace dtq
 {
@@ -15,6 +20,58 @@ namespace dtq
         FAILED
     };
 
+    // First byte of every serialized task
+    enum class WireFormat : uint8_t
+    {
+        Text = 1,  // legacy "id|payload|status|result|retries|enqueueTime"; drops priority, deadline, not-before and trace
+        Binary = 2 // fixed-width little-endian header, then result and payload bytes
+    };
+
+    // Microseconds on the steady (monotonic) clock. On one host every process
+    // shares this clock, so stamps taken by client, server and worker compare.
+    inline int64_t monotonicUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Milliseconds since the Unix epoch; what deadlines and not-before times use
+    // because they cross hosts
+    inline int64_t wallClockMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Lifecycle stamps from monotonicUs(), filled in as the task moves along;
+    // 0 means the stage was not reached (or the peer predates tracing)
+    struct TaskTrace
+    {
+        int64_t submittedUs = 0; // client
+        int64_t enqueuedUs = 0;  // server
+        int64_t assignedUs = 0;  // server
+        int64_t receivedUs = 0;  // worker
+        int64_t completedUs = 0; // worker
+    };
+
+    // Non-owning decoded task. payload/result point into the buffer that was
+    // decoded and are only valid while that buffer is.
+    struct TaskView
+    {
+        int taskId = 0;
+        TaskStatus status = TaskStatus::PENDING;
+        int retryCount = 0;
+        long long enqueueTimeMs = 0;
+        int priority = 0;
+        long long deadlineMs = 0;
+        long long notBeforeMs = 0;
+        TaskTrace trace;
+        std::string_view payload;
+        std::string_view result;
+    };
+
     struct Task
     {
         int taskId;
@@ -23,37 +80,42 @@ namespace dtq
         std::string result;
         int retryCount;
 
-        long long enqueueTimeMs; // for measuring latency
+        long long enqueueTimeMs; // client submit time, monotonicUs() / 1000
 
-        Task() : taskId(0), status(TaskStatus::PENDING), retryCount(0), enqueueTimeMs(0) {}
+        int priority;          // higher runs first; see Config::PriorityLevels
+        long long deadlineMs;  // wall-clock ms since epoch, 0 for none
+        long long notBeforeMs; // wall-clock ms since epoch; not run before this, 0 for now
+        TaskTrace trace;       // binary format only
+        int64_t queuedUs;      // monotonicUs() when a TaskQueue last took it; not serialized
+        // Server only: the payload when it is kept in a BlobStore, payload
+        // then being empty. Encoded in the payload's place.
+        BlobRef payloadBlob;
 
-        std::string serialize() const
+        Task()
+            : taskId(0), status(TaskStatus::PENDING), retryCount(0), enqueueTimeMs(0), priority(0), deadlineMs(0),
+              notBeforeMs(0), queuedUs(0)
         {
-            std::ostringstream oss;
-            oss << taskId << "|" << payload << "|" << (int)status << "|" << result << "|"
-                << retryCount << "|" << enqueueTimeMs;
-            return oss.str();
         }
 
-        static Task deserialize(const std::string &data)
-        {
-            Task task;
-            std::istringstream iss(data);
-            std::string token;
-            if (std::getline(iss, token, '|'))
-                task.taskId = std::stoi(token);
-            if (std::getline(iss, token, '|'))
-                task.payload = token;
-            if (std::getline(iss, token, '|'))
-                task.status = (TaskStatus)std::stoi(token);
-            if (std::getline(iss, token, '|'))
-                task.result = token;
-            if (std::getline(iss, token, '|'))
-                task.retryCount = std::stoi(token);
-            if (std::getline(iss, token, '|'))
-                task.enqueueTimeMs = std::stoll(token);
-            return task;
-        }
+        std::string serialize(WireFormat format = WireFormat::Binary) const;
+        // Appends the encoding to out, reusing its capacity
+        void serializeTo(std::string &out, WireFormat format = WireFormat::Binary) const;
+        // Binary encoding with a blob payload spliced in rather than copied
+        void serializeTo(SplicedPayload &out) const;
+
+        // Zero-copy decode of either format. Returns false on malformed input.
+        static bool decode(std::string_view data, TaskView &view);
+        // Malformed input yields a default-constructed Task
+        static Task deserialize(std::string_view data);
+        static Task fromView(const TaskView &view);
+        // Overwrites every field with view's, reusing this task's string buffers
+        void assign(const TaskView &view);
+
+        // Batch body: u32 count, then each task as a length-prefixed encoding
+        static std::string serializeBatch(const std::vector<Task> &tasks, WireFormat format = WireFormat::Binary);
+        static void serializeBatch(const std::vector<Task> &tasks, SplicedPayload &out);
+        // Appends one view per task; false if the framing itself is malformed
+        static bool decodeBatch(std::string_view data, std::vector<TaskView> &views);
     };
 
 } // namespace dtq
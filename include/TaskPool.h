@@ -0,0 +1,67 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include "Task.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace dtq
+{
+
+    // Finished Task objects kept for reuse. A released task keeps the
+    // capacity of its payload and result strings, so decoding the next task
+    // into it copies the bytes without allocating. Idle tasks are striped over
+    // independently locked slots by thread, like Counter, so session threads
+    // rarely contend. Tasks are usually released on a different thread than
+    // the one that acquired them (a worker's connection vs. a client's), so a
+    // thread whose own slot is empty, or full, tries the others before
+    // allocating, or dropping the task.
+    class TaskPool
+    {
+    public:
+        // Buffers larger than this are freed rather than kept
+        static constexpr size_t kMaxRetainedBytes = 64 * 1024;
+
+        // Keeps up to capacity idle tasks; 0 means Config::TaskPoolCapacity
+        explicit TaskPool(size_t capacity = 0);
+
+        // The pool shared by the network handlers of this process
+        static TaskPool &getInstance();
+
+        // A default-valued task, reusing a released one's buffers if any
+        Task acquire();
+        // Task::fromView into reused buffers
+        Task acquire(const TaskView &view);
+        // Hands a task that is done with back; kept unless its slot is full
+        void release(Task &&task);
+        void release(std::vector<Task> &&tasks);
+
+        size_t idle();
+        // acquire() calls served from the pool and ones that had to allocate
+        uint64_t reused() const { return reuseCount.load(std::memory_order_relaxed); }
+        uint64_t created() const { return createCount.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t kSlots = 16;
+
+        struct alignas(64) Slot
+        {
+            std::mutex mutex;
+            std::vector<Task> tasks;
+        };
+
+        size_t slotForThread();
+
+        size_t slotCapacity;
+        std::array<Slot, kSlots> slots;
+        std::atomic<uint64_t> reuseCount{0};
+        std::atomic<uint64_t> createCount{0};
+    };
+
+} // namespace dtq
+
+#endif // TASKPOOL_H
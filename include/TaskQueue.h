@@ -2,29 +2,112 @@
 #define TASKQUEUE_H
 
 #include "Task.h"
+#include "MpmcRing.h"
+#include "PriorityScheduler.h"
+#include "TaskStore.h"
+#include "Config.h"
+#include <atomic>
+#include <memory>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 #include <optional>
+#include <vector>
 
 namespace dtq
 {
 
+    enum class QueueBackend
+    {
+        Mutex,       // std::queue behind one mutex
+        LockFreeRing, // bounded lock-free MpmcRing
+        Priority      // PriorityScheduler behind one mutex: priority levels, EDF, aging
+    };
+
     class TaskQueue
     {
     public:
-        TaskQueue();
+        // Holds at most capacity tasks; 0 means Config::MaxQueueSize. Task states
+        // are tracked in store, which may be shared between queues; without one
+        // the queue creates its own.
+        explicit TaskQueue(QueueBackend backend = QueueBackend::Mutex, size_t capacity = 0,
+                           std::shared_ptr<TaskStore> store = nullptr);
         ~TaskQueue();
 
+        // A rejected task is left untouched, even when passed as an rvalue
         bool enqueue(const Task &task);
+        bool enqueue(Task &&task);
         std::optional<Task> dequeue();
-        bool updateTaskResult(int taskId, const std::string &result, TaskStatus status);
+        // Blocks until a task is available or the timeout expires
+        std::optional<Task> dequeueFor(std::chrono::milliseconds timeout);
+        // Take the lock once per batch. enqueueBulk accepts tasks in order until
+        // the queue is full and returns how many were accepted (a prefix of tasks).
+        size_t enqueueBulk(const std::vector<Task> &tasks);
+        // Moves the accepted prefix out of tasks
+        size_t enqueueBulk(std::vector<Task> &&tasks);
+        std::vector<Task> dequeueBulk(size_t maxTasks);
+        // Enqueued tasks are PENDING and dequeued ones IN_PROGRESS in the store;
+        // this records the outcome, the result held in resultBlob if it is not
+        // in result. False for unknown tasks or bad transitions.
+        bool updateTaskResult(int taskId, const std::string &result, TaskStatus status,
+                              BlobRef resultBlob = BlobRef());
+        TaskStore &store() { return *taskStore; }
         size_t size();
+        // Memory the queued tasks take: each Task plus its payload and result bytes
+        size_t bytesQueued() const;
+        QueueBackend backend() const { return backendKind; }
+        size_t capacity() const { return maxSize; }
+
+        // Latency-targeted queue management after CoDel. Once every task
+        // dequeued over a whole interval has waited longer than target (the
+        // minimum sojourn stays above it), new tasks are shed: enqueue fails
+        // until a dequeued task has waited less than target or the queue
+        // empties. Bounds queueing delay regardless of capacity. A target
+        // of 0, the default, turns it off.
+        void setLatencyTarget(std::chrono::microseconds target,
+                              std::chrono::microseconds interval = Config::QueueLatencyInterval);
+        bool shedding() const { return overloaded.load(std::memory_order_relaxed); }
+        // Tasks rejected because of the latency target
+        uint64_t shed() const { return shedCount.load(std::memory_order_relaxed); }
 
     private:
+        template <typename T>
+        bool push(T &&task);
+        template <typename Tasks>
+        size_t pushBulk(Tasks &&tasks);
+        void wakeWaiters(bool all);
+        // Feeds one dequeued task's sojourn into the latency-target state
+        void noteSojourn(const Task &task, size_t remaining);
+        // Time to stamp on tasks taken now; 0 while no latency target is set
+        int64_t stampUs() const;
+        // True (and counted) if count new tasks must be shed
+        bool shedIfOverloaded(size_t count);
+        // Mutex and Priority backends; queueMutex must be held
+        size_t sizeLocked() const;
+        template <typename T>
+        void pushLocked(T &&task);
+        Task popLocked();
+
+        QueueBackend backendKind;
+        size_t maxSize;
         std::queue<Task> queue;
-        std::mutex queueMutex;
+        std::unique_ptr<MpmcRing<Task>> ring;
+        std::unique_ptr<PriorityScheduler> scheduler;
+        std::shared_ptr<TaskStore> taskStore;
+        std::mutex queueMutex; // guards queue/scheduler; with the ring, only used to sleep in dequeueFor
         std::condition_variable condition;
+        std::atomic<int> waiters{0}; // ring consumers sleeping in dequeueFor
+        // Added before a task is visible to consumers, so it may briefly run
+        // ahead of size() but never below zero
+        std::atomic<int64_t> queuedBytes{0};
+
+        // Latency target state; atomics because ring consumers hold no lock
+        std::atomic<int64_t> targetUs{0};
+        std::atomic<int64_t> intervalUs{0};
+        std::atomic<int64_t> aboveUntilUs{0}; // 0: last sojourn was under target
+        std::atomic<bool> overloaded{false};
+        std::atomic<uint64_t> shedCount{0};
     };
 
 } // namespace dtq
@@ -0,0 +1,107 @@
+#ifndef TASKSTORE_H
+#define TASKSTORE_H
+
+#include "Task.h"
+#include "MapNodeCache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    struct TaskRecord
+    {
+        TaskStatus status = TaskStatus::PENDING;
+        std::string result;
+        BlobRef resultBlob; // the result when kept in a BlobStore, result then being empty
+    };
+
+    // Status and result of every known task, keyed by taskId. The map is split
+    // into independently locked shards so result lookups only contend with
+    // updates to the same shard, never with the queue itself.
+    //
+    // Valid transitions: PENDING -> IN_PROGRESS -> COMPLETED/FAILED, plus
+    // IN_PROGRESS -> PENDING when an assignment is requeued and a direct
+    // PENDING -> COMPLETED/FAILED for a result that outruns its requeue.
+    // Finished tasks are evicted oldest first once they exceed the TTL or their
+    // shard's share of the memory budget. Results held in blobs count against
+    // the budget too, so it also bounds the blob store's share of them.
+    class TaskStore
+    {
+    public:
+        explicit TaskStore(size_t shards = 16, size_t memoryBudgetBytes = 0,
+                           std::chrono::milliseconds ttl = std::chrono::milliseconds(0));
+
+        // Starts tracking a task (or restarts a finished one) as PENDING.
+        // Returns the record it replaced, nullopt for a new task.
+        std::optional<TaskRecord> markPending(int taskId);
+        // Undoes markPending: puts back the record it returned, or forgets
+        // the task if it returned nullopt
+        void restore(int taskId, std::optional<TaskRecord> &&record);
+        void erase(int taskId);
+        // Returns false if the task is unknown or the transition is not allowed
+        bool transition(int taskId, TaskStatus status, const std::string &result = std::string(),
+                        BlobRef resultBlob = BlobRef());
+        std::optional<TaskRecord> lookup(int taskId);
+
+        size_t size();
+
+        // Reply bodies for CLIENT_GET_RESULT / CLIENT_GET_RESULTS_BATCH:
+        // per task i32 taskId, u8 found, u8 status, bytes result
+        static void encodeRecord(std::string &out, int taskId, const std::optional<TaskRecord> &record);
+        // The same, with a blob result spliced in rather than copied
+        static void encodeRecord(SplicedPayload &out, int taskId, const std::optional<TaskRecord> &record);
+        static bool decodeRecord(std::string_view &in, int &taskId, std::optional<TaskRecord> &record);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            TaskRecord record;
+            Clock::time_point finishedAt;
+            std::list<int>::iterator finishedPos; // valid once finished
+        };
+
+        using EntryMap = std::unordered_map<int, Entry>;
+
+        // Map and list nodes of removed entries are kept per shard for new
+        // ones, so a store whose size holds steady does not allocate
+        static constexpr size_t kSpareNodes = 256;
+        // Result buffers larger than this are freed rather than kept in a spare node
+        static constexpr size_t kMaxSpareResultBytes = 4096;
+
+        struct Shard
+        {
+            std::mutex mutex;
+            EntryMap entries;
+            std::list<int> finished; // oldest first
+            size_t finishedBytes = 0;
+            MapNodeCache<EntryMap> spareEntries{kSpareNodes};
+            std::list<int> spareFinished;
+        };
+
+        Shard &shardFor(int taskId);
+        static void removeLocked(Shard &shard, EntryMap::iterator it);
+        static std::list<int>::iterator pushFinishedLocked(Shard &shard, int taskId);
+        static void popFinishedLocked(Shard &shard, std::list<int>::iterator pos);
+        void evictLocked(Shard &shard, Clock::time_point now);
+        static bool isFinished(TaskStatus status);
+        static size_t footprint(const Entry &entry);
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        size_t shardBudgetBytes;
+        std::chrono::milliseconds ttl;
+    };
+
+} // namespace dtq
+
+#endif // TASKSTORE_H
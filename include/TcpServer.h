@@ -0,0 +1,115 @@
+#ifndef TCPSERVER_H
+#define TCPSERVER_H
+
+#include "Network.h"
+#include "BlobStore.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // One accepted connection as seen by protocol code. send() and close() are
+    // thread-safe; close() takes effect once already queued replies are written.
+    // Connections are persistent: replies echo the requestId they answer.
+    class Session
+    {
+    public:
+        virtual ~Session() = default;
+        virtual bool send(MessageType type, uint32_t requestId, const std::string &payload) = 0;
+        // Sends a payload with blobs spliced in. This default copies it into one
+        // string; the event-loop transport sends the blobs from their files.
+        virtual bool send(MessageType type, uint32_t requestId, SplicedPayload &&payload)
+        {
+            return send(type, requestId, payload.flatten());
+        }
+        virtual void close() = 0;
+        virtual uint64_t id() const = 0;
+    };
+
+    using SessionPtr = std::shared_ptr<Session>;
+
+    // Per-connection protocol state machine. Callbacks for one session are never
+    // invoked concurrently.
+    class SessionHandler
+    {
+    public:
+        virtual ~SessionHandler() = default;
+        virtual void onMessage(const SessionPtr &session, MessageType type, uint32_t requestId,
+                               std::string &payload) = 0;
+        virtual void onClose(const SessionPtr &/*session*/) {}
+    };
+
+    using SessionHandlerFactory = std::function<std::unique_ptr<SessionHandler>()>;
+
+    enum class ServerMode
+    {
+        EventLoop,          // fixed pool of epoll reactors (Linux only)
+        ThreadPerConnection // one blocking thread per accepted socket
+    };
+
+    class TcpServer
+    {
+    public:
+        // port 0 binds an ephemeral port, see boundPort()
+        TcpServer(int port, ServerMode mode, int numThreads);
+        ~TcpServer();
+        TcpServer(const TcpServer &) = delete;
+        TcpServer &operator=(const TcpServer &) = delete;
+
+        static ServerMode defaultMode();
+
+        bool start(SessionHandlerFactory factory);
+        void stop();
+
+        int boundPort() const { return listenPort; }
+        ServerMode mode() const { return serverMode; }
+        const std::string &getLastError() const { return lastError; }
+
+    private:
+        bool openListenSocket();
+        uint64_t nextSessionId() { return ++sessionCounter; }
+
+        // Thread-per-connection transport
+        class BlockingSession;
+        void acceptLoop();
+        void serveBlocking(std::shared_ptr<BlockingSession> session);
+
+#ifdef __linux__
+        // Event-loop transport
+        class EpollSession;
+        struct LoopContext;
+        bool startEventLoops();
+        void acceptReady();
+        void stopEventLoops();
+        std::vector<std::unique_ptr<LoopContext>> loops;
+        size_t nextLoop = 0;
+#endif
+
+        int listenPort;
+        ServerMode serverMode;
+        int numThreads;
+        SOCKET listenSocket;
+        SessionHandlerFactory handlerFactory;
+        std::atomic<bool> stopping{false};
+        std::atomic<uint64_t> sessionCounter{0};
+        std::string lastError;
+
+        std::thread acceptThread;
+        std::mutex sessionsMutex;
+        std::condition_variable sessionsDrained;
+        std::unordered_map<uint64_t, std::weak_ptr<BlockingSession>> blockingSessions;
+    };
+
+} // namespace dtq
+
+#endif // TCPSERVER_H
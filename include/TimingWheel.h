@@ -0,0 +1,70 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dtq
+{
+
+    // Hierarchical timing wheel: four levels of 256 slots, each level counting
+    // in units of the one below, so 2^32 ticks are covered without a sorted
+    // structure. schedule() and cancel() are O(1); advance() does O(1) work per
+    // elapsed tick plus per expired timer, and a timer is moved down a level at
+    // most three times before it fires. Timers live in a slab of nodes linked
+    // into their slot by index, so millions of them cost one node each.
+    //
+    // Not thread-safe; callers serialize access.
+    class TimingWheel
+    {
+    public:
+        // 0 is never a valid id. Ids of fired or cancelled timers go stale.
+        using TimerId = uint64_t;
+
+        // Time is in caller-supplied milliseconds; deadlines round up to a tick
+        TimingWheel(int64_t tickMs, int64_t nowMs);
+
+        // key is handed back by advance() when the deadline passes. A deadline
+        // already due fires on the next tick.
+        TimerId schedule(int64_t deadlineMs, uint64_t key);
+        // False if the timer already fired or was cancelled
+        bool cancel(TimerId id);
+        // Moves the wheel up to nowMs, appending the keys of every timer that
+        // came due, earliest tick first
+        void advance(int64_t nowMs, std::vector<uint64_t> &expired);
+
+        size_t size() const { return live; }
+
+    private:
+        static constexpr int kLevels = 4;
+        static constexpr int kSlotBits = 8;
+        static constexpr uint32_t kSlots = 1u << kSlotBits;
+        static constexpr uint32_t kNil = UINT32_MAX;
+
+        struct Node
+        {
+            uint64_t key = 0;
+            uint64_t deadlineTick = 0;
+            uint32_t prev = kNil;
+            uint32_t next = kNil;
+            uint32_t slot = kNil; // index into heads; kNil while free
+            uint32_t generation = 1;
+        };
+
+        void place(uint32_t index);
+        void unlink(uint32_t index);
+        void release(uint32_t index);
+        void cascade(int level);
+
+        int64_t tickMs;
+        uint64_t currentTick;
+        std::vector<Node> nodes;
+        std::vector<uint32_t> freeNodes;
+        std::vector<uint32_t> heads; // kLevels * kSlots list heads
+        size_t live = 0;
+    };
+
+} // namespace dtq
+
+#endif // TIMINGWHEEL_H
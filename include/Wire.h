@@ -0,0 +1,177 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace dtq
+{
+    // Little-endian primitives for the binary message formats. Writers append to
+    // a std::string; Reader walks a buffer without copying and fails (returns
+    // false) instead of reading past the end.
+    namespace wire
+    {
+
+        inline void putU8(std::string &out, uint8_t v)
+        {
+            out.push_back(static_cast<char>(v));
+        }
+
+        inline void putU16(std::string &out, uint16_t v)
+        {
+            char b[2] = {static_cast<char>(v), static_cast<char>(v >> 8)};
+            out.append(b, sizeof(b));
+        }
+
+        inline void putU32(std::string &out, uint32_t v)
+        {
+            char b[4];
+            for (int i = 0; i < 4; ++i)
+                b[i] = static_cast<char>(v >> (8 * i));
+            out.append(b, sizeof(b));
+        }
+
+        inline void putU64(std::string &out, uint64_t v)
+        {
+            char b[8];
+            for (int i = 0; i < 8; ++i)
+                b[i] = static_cast<char>(v >> (8 * i));
+            out.append(b, sizeof(b));
+        }
+
+        inline void putI32(std::string &out, int32_t v) { putU32(out, static_cast<uint32_t>(v)); }
+        inline void putI64(std::string &out, int64_t v) { putU64(out, static_cast<uint64_t>(v)); }
+
+        // IEEE-754 bits, little-endian like the integers
+        inline void putF64(std::string &out, double v)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            putU64(out, bits);
+        }
+
+        // Length-prefixed byte string
+        inline void putBytes(std::string &out, std::string_view bytes)
+        {
+            putU32(out, static_cast<uint32_t>(bytes.size()));
+            out.append(bytes.data(), bytes.size());
+        }
+
+        class Reader
+        {
+        public:
+            explicit Reader(std::string_view data) : cur(data.data()), left(data.size()) {}
+
+            size_t remaining() const { return left; }
+            std::string_view rest() const { return std::string_view(cur, left); }
+
+            bool getU8(uint8_t &v)
+            {
+                if (left < 1)
+                    return false;
+                v = static_cast<uint8_t>(*cur);
+                advance(1);
+                return true;
+            }
+
+            bool getU16(uint16_t &v)
+            {
+                uint64_t wide;
+                if (!getLE(2, wide))
+                    return false;
+                v = static_cast<uint16_t>(wide);
+                return true;
+            }
+
+            bool getU32(uint32_t &v)
+            {
+                uint64_t wide;
+                if (!getLE(4, wide))
+                    return false;
+                v = static_cast<uint32_t>(wide);
+                return true;
+            }
+
+            bool getU64(uint64_t &v) { return getLE(8, v); }
+
+            bool getI32(int32_t &v)
+            {
+                uint32_t u;
+                if (!getU32(u))
+                    return false;
+                v = static_cast<int32_t>(u);
+                return true;
+            }
+
+            bool getI64(int64_t &v)
+            {
+                uint64_t u;
+                if (!getU64(u))
+                    return false;
+                v = static_cast<int64_t>(u);
+                return true;
+            }
+
+            bool getF64(double &v)
+            {
+                uint64_t bits;
+                if (!getU64(bits))
+                    return false;
+                std::memcpy(&v, &bits, sizeof(v));
+                return true;
+            }
+
+            // Fixed-size slice of the underlying buffer
+            bool getView(size_t n, std::string_view &v)
+            {
+                if (left < n)
+                    return false;
+                v = std::string_view(cur, n);
+                advance(n);
+                return true;
+            }
+
+            // Length-prefixed byte string written by putBytes()
+            bool getBytes(std::string_view &v)
+            {
+                uint32_t n;
+                return getU32(n) && getView(n, v);
+            }
+
+            bool skip(size_t n)
+            {
+                if (left < n)
+                    return false;
+                advance(n);
+                return true;
+            }
+
+        private:
+            bool getLE(size_t n, uint64_t &v)
+            {
+                if (left < n)
+                    return false;
+                v = 0;
+                for (size_t i = 0; i < n; ++i)
+                    v |= static_cast<uint64_t>(static_cast<unsigned char>(cur[i])) << (8 * i);
+                advance(n);
+                return true;
+            }
+
+            void advance(size_t n)
+            {
+                cur += n;
+                left -= n;
+            }
+
+            const char *cur;
+            size_t left;
+        };
+
+    } // namespace wire
+} // namespace dtq
+
+#endif // WIRE_H
@@ -0,0 +1,90 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include "Task.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dtq
+{
+
+    // Compute side of a worker: a fixed set of threads running tasks handed
+    // in by an I/O thread, with finished tasks collected for a separate
+    // submitter. Each thread owns a deque it works from the front of; an idle
+    // thread steals from the back of a sibling's, so one long task does not
+    // strand the tasks queued behind it. Knows nothing about the network.
+    class WorkerPool
+    {
+    public:
+        // Runs a task in place, filling in status and result; workerId is 1-based
+        using Process = std::function<void(Task &task, int workerId)>;
+
+        // 0 threads means Config::ThreadPoolSize. The threads start right away.
+        WorkerPool(size_t threads, Process process);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        // Spreads the tasks over the threads' deques
+        void submit(std::vector<Task> &&tasks);
+        // Blocks until fewer than limit tasks are waiting to start. False if
+        // the pool was stopped or timeout passed first.
+        bool waitForRoom(size_t limit, std::chrono::milliseconds timeout);
+        // Finished tasks, oldest first, waiting up to timeout for the first.
+        // Empty once the pool is stopped and drained.
+        std::vector<Task> takeResults(std::chrono::milliseconds timeout);
+
+        // Lets running tasks finish and joins the threads. Tasks not yet
+        // started are dropped; their leases bring them back on the server.
+        void stop();
+
+        size_t threadCount() const { return lanes.size(); }
+        // Tasks waiting to start, across all deques
+        size_t queued() const { return waiting.load(std::memory_order_relaxed); }
+        // Tasks taken from a sibling's deque
+        uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+        // Microseconds all threads together spent inside Process
+        uint64_t busyUs() const { return busy.load(std::memory_order_relaxed); }
+
+    private:
+        struct Lane
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void run(size_t index);
+        bool takeTask(size_t index, Task &task);
+
+        Process process;
+        std::vector<std::unique_ptr<Lane>> lanes;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> nextLane{0};
+        std::atomic<size_t> waiting{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> busy{0};
+
+        // Guards the sleep/wake handshakes; the deques have their own locks
+        std::mutex stateMutex;
+        std::condition_variable workAvailable;
+        std::condition_variable roomAvailable;
+        std::atomic<bool> stopping{false};
+
+        std::mutex resultsMutex;
+        std::condition_variable resultsReady;
+        std::vector<Task> results;
+        size_t running = 0; // threads not yet exited, under resultsMutex
+    };
+
+} // namespace dtq
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,78 @@
+#ifndef WORKERREGISTRY_H
+#define WORKERREGISTRY_H
+
+#include "Task.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace dtq
+{
+
+    // Workers that registered for pushed tasks. Each advertises credits, the
+    // tasks it can take without falling behind, and returns them in its
+    // heartbeats as tasks finish. Whenever tasks are ready they are pushed to
+    // workers with credit, round-robin, so a worker never polls and never
+    // receives more than it asked for. A worker not heard from in time is
+    // dropped by expire().
+    class WorkerRegistry
+    {
+    public:
+        using WorkerId = uint64_t;
+        // Sends tasks to the worker; never called with an empty batch
+        using Push = std::function<void(std::vector<Task> &&tasks)>;
+        // Disconnects a worker that stopped sending heartbeats
+        using Evict = std::function<void()>;
+        // Takes up to n tasks from the ready queue, starting at the home shard
+        using TakeTasks = std::function<std::vector<Task>(size_t home, size_t n)>;
+
+        // maxBatch caps one push; 0 means Config::BatchSize
+        explicit WorkerRegistry(TakeTasks takeTasks, size_t maxBatch = 0);
+
+        // Registers (or re-registers) a worker and pushes it whatever is ready
+        void add(WorkerId id, size_t home, uint32_t credits, int64_t nowMs, Push push, Evict evict);
+        // Adds freed credits and pushes if tasks are ready. False if the
+        // worker is not registered (never was, or was evicted).
+        bool heartbeat(WorkerId id, uint32_t credits, int64_t nowMs);
+        void remove(WorkerId id);
+        // Call after tasks were added to the ready queue
+        void onTasksAvailable();
+        // Removes every worker last heard from before silentSinceMs and
+        // returns their Evict callbacks, to be run by the caller
+        std::vector<Evict> expire(int64_t silentSinceMs);
+
+        size_t size();
+        // Credits outstanding across all workers
+        uint64_t credits();
+
+    private:
+        struct Worker
+        {
+            size_t home = 0;
+            uint32_t credits = 0;
+            int64_t lastSeenMs = 0;
+            Push push;
+            Evict evict;
+            bool ready = false; // in readyOrder
+            std::list<WorkerId>::iterator readyPos;
+        };
+
+        // Fills pushes from the ready queue; called with mutex held
+        void dispatchLocked(std::vector<std::pair<Push, std::vector<Task>>> &pushes);
+        void markReadyLocked(WorkerId id, Worker &worker);
+        static void deliver(std::vector<std::pair<Push, std::vector<Task>>> &pushes);
+
+        TakeTasks takeTasks;
+        size_t maxBatch;
+        std::mutex mutex;
+        std::unordered_map<WorkerId, Worker> workers;
+        std::list<WorkerId> readyOrder; // workers with credit, next to be served first
+    };
+
+} // namespace dtq
+
+#endif // WORKERREGISTRY_H
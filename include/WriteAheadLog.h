@@ -0,0 +1,105 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include "Task.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace dtq
+{
+
+    // Append-only log of queue events, so queued and in-flight tasks survive a
+    // restart. Appends only copy into a buffer; a flusher thread writes and
+    // fsyncs everything buffered in one go (group commit), waiting at most
+    // maxCommitDelay after the first unsynced record so concurrent connections
+    // share each fsync. Callers that must not acknowledge before the record is
+    // on disk register a callback with whenDurable().
+    //
+    // Record: u32 body length, u32 CRC-32 of type and body, u8 type, body.
+    // Replay stops at the first torn or corrupt record.
+    class WriteAheadLog
+    {
+    public:
+        enum class RecordType : uint8_t
+        {
+            Enqueue = 1,  // body: binary task
+            Assign = 2,   // body: i32 taskId
+            Complete = 3, // body: i32 taskId, u8 status, bytes result
+            Requeue = 4,  // body: i32 taskId
+            Drop = 5      // body: i32 taskId; an Enqueue the queue rejected
+        };
+
+        // Live tasks found by replay, each list in queue order
+        struct Recovered
+        {
+            std::vector<Task> pending;
+            std::vector<Task> inFlight; // assigned but never completed
+            size_t records = 0;
+            bool truncated = false; // a torn or corrupt tail was discarded
+        };
+
+        // Runs on the flusher thread; ok is false if the write or fsync failed
+        using Durable = std::function<void(bool ok)>;
+
+        explicit WriteAheadLog(std::chrono::microseconds maxCommitDelay);
+        ~WriteAheadLog();
+
+        // Replays path into recovered, rewrites it to hold only the live tasks
+        // (all pending again) and starts appending to it
+        bool open(const std::string &path, Recovered &recovered);
+        // Flushes what is buffered and stops the flusher
+        void close();
+
+        // Each returns the record's log sequence number
+        uint64_t logEnqueue(const Task &task);
+        uint64_t logAssign(int taskId);
+        uint64_t logComplete(int taskId, TaskStatus status, std::string_view result);
+        uint64_t logRequeue(int taskId);
+        uint64_t logDrop(int taskId);
+
+        // Calls done once every record up to lsn is durable (immediately if it already is)
+        void whenDurable(uint64_t lsn, Durable done);
+        // Blocks until lsn is durable; false on I/O failure
+        bool waitDurable(uint64_t lsn);
+
+        uint64_t syncCount();
+        std::string getLastError();
+
+        // Reads a log without opening it for writing
+        static bool replay(const std::string &path, Recovered &recovered, std::string &error);
+
+    private:
+        uint64_t append(RecordType type, std::string_view body);
+        void flusherLoop();
+        bool writeAll(const std::string &data);
+        bool syncFile();
+
+        std::chrono::microseconds maxCommitDelay;
+        int fd = -1;
+
+        std::mutex mutex;
+        std::condition_variable flushWake;   // flusher: new records or stop
+        std::condition_variable durableWake; // waitDurable callers
+        std::string buffer;                  // records not yet handed to the flusher
+        std::chrono::steady_clock::time_point oldestBuffered;
+        std::vector<std::pair<uint64_t, Durable>> callbacks;
+        uint64_t nextLsn = 1;
+        uint64_t durableLsn = 0;
+        uint64_t syncs = 0;
+        bool failed = false;
+        bool running = false;
+        std::string lastError;
+        std::thread flusher;
+    };
+
+} // namespace dtq
+
+#endif // WRITEAHEADLOG_H
@@ -0,0 +1,104 @@
+#include "Admission.h"
+#include "Config.h"
+#include "Wire.h"
+
+#include <algorithm>
+
+namespace dtq
+{
+
+    uint32_t retryAfterMs(size_t depth, size_t targetDepth, double drainPerSec)
+    {
+        int64_t lo = Config::RetryAfterMin.count();
+        int64_t hi = Config::RetryAfterMax.count();
+        if (drainPerSec <= 0.0)
+        {
+            return static_cast<uint32_t>(hi);
+        }
+        double excess = depth > targetDepth ? static_cast<double>(depth - targetDepth) : 0.0;
+        int64_t ms = static_cast<int64_t>(excess * 1000.0 / drainPerSec);
+        return static_cast<uint32_t>(std::min(std::max(ms, lo), hi));
+    }
+
+    std::string encodeRejection(uint32_t retryAfterMs, std::string_view reason)
+    {
+        std::string out;
+        out.reserve(4 + reason.size());
+        wire::putU32(out, retryAfterMs);
+        out.append(reason);
+        return out;
+    }
+
+    bool decodeRejection(std::string_view payload, uint32_t &retryAfterMs, std::string &reason)
+    {
+        wire::Reader in(payload);
+        std::string_view rest;
+        if (!in.getU32(retryAfterMs) || !in.getView(in.remaining(), rest))
+        {
+            return false;
+        }
+        reason.assign(rest);
+        return true;
+    }
+
+    AimdRate::AimdRate(double initialPerSec, double minPerSec, double maxPerSec, double increasePerSec,
+                       double decreaseFactor)
+        : rate(initialPerSec), minRate(minPerSec), maxRate(maxPerSec), increase(increasePerSec),
+          decrease(decreaseFactor)
+    {
+        rate = std::min(std::max(rate, minRate), maxRate);
+    }
+
+    size_t AimdRate::available(int64_t nowUs)
+    {
+        if (nowUs < pausedUntilUs)
+        {
+            return 0;
+        }
+        // Nothing accrues while paused
+        lastRefillUs = std::max(lastRefillUs ? lastRefillUs : nowUs, pausedUntilUs);
+        if (nowUs > lastRefillUs)
+        {
+            double burst = std::max(1.0, rate * 0.1);
+            tokens = std::min(burst, tokens + rate * static_cast<double>(nowUs - lastRefillUs) / 1e6);
+            lastRefillUs = nowUs;
+        }
+        return static_cast<size_t>(tokens);
+    }
+
+    void AimdRate::take(size_t n)
+    {
+        tokens = std::max(0.0, tokens - static_cast<double>(n));
+    }
+
+    void AimdRate::onAccepted(size_t n)
+    {
+        rate = std::min(maxRate, rate + increase * static_cast<double>(n) / rate);
+    }
+
+    void AimdRate::onRejected(uint32_t retryAfterMs, int64_t nowUs)
+    {
+        int64_t holdUs = static_cast<int64_t>(retryAfterMs) * 1000;
+        pausedUntilUs = std::max(pausedUntilUs, nowUs + holdUs);
+        tokens = 0.0;
+        // Replies already in flight when the queue filled all come back
+        // rejected; they are one congestion event, not several
+        if (lastDecreaseUs != 0 && nowUs - lastDecreaseUs < decreaseHoldUs)
+        {
+            return;
+        }
+        rate = std::max(minRate, rate * decrease);
+        lastDecreaseUs = nowUs;
+        decreaseHoldUs = std::max<int64_t>(holdUs, 100000);
+    }
+
+    int64_t AimdRate::nextSendUs() const
+    {
+        if (lastRefillUs < pausedUntilUs || tokens >= 1.0)
+        {
+            return std::max(lastRefillUs, pausedUntilUs);
+        }
+        return lastRefillUs + static_cast<int64_t>((1.0 - tokens) * 1e6 / rate);
+    }
+
+} // namespace dtq
@@ -0,0 +1,119 @@
+#include "BlobStore.h"
+#include "Config.h"
+#include "Logger.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <cstring>
+
+namespace dtq
+{
+
+    BlobSegment::~BlobSegment()
+    {
+#ifndef _WIN32
+        munmap(mapped, mappedBytes);
+        ::close(fileFd);
+#endif
+        liveBytes->fetch_sub(mappedBytes, std::memory_order_relaxed);
+    }
+
+    BlobStore::BlobStore(std::string dir, size_t segmentBytes)
+        : directory(std::move(dir)), segmentBytes(segmentBytes ? segmentBytes : Config::BlobSegmentBytes)
+    {
+    }
+
+    bool BlobStore::open()
+    {
+#ifdef _WIN32
+        lastError = "The blob store needs mmap and is not supported on Windows";
+        return false;
+#else
+        // Creating the first segment up front surfaces a bad directory at startup
+        std::lock_guard<std::mutex> lock(mutex);
+        current = createSegment(segmentBytes);
+        used = 0;
+        return current != nullptr;
+#endif
+    }
+
+    std::shared_ptr<BlobSegment> BlobStore::createSegment(size_t capacity)
+    {
+#ifdef _WIN32
+        return nullptr;
+#else
+        std::string path = directory + "/dtq-blob-" + std::to_string(getpid()) + "-" + std::to_string(nextSegment++);
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            lastError = "Cannot create blob segment " + path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        // Only the descriptor refers to the file from here on
+        ::unlink(path.c_str());
+        if (ftruncate(fd, static_cast<off_t>(capacity)) != 0)
+        {
+            lastError = "Cannot size blob segment " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return nullptr;
+        }
+        void *data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            lastError = "Cannot map blob segment " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return nullptr;
+        }
+        liveBytes->fetch_add(capacity, std::memory_order_relaxed);
+        return std::make_shared<BlobSegment>(fd, static_cast<char *>(data), capacity, liveBytes);
+#endif
+    }
+
+    BlobRef BlobStore::put(std::string_view bytes)
+    {
+        BlobRef ref;
+        if (bytes.empty() || bytes.size() > UINT32_MAX)
+        {
+            return ref;
+        }
+        if (bytes.size() > segmentBytes)
+        {
+            // A segment of its own, leaving the current one to smaller blobs
+            std::lock_guard<std::mutex> lock(mutex);
+            ref.segment = createSegment(bytes.size());
+            if (!ref.segment)
+            {
+                Logger::getInstance().log(LogLevel::ERR, lastError);
+                return ref;
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!current || current->capacity() - used < bytes.size())
+            {
+                // Sealing the old segment: it goes once its blobs do
+                current = createSegment(segmentBytes);
+                used = 0;
+                if (!current)
+                {
+                    Logger::getInstance().log(LogLevel::ERR, lastError);
+                    return ref;
+                }
+            }
+            ref.segment = current;
+            ref.offset = used;
+            used += bytes.size();
+        }
+        // The range is this caller's alone, so the copy needs no lock
+        std::memcpy(ref.segment->data() + ref.offset, bytes.data(), bytes.size());
+        ref.size = static_cast<uint32_t>(bytes.size());
+        return ref;
+    }
+
+} // namespace dtq
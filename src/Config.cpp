@@ -6,10 +6,50 @@ namespace dtq
 {
 
     const int Config::MaxQueueSize = 1000;
+    // With a queue latency target set, how long every task must wait longer than
+    // the target before new tasks are shed
+    const std::chrono::milliseconds Config::QueueLatencyInterval(100);
+    // Bounds on the retry-after hint sent with a task turned away by a full queue
+    const std::chrono::milliseconds Config::RetryAfterMin(20);
+    const std::chrono::milliseconds Config::RetryAfterMax(5000);
     const int Config::ThreadPoolSize = 4;
     const std::chrono::milliseconds Config::NetworkTimeout(5000);
+    // Largest frame payload a peer may send; a bigger size field drops the connection
+    const size_t Config::MaxFrameBytes = 256 * 1024 * 1024;
     const int Config::TaskRetryLimit = 3;
+    // An assigned task with no result after this long is redelivered
+    const std::chrono::milliseconds Config::LeaseTimeout(30000);
+    // A failed task is retried after base * 2^(retries so far), capped, with jitter
+    const std::chrono::milliseconds Config::RetryBackoffBase(500);
+    const std::chrono::milliseconds Config::RetryBackoffMax(60000);
+    // Tasks past TaskRetryLimit kept for inspection; the oldest are dropped beyond this
+    const size_t Config::DeadLetterCapacity = 10000;
+    // Registered workers heartbeat this often; one silent for HeartbeatMissLimit
+    // intervals is disconnected and its tasks are reclaimed
     const std::chrono::milliseconds Config::HeartbeatInterval(2000);
+    const int Config::HeartbeatMissLimit = 3;
+    const int Config::BatchSize = 8;
+    // Tasks a worker keeps queued locally beyond those running; each one's lease is already ticking
+    const int Config::WorkerPrefetch = 16;
+    // Finished tasks a process keeps to reuse their buffers for new ones
+    const size_t Config::TaskPoolCapacity = 4096;
+    // With a blob store, payloads and results at least this large are kept there instead of on the heap
+    const size_t Config::BlobThresholdBytes = 64 * 1024;
+    // Size of each memory-mapped blob store file
+    const size_t Config::BlobSegmentBytes = 64 * 1024 * 1024;
+    const std::chrono::milliseconds Config::LongPollTimeout(20000);
+    const int Config::PriorityLevels = 3;
+    // A task waiting this long moves up one priority level
+    const std::chrono::milliseconds Config::PriorityAgingInterval(5000);
+    // Deadline assumed for EDF ordering when a task has none
+    const std::chrono::milliseconds Config::DefaultTaskDeadline(60000);
+    // Finished task results are kept until either limit is reached
+    const size_t Config::ResultStoreBudgetBytes = 64 * 1024 * 1024;
+    const std::chrono::milliseconds Config::ResultTtl(10 * 60 * 1000);
+    // Longest a write-ahead log record waits for others to share its fsync
+    const std::chrono::microseconds Config::WalCommitWindow(200);
+    // Tasks with a future not-before time the server will hold at once
+    const size_t Config::MaxDelayedTasks = 4 * 1024 * 1024;
 
     bool Config::loadConfig(const std::string &filename)
     {
@@ -0,0 +1,110 @@
+#include "DeadLetterQueue.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace dtq
+{
+
+    int64_t retryBackoffMs(int retry, double jitter)
+    {
+        int64_t cap = Config::RetryBackoffMax.count();
+        int64_t delay = Config::RetryBackoffBase.count();
+        for (int i = 1; i < retry && delay < cap; ++i)
+        {
+            delay *= 2;
+        }
+        delay = std::min(delay, cap);
+        jitter = std::min(std::max(jitter, 0.0), 1.0);
+        return delay - delay / 2 + static_cast<int64_t>(static_cast<double>(delay / 2) * jitter);
+    }
+
+    DeadLetterQueue::DeadLetterQueue(size_t capacity)
+        : maxSize(capacity ? capacity : Config::DeadLetterCapacity)
+    {
+    }
+
+    bool DeadLetterQueue::add(Task &&task)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto existing = byId.find(task.taskId);
+        if (existing != byId.end())
+        {
+            entries.erase(existing->second);
+            byId.erase(existing);
+        }
+
+        bool kept = true;
+        if (entries.size() >= maxSize)
+        {
+            byId.erase(entries.front().taskId);
+            entries.pop_front();
+            ++droppedCount;
+            kept = false;
+        }
+        int taskId = task.taskId;
+        byId[taskId] = entries.insert(entries.end(), std::move(task));
+        return kept;
+    }
+
+    std::vector<Task> DeadLetterQueue::list(size_t max)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = max ? std::min(max, entries.size()) : entries.size();
+        std::vector<Task> out;
+        out.reserve(count);
+        for (auto it = entries.begin(); out.size() < count; ++it)
+        {
+            out.push_back(*it);
+        }
+        return out;
+    }
+
+    std::vector<Task> DeadLetterQueue::take(const std::vector<int> &taskIds)
+    {
+        std::vector<Task> out;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (taskIds.empty())
+        {
+            out.reserve(entries.size());
+            for (Task &task : entries)
+            {
+                out.push_back(std::move(task));
+            }
+            entries.clear();
+            byId.clear();
+            return out;
+        }
+
+        // One pass in queue order; an admin operation, so O(entries) is fine
+        std::unordered_set<int> wanted(taskIds.begin(), taskIds.end());
+        for (auto it = entries.begin(); it != entries.end() && !wanted.empty();)
+        {
+            if (wanted.erase(it->taskId))
+            {
+                byId.erase(it->taskId);
+                out.push_back(std::move(*it));
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return out;
+    }
+
+    size_t DeadLetterQueue::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    uint64_t DeadLetterQueue::dropped()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return droppedCount;
+    }
+
+} // namespace dtq
@@ -0,0 +1,59 @@
+#include "DelayedTaskQueue.h"
+#include "Config.h"
+
+namespace dtq
+{
+
+    DelayedTaskQueue::DelayedTaskQueue(int64_t nowMs, size_t capacity, std::chrono::milliseconds tick)
+        : maxSize(capacity ? capacity : Config::MaxDelayedTasks), wheel(tick.count(), nowMs)
+    {
+    }
+
+    bool DelayedTaskQueue::schedule(Task &&task, int64_t dueMs)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (wheel.size() >= maxSize)
+        {
+            return false;
+        }
+        uint32_t slot;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            slots[slot] = std::move(task);
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(std::move(task));
+        }
+        wheel.schedule(dueMs, slot);
+        return true;
+    }
+
+    std::vector<Task> DelayedTaskQueue::takeDue(int64_t nowMs)
+    {
+        std::vector<Task> due;
+        std::lock_guard<std::mutex> lock(mutex);
+        dueKeys.clear();
+        wheel.advance(nowMs, dueKeys);
+        due.reserve(dueKeys.size());
+        for (uint64_t key : dueKeys)
+        {
+            uint32_t slot = static_cast<uint32_t>(key);
+            due.push_back(std::move(slots[slot]));
+            // Release the moved-from strings' buffers, if any remain
+            slots[slot] = Task();
+            freeSlots.push_back(slot);
+        }
+        return due;
+    }
+
+    size_t DelayedTaskQueue::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return wheel.size();
+    }
+
+} // namespace dtq
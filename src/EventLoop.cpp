@@ -0,0 +1,169 @@
+#include "EventLoop.h"
+
+#ifdef __linux__
+
+#include "Logger.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace dtq
+{
+
+    EventLoop::EventLoop()
+        : epollFd(epoll_create1(EPOLL_CLOEXEC)), wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        if (!valid())
+        {
+            Logger::getInstance().log(LogLevel::ERR, "EventLoop setup failed: " + std::string(std::strerror(errno)));
+            return;
+        }
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr; // the wake fd is the only registration without a channel
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    }
+
+    EventLoop::~EventLoop()
+    {
+        if (wakeFd >= 0)
+            close(wakeFd);
+        if (epollFd >= 0)
+            close(epollFd);
+    }
+
+    bool EventLoop::add(int fd, uint32_t events, IoCallback callback)
+    {
+        auto channel = std::make_unique<Channel>();
+        channel->fd = fd;
+        channel->callback = std::move(callback);
+        channel->removed = false;
+
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = channel.get();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            return false;
+        }
+        channels[fd] = std::move(channel);
+        return true;
+    }
+
+    bool EventLoop::modify(int fd, uint32_t events)
+    {
+        auto it = channels.find(fd);
+        if (it == channels.end())
+        {
+            return false;
+        }
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = it->second.get();
+        return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+    }
+
+    void EventLoop::remove(int fd)
+    {
+        auto it = channels.find(fd);
+        if (it == channels.end())
+        {
+            return;
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        it->second->removed = true;
+        retired.push_back(std::move(it->second));
+        channels.erase(it);
+    }
+
+    void EventLoop::post(std::function<void()> fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(postMutex);
+            posted.push_back(std::move(fn));
+        }
+        wake();
+    }
+
+    void EventLoop::wake()
+    {
+        uint64_t one = 1;
+        ssize_t n = ::write(wakeFd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void EventLoop::runPosted()
+    {
+        std::vector<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(postMutex);
+            batch.swap(posted);
+        }
+        for (auto &fn : batch)
+        {
+            fn();
+        }
+    }
+
+    void EventLoop::run()
+    {
+        loopThread.store(std::this_thread::get_id());
+        running.store(true);
+
+        std::vector<epoll_event> events(256);
+        while (running.load())
+        {
+            int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                Logger::getInstance().log(LogLevel::ERR, "epoll_wait failed: " + std::string(std::strerror(errno)));
+                break;
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                Channel *channel = static_cast<Channel *>(events[i].data.ptr);
+                if (channel == nullptr)
+                {
+                    uint64_t counter;
+                    while (::read(wakeFd, &counter, sizeof(counter)) > 0)
+                    {
+                    }
+                    continue;
+                }
+                if (!channel->removed)
+                {
+                    channel->callback(events[i].events);
+                }
+            }
+            runPosted();
+            retired.clear();
+
+            if (n == static_cast<int>(events.size()))
+            {
+                events.resize(events.size() * 2);
+            }
+        }
+
+        // Drain anything posted during shutdown so captured resources are released
+        runPosted();
+        retired.clear();
+    }
+
+    void EventLoop::stop()
+    {
+        running.store(false);
+        wake();
+    }
+
+} // namespace dtq
+
+#endif // __linux__
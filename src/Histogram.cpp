@@ -0,0 +1,135 @@
+#include "Histogram.h"
+
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dtq
+{
+
+    namespace
+    {
+        // Index of the highest set bit; value must be non-zero
+        int highestBit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<int>(index);
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+    } // namespace
+
+    size_t Histogram::bucketFor(uint64_t value)
+    {
+        if (value < (uint64_t(1) << kSubBucketBits))
+        {
+            return static_cast<size_t>(value);
+        }
+        if (value >= (uint64_t(1) << kMaxExponent))
+        {
+            return kBuckets - 1;
+        }
+        int exponent = highestBit(value);
+        int shift = exponent - kSubBucketBits;
+        // value >> shift lies in [32, 64): the upper half of a linear range
+        return (static_cast<size_t>(shift) << kSubBucketBits) + static_cast<size_t>(value >> shift);
+    }
+
+    uint64_t Histogram::upperBound(size_t bucket)
+    {
+        if (bucket < (size_t(2) << kSubBucketBits))
+        {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket >> kSubBucketBits) - 1;
+        uint64_t top = (bucket & ((size_t(1) << kSubBucketBits) - 1)) + (uint64_t(1) << kSubBucketBits);
+        return ((top + 1) << shift) - 1;
+    }
+
+    Histogram::Snapshot Histogram::snapshot() const
+    {
+        Snapshot snap;
+        snap.counts.resize(kBuckets);
+        for (size_t i = 0; i < kBuckets; ++i)
+        {
+            snap.counts[i] = counts[i].load(std::memory_order_relaxed);
+            snap.total += snap.counts[i];
+        }
+        snap.sum = sum.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+    int64_t Histogram::Snapshot::percentile(double p) const
+    {
+        if (total == 0)
+        {
+            return 0;
+        }
+        p = std::min(std::max(p, 0.0), 100.0);
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return static_cast<int64_t>(upperBound(i));
+            }
+        }
+        return max();
+    }
+
+    int64_t Histogram::Snapshot::max() const
+    {
+        for (size_t i = counts.size(); i > 0; --i)
+        {
+            if (counts[i - 1] > 0)
+            {
+                return static_cast<int64_t>(upperBound(i - 1));
+            }
+        }
+        return 0;
+    }
+
+    double Histogram::Snapshot::mean() const
+    {
+        return total == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(total);
+    }
+
+    Histogram::Snapshot Histogram::Snapshot::since(const Snapshot &earlier) const
+    {
+        Snapshot delta = *this;
+        if (earlier.counts.size() != counts.size())
+        {
+            return delta;
+        }
+        delta.total = 0;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            // Counters only grow; guard against a torn read anyway
+            delta.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+            delta.total += delta.counts[i];
+        }
+        delta.sum = sum - earlier.sum;
+        return delta;
+    }
+
+    void Histogram::Snapshot::merge(const Snapshot &other)
+    {
+        if (counts.size() < other.counts.size())
+        {
+            counts.resize(other.counts.size());
+        }
+        for (size_t i = 0; i < other.counts.size(); ++i)
+        {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+    }
+
+} // namespace dtq
@@ -0,0 +1,105 @@
+#include "LeaseTable.h"
+
+namespace dtq
+{
+
+    LeaseTable::LeaseTable(std::chrono::milliseconds timeout, int64_t nowMs, std::chrono::milliseconds tick)
+        : leaseTimeout(timeout), wheel(tick.count(), nowMs), spareLeases(kSpareLeases)
+    {
+    }
+
+    void LeaseTable::grant(const Task &task, int64_t nowMs, uint64_t owner)
+    {
+        put(task, nowMs, owner);
+    }
+
+    void LeaseTable::grant(Task &&task, int64_t nowMs, uint64_t owner)
+    {
+        put(std::move(task), nowMs, owner);
+    }
+
+    template <typename T>
+    void LeaseTable::put(T &&task, int64_t nowMs, uint64_t owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        TimingWheel::TimerId timer = wheel.schedule(nowMs + leaseTimeout.count(), static_cast<uint32_t>(task.taskId));
+        auto result = spareLeases.findOrInsert(leases, task.taskId);
+        Lease &lease = result.first->second;
+        if (!result.second)
+        {
+            wheel.cancel(lease.timer);
+        }
+        lease.task = std::forward<T>(task);
+        lease.timer = timer;
+        lease.owner = owner;
+    }
+
+    bool LeaseTable::release(int taskId)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = leases.find(taskId);
+        if (it == leases.end())
+        {
+            return false;
+        }
+        wheel.cancel(it->second.timer);
+        spareLeases.erase(leases, it);
+        return true;
+    }
+
+    std::optional<Task> LeaseTable::revoke(int taskId)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = leases.find(taskId);
+        if (it == leases.end())
+        {
+            return std::nullopt;
+        }
+        return take(it);
+    }
+
+    std::optional<Task> LeaseTable::revoke(int taskId, uint64_t owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = leases.find(taskId);
+        if (it == leases.end() || it->second.owner != owner)
+        {
+            return std::nullopt;
+        }
+        return take(it);
+    }
+
+    // Ends the lease at it; mutex must be held
+    std::optional<Task> LeaseTable::take(LeaseMap::iterator it)
+    {
+        wheel.cancel(it->second.timer);
+        std::optional<Task> task(std::move(it->second.task));
+        spareLeases.erase(leases, it);
+        return task;
+    }
+
+    std::vector<Task> LeaseTable::expire(int64_t nowMs)
+    {
+        std::vector<Task> expired;
+        std::lock_guard<std::mutex> lock(mutex);
+        expiredKeys.clear();
+        wheel.advance(nowMs, expiredKeys);
+        for (uint64_t key : expiredKeys)
+        {
+            auto it = leases.find(static_cast<int>(static_cast<uint32_t>(key)));
+            if (it != leases.end())
+            {
+                expired.push_back(std::move(it->second.task));
+                spareLeases.erase(leases, it);
+            }
+        }
+        return expired;
+    }
+
+    size_t LeaseTable::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return leases.size();
+    }
+
+} // namespace dtq
@@ -1,8 +1,6 @@
 #include "Logger.h"
 #include <iostream>
-#include <chrono>
 #include <ctime>
-#include <sstream>
 
 namespace dtq
 {
@@ -15,10 +13,14 @@ namespace dtq
 
     Logger::Logger()
     {
+        tail = new Record();
+        head.store(tail, std::memory_order_relaxed);
     }
 
     Logger::~Logger()
     {
+        stopWriter();
+        delete tail;
         if (logFile.is_open())
         {
             logFile.close();
@@ -35,6 +37,46 @@ namespace dtq
         logFile.open(filename, std::ios::out | std::ios::app);
     }
 
+    void Logger::setMinLevel(LogLevel level)
+    {
+        minLevel.store(level, std::memory_order_relaxed);
+    }
+
+    void Logger::setAsync(bool enabled)
+    {
+        std::lock_guard<std::mutex> mode(modeMutex);
+        if (enabled == async.load())
+        {
+            return;
+        }
+        if (enabled)
+        {
+            stopping = false;
+            async.store(true);
+            writer = std::thread(&Logger::writerLoop, this);
+            return;
+        }
+
+        // New records now go out synchronously. Wait for producers that saw
+        // async mode to finish queueing, then let the writer drain and exit.
+        async.store(false);
+        while (producers.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+            wake.notify_all();
+        }
+        writer.join();
+    }
+
+    void Logger::stopWriter()
+    {
+        setAsync(false);
+    }
+
     std::string Logger::levelToString(LogLevel level)
     {
         switch (level)
@@ -50,25 +92,142 @@ namespace dtq
         }
     }
 
+    void Logger::appendLine(std::string &out, LogLevel level, std::chrono::system_clock::time_point time,
+                            const std::string &message)
+    {
+        // ctime() output only changes once a second, so it is formatted once per second
+        std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        if (seconds != cachedSecond)
+        {
+            cachedSecond = seconds;
+            cachedStamp = std::ctime(&seconds);
+            if (!cachedStamp.empty() && cachedStamp.back() == '\n')
+            {
+                cachedStamp.pop_back();
+            }
+        }
+
+        out += cachedStamp;
+        out += " [";
+        out += levelToString(level);
+        out += "] ";
+        out += message;
+        out += '\n';
+    }
+
+    void Logger::write(const std::string &lines)
+    {
+        std::cout.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+        std::cout.flush();
+        if (logFile.is_open())
+        {
+            logFile.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+            logFile.flush();
+        }
+    }
+
     void Logger::log(LogLevel level, const std::string &message)
     {
-        std::lock_guard<std::mutex> lock(logMutex);
+        if (!isEnabled(level))
+        {
+            return;
+        }
         auto now = std::chrono::system_clock::now();
-        std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-        std::string timeStr(std::ctime(&now_c));
-        if (!timeStr.empty() && timeStr.back() == '\n')
+
+        producers.fetch_add(1);
+        if (async.load())
         {
-            timeStr.pop_back();
+            Record *record = new Record();
+            record->level = level;
+            record->time = now;
+            record->message = message;
+            queued.fetch_add(1, std::memory_order_relaxed);
+            Record *prev = head.exchange(record, std::memory_order_acq_rel);
+            prev->next.store(record, std::memory_order_release);
+
+            // Pairs with the fence in writerLoop: either the writer sees this
+            // record before sleeping or we see it asleep
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (writerSleeping.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                wake.notify_one();
+            }
+            producers.fetch_sub(1);
+            return;
         }
+        producers.fetch_sub(1);
 
-        std::ostringstream oss;
-        oss << timeStr << " [" << levelToString(level) << "] " << message;
-        std::string logMsg = oss.str();
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::string line;
+        appendLine(line, level, now, message);
+        write(line);
+    }
 
-        std::cout << logMsg << std::endl;
-        if (logFile.is_open())
+    bool Logger::drain(std::string &batch)
+    {
+        bool any = false;
+        for (;;)
+        {
+            Record *next = tail->next.load(std::memory_order_acquire);
+            if (!next)
+            {
+                // head may have moved with next not yet linked; picked up next round
+                return any;
+            }
+            appendLine(batch, next->level, next->time, next->message);
+            delete tail;
+            tail = next; // next becomes the stub; its message is no longer needed
+            tail->message.clear();
+            written.fetch_add(1, std::memory_order_relaxed);
+            any = true;
+        }
+    }
+
+    void Logger::writerLoop()
+    {
+        std::string batch;
+        for (;;)
+        {
+            batch.clear();
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                if (drain(batch))
+                {
+                    write(batch);
+                }
+            }
+            if (!batch.empty())
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                flushed.notify_all();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (stopping && tail->next.load(std::memory_order_acquire) == nullptr)
+            {
+                break; // no producer can still be queueing, see setAsync()
+            }
+            writerSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tail->next.load(std::memory_order_acquire) == nullptr && !stopping)
+            {
+                // The timeout covers a producer that linked its record late
+                wake.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            writerSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void Logger::flush()
+    {
+        unsigned long long target = queued.load();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        while (async.load() && written.load() < target)
         {
-            logFile << logMsg << std::endl;
+            wake.notify_one();
+            flushed.wait_for(lock, std::chrono::milliseconds(10));
         }
     }
 
@@ -0,0 +1,375 @@
+#include "Metrics.h"
+#include "Wire.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace dtq
+{
+
+    const char *stageName(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage::Submit:
+            return "submit";
+        case Stage::Queue:
+            return "queue";
+        case Stage::Dispatch:
+            return "dispatch";
+        case Stage::Execute:
+            return "execute";
+        case Stage::Report:
+            return "report";
+        case Stage::EndToEnd:
+            return "end-to-end";
+        default:
+            return "unknown";
+        }
+    }
+
+    namespace
+    {
+        const int64_t kMicrosPerSecond = 1000000;
+
+        uint64_t pack(int64_t second, uint64_t count)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(second)) << 32) | (count & 0xffffffffu);
+        }
+
+        bool sameSecond(uint64_t slot, int64_t second)
+        {
+            return static_cast<uint32_t>(slot >> 32) == static_cast<uint32_t>(second);
+        }
+
+        // Threads take slots round-robin in the order they first count something
+        size_t threadSlot(size_t slots)
+        {
+            static std::atomic<size_t> nextThread{0};
+            thread_local size_t index = nextThread.fetch_add(1, std::memory_order_relaxed);
+            return index % slots;
+        }
+    } // namespace
+
+    void Counter::add(uint64_t n)
+    {
+        slots[threadSlot(kSlots)].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Counter::value() const
+    {
+        uint64_t total = 0;
+        for (const Slot &slot : slots)
+        {
+            total += slot.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    ThroughputWindow::ThroughputWindow(int windowSeconds, int64_t nowUs)
+        : window(std::min(std::max(windowSeconds, 1), kSlots - 1)), startSecond(nowUs / kMicrosPerSecond)
+    {
+        // Stamp every slot with a second outside any window we will read
+        for (auto &slot : slots)
+        {
+            slot.store(pack(startSecond - kSlots, 0), std::memory_order_relaxed);
+        }
+    }
+
+    void ThroughputWindow::add(uint64_t n, int64_t nowUs)
+    {
+        int64_t second = nowUs / kMicrosPerSecond;
+        std::atomic<uint64_t> &slot = slots[static_cast<size_t>(second % kSlots)];
+        uint64_t current = slot.load(std::memory_order_relaxed);
+        uint64_t next;
+        do
+        {
+            // The first add in a new second starts the slot over
+            next = sameSecond(current, second) ? current + n : pack(second, n);
+        } while (!slot.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    }
+
+    double ThroughputWindow::perSecond(int64_t nowUs) const
+    {
+        int64_t now = nowUs / kMicrosPerSecond;
+        int64_t seconds = std::min<int64_t>(window, now - startSecond);
+        if (seconds <= 0)
+        {
+            return 0.0;
+        }
+        uint64_t total = 0;
+        for (int64_t second = now - seconds; second < now; ++second)
+        {
+            uint64_t slot = slots[static_cast<size_t>(second % kSlots)].load(std::memory_order_relaxed);
+            if (sameSecond(slot, second))
+            {
+                total += slot & 0xffffffffu;
+            }
+        }
+        return static_cast<double>(total) / static_cast<double>(seconds);
+    }
+
+    void LifecycleMetrics::recordCompletion(const TaskTrace &trace, int64_t confirmedUs)
+    {
+        auto interval = [this](Stage stage, int64_t from, int64_t to) {
+            // Unset stamps, or stamps from another host's clock, are skipped
+            if (from > 0 && to >= from)
+            {
+                stages[static_cast<size_t>(stage)].record(to - from);
+            }
+        };
+        interval(Stage::Submit, trace.submittedUs, trace.enqueuedUs);
+        interval(Stage::Queue, trace.enqueuedUs, trace.assignedUs);
+        interval(Stage::Dispatch, trace.assignedUs, trace.receivedUs);
+        interval(Stage::Execute, trace.receivedUs, trace.completedUs);
+        interval(Stage::Report, trace.completedUs, confirmedUs);
+        interval(Stage::EndToEnd, trace.submittedUs, confirmedUs);
+        completions.add(1, confirmedUs);
+    }
+
+    Histogram::Snapshot LifecycleMetrics::snapshot(Stage stage) const
+    {
+        return stages[static_cast<size_t>(stage)].snapshot();
+    }
+
+    std::string LifecycleMetrics::describe(Stage stage, const Histogram::Snapshot &snapshot)
+    {
+        std::string out = stageName(stage);
+        out += " n=" + std::to_string(snapshot.total);
+        out += " p50=" + std::to_string(snapshot.percentile(50)) + "us";
+        out += " p90=" + std::to_string(snapshot.percentile(90)) + "us";
+        out += " p99=" + std::to_string(snapshot.percentile(99)) + "us";
+        out += " p999=" + std::to_string(snapshot.percentile(99.9)) + "us";
+        return out;
+    }
+
+    void StatsSnapshot::setStage(Stage stage, const Histogram::Snapshot &snapshot)
+    {
+        StageStats &out = stages[static_cast<size_t>(stage)];
+        out.count = snapshot.total;
+        out.sumUs = snapshot.sum;
+        out.p50 = snapshot.percentile(50);
+        out.p90 = snapshot.percentile(90);
+        out.p99 = snapshot.percentile(99);
+        out.p999 = snapshot.percentile(99.9);
+    }
+
+    void StatsSnapshot::encode(std::string &out) const
+    {
+        wire::putU64(out, queueDepth);
+        wire::putU64(out, inFlight);
+        wire::putU64(out, accepted);
+        wire::putU64(out, rejected);
+        wire::putU64(out, completed);
+        wire::putU64(out, failed);
+        wire::putF64(out, tasksPerSec);
+        wire::putU32(out, static_cast<uint32_t>(shardDepths.size()));
+        for (uint64_t depth : shardDepths)
+        {
+            wire::putU64(out, depth);
+        }
+        wire::putU32(out, static_cast<uint32_t>(stages.size()));
+        for (const StageStats &stage : stages)
+        {
+            wire::putU64(out, stage.count);
+            wire::putI64(out, stage.sumUs);
+            wire::putI64(out, stage.p50);
+            wire::putI64(out, stage.p90);
+            wire::putI64(out, stage.p99);
+            wire::putI64(out, stage.p999);
+        }
+        wire::putU32(out, static_cast<uint32_t>(workers.size()));
+        for (const WorkerStats &worker : workers)
+        {
+            wire::putU64(out, worker.sessionId);
+            wire::putU64(out, worker.completed);
+            wire::putF64(out, worker.tasksPerSec);
+        }
+        wire::putU64(out, delayed);
+        wire::putU64(out, retried);
+        wire::putU64(out, deadLetters);
+        wire::putU64(out, shed);
+        wire::putU64(out, queueBytes);
+        wire::putU64(out, blobBytes);
+    }
+
+    bool StatsSnapshot::decode(std::string_view data, StatsSnapshot &stats)
+    {
+        wire::Reader in(data);
+        uint32_t count = 0;
+        if (!in.getU64(stats.queueDepth) || !in.getU64(stats.inFlight) || !in.getU64(stats.accepted) ||
+            !in.getU64(stats.rejected) || !in.getU64(stats.completed) || !in.getU64(stats.failed) ||
+            !in.getF64(stats.tasksPerSec) || !in.getU32(count) || in.remaining() / 8 < count)
+        {
+            return false;
+        }
+        stats.shardDepths.resize(count);
+        for (uint64_t &depth : stats.shardDepths)
+        {
+            in.getU64(depth);
+        }
+
+        if (!in.getU32(count))
+        {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            StageStats stage;
+            if (!in.getU64(stage.count) || !in.getI64(stage.sumUs) || !in.getI64(stage.p50) ||
+                !in.getI64(stage.p90) || !in.getI64(stage.p99) || !in.getI64(stage.p999))
+            {
+                return false;
+            }
+            // Stages this build does not know about are skipped
+            if (i < stats.stages.size())
+            {
+                stats.stages[i] = stage;
+            }
+        }
+
+        if (!in.getU32(count) || in.remaining() / 24 < count)
+        {
+            return false;
+        }
+        stats.workers.resize(count);
+        for (WorkerStats &worker : stats.workers)
+        {
+            in.getU64(worker.sessionId);
+            in.getU64(worker.completed);
+            in.getF64(worker.tasksPerSec);
+        }
+        // Older servers end at one of these points
+        stats.delayed = stats.retried = stats.deadLetters = stats.shed = stats.queueBytes = stats.blobBytes = 0;
+        if (in.remaining() == 0)
+        {
+            return true;
+        }
+        if (!in.getU64(stats.delayed))
+        {
+            return false;
+        }
+        if (in.remaining() == 0)
+        {
+            return true;
+        }
+        if (!in.getU64(stats.retried) || !in.getU64(stats.deadLetters))
+        {
+            return false;
+        }
+        if (in.remaining() == 0)
+        {
+            return true;
+        }
+        if (!in.getU64(stats.shed))
+        {
+            return false;
+        }
+        if (in.remaining() == 0)
+        {
+            return true;
+        }
+        if (!in.getU64(stats.queueBytes))
+        {
+            return false;
+        }
+        return in.remaining() == 0 || in.getU64(stats.blobBytes);
+    }
+
+    namespace
+    {
+        void metric(std::string &out, const char *name, const char *type, const char *help)
+        {
+            out += "# HELP ";
+            out += name;
+            out += ' ';
+            out += help;
+            out += "\n# TYPE ";
+            out += name;
+            out += ' ';
+            out += type;
+            out += '\n';
+        }
+
+        void sample(std::string &out, const std::string &series, double value)
+        {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%.10g", value);
+            out += series;
+            out += ' ';
+            out += number;
+            out += '\n';
+        }
+    } // namespace
+
+    std::string StatsSnapshot::toPrometheus() const
+    {
+        std::string out;
+        metric(out, "dtq_queue_depth", "gauge", "Tasks waiting in the queue.");
+        sample(out, "dtq_queue_depth", static_cast<double>(queueDepth));
+        metric(out, "dtq_queue_shard_depth", "gauge", "Tasks waiting in each queue shard.");
+        for (size_t i = 0; i < shardDepths.size(); ++i)
+        {
+            sample(out, "dtq_queue_shard_depth{shard=\"" + std::to_string(i) + "\"}",
+                   static_cast<double>(shardDepths[i]));
+        }
+        metric(out, "dtq_queue_bytes", "gauge", "Memory taken by queued tasks, payloads included.");
+        sample(out, "dtq_queue_bytes", static_cast<double>(queueBytes));
+        metric(out, "dtq_queue_bytes_per_task", "gauge", "Average memory per queued task; 0 when the queue is empty.");
+        sample(out, "dtq_queue_bytes_per_task",
+               queueDepth ? static_cast<double>(queueBytes) / static_cast<double>(queueDepth) : 0.0);
+        metric(out, "dtq_blob_bytes", "gauge", "Size of the blob store segments holding large payloads and results.");
+        sample(out, "dtq_blob_bytes", static_cast<double>(blobBytes));
+        metric(out, "dtq_delayed_tasks", "gauge", "Tasks held until their not-before time.");
+        sample(out, "dtq_delayed_tasks", static_cast<double>(delayed));
+        metric(out, "dtq_tasks_in_flight", "gauge", "Tasks assigned to workers and not yet finished.");
+        sample(out, "dtq_tasks_in_flight", static_cast<double>(inFlight));
+        metric(out, "dtq_tasks_accepted_total", "counter", "Tasks accepted into the queue.");
+        sample(out, "dtq_tasks_accepted_total", static_cast<double>(accepted));
+        metric(out, "dtq_tasks_rejected_total", "counter", "Tasks rejected by the queue.");
+        sample(out, "dtq_tasks_rejected_total", static_cast<double>(rejected));
+        metric(out, "dtq_tasks_shed_total", "counter", "Tasks rejected because queueing delay stayed over the latency target.");
+        sample(out, "dtq_tasks_shed_total", static_cast<double>(shed));
+        metric(out, "dtq_tasks_completed_total", "counter", "Results reported as completed.");
+        sample(out, "dtq_tasks_completed_total", static_cast<double>(completed));
+        metric(out, "dtq_tasks_failed_total", "counter", "Tasks failed for good: reported failed or out of retries.");
+        sample(out, "dtq_tasks_failed_total", static_cast<double>(failed));
+        metric(out, "dtq_tasks_retried_total", "counter", "Failures and lease expiries retried with backoff.");
+        sample(out, "dtq_tasks_retried_total", static_cast<double>(retried));
+        metric(out, "dtq_dead_letter_tasks", "gauge", "Tasks in the dead-letter queue.");
+        sample(out, "dtq_dead_letter_tasks", static_cast<double>(deadLetters));
+        metric(out, "dtq_tasks_per_second", "gauge", "Results per second over the last 10 seconds.");
+        sample(out, "dtq_tasks_per_second", tasksPerSec);
+
+        metric(out, "dtq_stage_latency_seconds", "summary", "Time spent in each task lifecycle stage.");
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            const StageStats &stage = stages[i];
+            std::string label = std::string("stage=\"") + stageName(static_cast<Stage>(i)) + "\"";
+            const std::pair<const char *, int64_t> quantiles[] = {
+                {"0.5", stage.p50}, {"0.9", stage.p90}, {"0.99", stage.p99}, {"0.999", stage.p999}};
+            for (const auto &quantile : quantiles)
+            {
+                sample(out, "dtq_stage_latency_seconds{" + label + ",quantile=\"" + quantile.first + "\"}",
+                       quantile.second / 1e6);
+            }
+            sample(out, "dtq_stage_latency_seconds_sum{" + label + "}", stage.sumUs / 1e6);
+            sample(out, "dtq_stage_latency_seconds_count{" + label + "}", static_cast<double>(stage.count));
+        }
+
+        metric(out, "dtq_worker_tasks_completed_total", "counter", "Results submitted by each worker connection.");
+        for (const WorkerStats &worker : workers)
+        {
+            sample(out, "dtq_worker_tasks_completed_total{session=\"" + std::to_string(worker.sessionId) + "\"}",
+                   static_cast<double>(worker.completed));
+        }
+        metric(out, "dtq_worker_tasks_per_second", "gauge", "Results per second from each worker connection.");
+        for (const WorkerStats &worker : workers)
+        {
+            sample(out, "dtq_worker_tasks_per_second{session=\"" + std::to_string(worker.sessionId) + "\"}",
+                   worker.tasksPerSec);
+        }
+        return out;
+    }
+
+} // namespace dtq
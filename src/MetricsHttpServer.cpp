@@ -0,0 +1,179 @@
+#include "MetricsHttpServer.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+#undef ERROR
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace dtq
+{
+
+    namespace
+    {
+        const size_t kMaxRequestBytes = 8192;
+#ifdef MSG_NOSIGNAL
+        const int kSendFlags = MSG_NOSIGNAL; // a scraper hanging up must not raise SIGPIPE
+#else
+        const int kSendFlags = 0;
+#endif
+
+        bool sendAll(SOCKET sock, const std::string &data)
+        {
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                int n = ::send(sock, data.data() + sent, static_cast<int>(data.size() - sent), kSendFlags);
+                if (n <= 0)
+                {
+                    return false;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        std::string response(const char *status, const std::string &body)
+        {
+            std::string out = "HTTP/1.1 ";
+            out += status;
+            out += "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: ";
+            out += std::to_string(body.size());
+            out += "\r\nConnection: close\r\n\r\n";
+            out += body;
+            return out;
+        }
+    } // namespace
+
+    MetricsHttpServer::MetricsHttpServer(int port) : listenPort(port), listenSocket(INVALID_SOCKET) {}
+
+    MetricsHttpServer::~MetricsHttpServer()
+    {
+        stop();
+    }
+
+    bool MetricsHttpServer::start(Render renderFn)
+    {
+        render = std::move(renderFn);
+        stopping.store(false);
+
+        listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == INVALID_SOCKET)
+        {
+            lastError = "Metrics socket creation failed";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(static_cast<unsigned short>(listenPort));
+        if (bind(listenSocket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == SOCKET_ERROR ||
+            listen(listenSocket, 16) == SOCKET_ERROR)
+        {
+            lastError = "Metrics listener failed: " + std::to_string(Network::lastSocketError());
+            Network::closeSocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        if (getsockname(listenSocket, reinterpret_cast<sockaddr *>(&addr), &len) == 0)
+        {
+            listenPort = ntohs(addr.sin_port);
+        }
+
+        acceptThread = std::thread(&MetricsHttpServer::acceptLoop, this);
+        return true;
+    }
+
+    void MetricsHttpServer::stop()
+    {
+        if (stopping.exchange(true))
+        {
+            return;
+        }
+        if (listenSocket != INVALID_SOCKET)
+        {
+            // Wakes the blocked accept()
+            shutdown(listenSocket, SHUT_RDWR);
+        }
+        if (acceptThread.joinable())
+        {
+            acceptThread.join();
+        }
+        if (listenSocket != INVALID_SOCKET)
+        {
+            Network::closeSocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+        }
+    }
+
+    void MetricsHttpServer::acceptLoop()
+    {
+        while (!stopping.load())
+        {
+            SOCKET client = accept(listenSocket, nullptr, nullptr);
+            if (client == INVALID_SOCKET)
+            {
+                if (!stopping.load())
+                {
+                    Logger::getInstance().log(LogLevel::ERR, "Metrics accept failed: " + std::to_string(Network::lastSocketError()));
+                }
+                continue;
+            }
+            serve(client);
+            Network::closeSocket(client);
+        }
+    }
+
+    void MetricsHttpServer::serve(SOCKET client)
+    {
+        // A scraper that connects and sends nothing must not stall the listener
+#ifdef _WIN32
+        DWORD timeoutMs = 1000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeoutMs, sizeof(timeoutMs));
+#else
+        timeval timeout{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+        // Only the request line matters; read until the end of the headers
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestBytes)
+        {
+            int n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+            {
+                return;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+
+        std::string line = request.substr(0, request.find("\r\n"));
+        if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET /metrics?", 0) == 0)
+        {
+            sendAll(client, response("200 OK", render()));
+        }
+        else
+        {
+            sendAll(client, response("404 Not Found", "Not found; try /metrics\n"));
+        }
+    }
+
+} // namespace dtq
@@ -1,4 +1,5 @@
 #include "Network.h"
+#include "Config.h"
 #include "Logger.h"
 
 #ifdef _WIN32
@@ -9,14 +10,27 @@ typedef int socklen_t;
 #undef ERROR
 #else
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <cstring>
 #include <string>
-#include <vector>
+#include <thread>
+
+#ifdef MSG_NOSIGNAL
+static const int kSendFlags = MSG_NOSIGNAL; // a peer reset must not raise SIGPIPE
+#else
+static const int kSendFlags = 0;
+#endif
 
 namespace dtq
 {
@@ -38,50 +52,72 @@ namespace dtq
 #endif
     }
 
-    void Network::Connection::disconnect()
+    void Network::closeSocket(SOCKET sock)
     {
-        if (socketDescriptor != INVALID_SOCKET)
-        {
 #ifdef _WIN32
-            closesocket(socketDescriptor);
+        closesocket(sock);
 #else
-            close(socketDescriptor);
+        close(sock);
 #endif
+    }
+
+    int Network::lastSocketError()
+    {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    void Network::Connection::disconnect()
+    {
+        if (socketDescriptor != INVALID_SOCKET)
+        {
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
         }
+        // Bytes of the old connection must not be read as frames of the next
+        recvBegin = recvEnd = 0;
     }
 
     bool Network::Connection::connect()
     {
         if (socketDescriptor != INVALID_SOCKET)
         {
-            lastError = "Already connected";
+            setLastError("Already connected");
             return false;
         }
 
         socketDescriptor = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
         if (socketDescriptor == INVALID_SOCKET)
         {
-            lastError = "Failed to create socket";
+            setLastError("Failed to create socket");
             return false;
         }
 
         // Set keep-alive to detect disconnections
-        BOOL keepAlive = TRUE;
+        int keepAlive = 1;
         if (setsockopt(socketDescriptor, SOL_SOCKET, SO_KEEPALIVE, (char*)&keepAlive, sizeof(keepAlive)) == SOCKET_ERROR)
         {
-            lastError = "Failed to set keep-alive";
-            closesocket(socketDescriptor);
+            setLastError("Failed to set keep-alive");
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
             return false;
         }
 
         // Set receive timeout to 10 seconds (increased from 5)
+#ifdef _WIN32
         DWORD timeout = 10000; // 10 seconds
+#else
+        timeval timeout;
+        timeout.tv_sec = 10;
+        timeout.tv_usec = 0;
+#endif
         if (setsockopt(socketDescriptor, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout)) == SOCKET_ERROR)
         {
-            lastError = "Failed to set receive timeout";
-            closesocket(socketDescriptor);
+            setLastError("Failed to set receive timeout");
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
             return false;
         }
@@ -89,32 +125,32 @@ namespace dtq
         // Set send timeout to 10 seconds
         if (setsockopt(socketDescriptor, SOL_SOCKET, SO_SNDTIMEO, (char*)&timeout, sizeof(timeout)) == SOCKET_ERROR)
         {
-            lastError = "Failed to set send timeout";
-            closesocket(socketDescriptor);
+            setLastError("Failed to set send timeout");
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
             return false;
         }
 
         // Disable Nagle's algorithm for better responsiveness
-        BOOL noDelay = TRUE;
+        int noDelay = 1;
         if (setsockopt(socketDescriptor, IPPROTO_TCP, TCP_NODELAY, (char*)&noDelay, sizeof(noDelay)) == SOCKET_ERROR)
         {
-            lastError = "Failed to disable Nagle's algorithm";
-            closesocket(socketDescriptor);
+            setLastError("Failed to disable Nagle's algorithm");
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
             return false;
         }
 
         sockaddr_in addr;
-        ZeroMemory(&addr, sizeof(addr));
+        std::memset(&addr, 0, sizeof(addr));
         addr.sin_family = AF_INET;
         addr.sin_port = htons(serverPort);
         addr.sin_addr.s_addr = inet_addr(serverAddress.c_str());
 
         if (::connect(socketDescriptor, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR)
         {
-            lastError = "Connect failed: " + std::to_string(WSAGetLastError());
-            closesocket(socketDescriptor);
+            setLastError("Connect failed: " + std::to_string(lastSocketError()));
+            closeSocket(socketDescriptor);
             socketDescriptor = INVALID_SOCKET;
             return false;
         }
@@ -122,128 +158,420 @@ namespace dtq
         return true;
     }
 
-    bool Network::Connection::send(const char* data, int size)
+    bool Network::Connection::sendFrame(const FrameHeader &header, const std::string &payload)
     {
-        int totalSent = 0;
-        int remainingBytes = size;
-        int maxRetries = 3;
-        int retries = 0;
-
-        while (totalSent < size)
+        // Header and payload go out in one gathered write; a short write
+        // resumes where it stopped
+        const char *parts[2] = {reinterpret_cast<const char *>(&header), payload.data()};
+        size_t lengths[2] = {sizeof(header), payload.size()};
+        size_t first = 0;
+        while (first < 2)
         {
-            int sent = ::send(socketDescriptor, data + totalSent, remainingBytes, 0);
+            if (lengths[first] == 0)
+            {
+                ++first;
+                continue;
+            }
+#ifdef _WIN32
+            WSABUF buffers[2];
+            DWORD count = 0;
+            for (size_t i = first; i < 2; ++i)
+            {
+                buffers[count].buf = const_cast<char *>(parts[i]);
+                buffers[count].len = static_cast<ULONG>(lengths[i]);
+                ++count;
+            }
+            DWORD sentBytes = 0;
+            long long sent = WSASend(socketDescriptor, buffers, count, &sentBytes, 0, nullptr, nullptr) == 0
+                                 ? static_cast<long long>(sentBytes)
+                                 : -1;
+            ++sendCallCount;
+#else
+            iovec buffers[2];
+            size_t count = 0;
+            for (size_t i = first; i < 2; ++i)
+            {
+                buffers[count].iov_base = const_cast<char *>(parts[i]);
+                buffers[count].iov_len = lengths[i];
+                ++count;
+            }
+            msghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_iov = buffers;
+            message.msg_iovlen = count;
+            long long sent = ::sendmsg(socketDescriptor, &message, kSendFlags);
+            ++sendCallCount;
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
             if (sent <= 0)
             {
-                // Check if we should retry
-                if (retries < maxRetries)
-                {
-                    retries++;
-                    // Small delay before retry
-                    Sleep(100);
-                    continue;
-                }
-                
-                lastError = "Send failed: " + std::to_string(WSAGetLastError());
+                // A timeout (SO_SNDTIMEO) or a dead peer; retrying would not help
+                setLastError("Send failed: " + std::to_string(lastSocketError()));
                 return false;
             }
-            
-            totalSent += sent;
-            remainingBytes -= sent;
-            retries = 0; // Reset retry counter on successful send
+            size_t done = static_cast<size_t>(sent);
+            for (size_t i = first; i < 2 && done > 0; ++i)
+            {
+                size_t taken = std::min(done, lengths[i]);
+                parts[i] += taken;
+                lengths[i] -= taken;
+                done -= taken;
+            }
         }
         return true;
     }
 
-    bool Network::Connection::recvAll(char* buffer, int size)
+    long long Network::Connection::receiveSome(char *buffer, size_t size)
     {
-        int totalReceived = 0;
-        int remainingBytes = size;
-        int maxRetries = 3;
-        int retries = 0;
+        int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+        for (;;)
+        {
+            int received = ::recv(socketDescriptor, buffer, chunk, 0);
+            ++recvCallCount;
+            if (received > 0)
+            {
+                return received;
+            }
+#ifndef _WIN32
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            setLastError(received == 0 ? "Connection closed by peer"
+                                       : "Receive failed: " + std::to_string(lastSocketError()));
+            return received;
+        }
+    }
 
-        while (totalReceived < size)
+    bool Network::Connection::fillBuffer(size_t bytes)
+    {
+        if (recvEnd - recvBegin >= bytes)
         {
-            int received = ::recv(socketDescriptor, buffer + totalReceived, remainingBytes, 0);
+            return true;
+        }
+        if (!recvBuffer)
+        {
+            recvBuffer.reset(new char[kReceiveBufferBytes]);
+        }
+        // Move the unread bytes to the front once the rest would not fit behind them
+        if (kReceiveBufferBytes - recvBegin < bytes)
+        {
+            std::memmove(recvBuffer.get(), recvBuffer.get() + recvBegin, recvEnd - recvBegin);
+            recvEnd -= recvBegin;
+            recvBegin = 0;
+        }
+        // Each recv() asks for all the room there is, picking up whatever
+        // frames have arrived behind this one
+        while (recvEnd - recvBegin < bytes)
+        {
+            long long received = receiveSome(recvBuffer.get() + recvEnd, kReceiveBufferBytes - recvEnd);
             if (received <= 0)
             {
-                // Check if we should retry
-                if (retries < maxRetries && received == 0)
-                {
-                    retries++;
-                    // Small delay before retry
-                    Sleep(100);
-                    continue;
-                }
-                
-                lastError = "Receive failed or connection closed: " + std::to_string(WSAGetLastError());
                 return false;
             }
-            
-            totalReceived += received;
-            remainingBytes -= received;
-            retries = 0; // Reset retry counter on successful receive
+            recvEnd += static_cast<size_t>(received);
         }
         return true;
     }
 
     bool Network::Connection::sendMessage(MessageType type, const std::string& payload)
     {
-        // First send the message type
-        if (!send((const char*)&type, sizeof(type)))
+        return sendMessage(type, 0, payload);
+    }
+
+    bool Network::Connection::sendMessage(MessageType type, uint32_t requestId, const std::string& payload)
+    {
+        if (payload.size() > Config::MaxFrameBytes)
         {
+            setLastError("Payload of " + std::to_string(payload.size()) + " bytes exceeds the frame size limit");
             return false;
         }
+        FrameHeader header;
+        header.type = static_cast<int32_t>(type);
+        header.requestId = requestId;
+        header.size = static_cast<int32_t>(payload.size());
+        return sendFrame(header, payload);
+    }
+
+    bool Network::Connection::receiveMessage(MessageType& type, std::string& payload)
+    {
+        uint32_t requestId;
+        return receiveMessage(type, requestId, payload);
+    }
 
-        // Then send the payload size
-        int size = static_cast<int>(payload.size());
-        if (!send((const char*)&size, sizeof(size)))
+    bool Network::Connection::receiveMessage(MessageType& type, uint32_t& requestId, std::string& payload)
+    {
+        if (!fillBuffer(sizeof(FrameHeader)))
         {
             return false;
         }
+        FrameHeader header;
+        std::memcpy(&header, recvBuffer.get() + recvBegin, sizeof(header));
+        recvBegin += sizeof(header);
 
-        // Finally send the payload if there is one
-        if (size > 0)
+        // A bogus size must not turn into a huge allocation
+        if (header.size < 0 || static_cast<size_t>(header.size) > Config::MaxFrameBytes)
         {
-            if (!send(payload.c_str(), size))
+            setLastError("Frame size " + std::to_string(header.size) + " is out of bounds");
+            return false;
+        }
+        type = static_cast<MessageType>(header.type);
+        requestId = header.requestId;
+        size_t size = static_cast<size_t>(header.size);
+
+        if (size <= kReceiveBufferBytes)
+        {
+            if (!fillBuffer(size))
             {
                 return false;
             }
+            payload.assign(recvBuffer.get() + recvBegin, size);
+            recvBegin += size;
+            return true;
         }
 
+        // A large body: take what is buffered, then read the rest straight into payload
+        size_t buffered = recvEnd - recvBegin;
+        payload.resize(size);
+        std::memcpy(&payload[0], recvBuffer.get() + recvBegin, buffered);
+        recvBegin = recvEnd = 0;
+        while (buffered < size)
+        {
+            long long received = receiveSome(&payload[buffered], size - buffered);
+            if (received <= 0)
+            {
+                return false;
+            }
+            buffered += static_cast<size_t>(received);
+        }
         return true;
     }
 
-    bool Network::Connection::receiveMessage(MessageType& type, std::string& payload)
+    void Network::Connection::shutdown()
     {
-        // First receive the message type
-        if (!recvAll((char*)&type, sizeof(type)))
+        if (socketDescriptor != INVALID_SOCKET)
         {
-            return false;
+#ifdef _WIN32
+            ::shutdown(socketDescriptor, SD_BOTH);
+#else
+            ::shutdown(socketDescriptor, SHUT_RDWR);
+#endif
         }
+    }
 
-        // Then receive the payload size
-        int size;
-        if (!recvAll((char*)&size, sizeof(size)))
+    bool Network::Connection::setReceiveTimeout(std::chrono::milliseconds timeout)
+    {
+#ifdef _WIN32
+        DWORD value = static_cast<DWORD>(timeout.count());
+#else
+        timeval value;
+        value.tv_sec = static_cast<long>(timeout.count() / 1000);
+        value.tv_usec = static_cast<long>((timeout.count() % 1000) * 1000);
+#endif
+        if (setsockopt(socketDescriptor, SOL_SOCKET, SO_RCVTIMEO, (char*)&value, sizeof(value)) == SOCKET_ERROR)
         {
+            setLastError("Failed to set receive timeout");
             return false;
         }
+        return true;
+    }
+
+    void Network::Connection::setLastError(const std::string &error)
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = error;
+    }
+
+    std::string Network::Connection::getLastError() const
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        return lastError;
+    }
+
+    Network::Client::Client(const std::string &serverAddr, int port)
+        : conn(serverAddr, port)
+    {
+    }
+
+    Network::Client::~Client()
+    {
+        disconnect();
+    }
+
+    bool Network::Client::connect()
+    {
+        std::lock_guard<std::mutex> lock(connectMutex);
+        if (connected.load())
+        {
+            return true;
+        }
 
-        // Finally receive the payload if there is one
-        if (size > 0)
+        // Reap the reader of a previous, broken connection
+        if (reader.joinable())
         {
-            std::vector<char> buffer(size);
-            if (!recvAll(buffer.data(), size))
+            reader.join();
+        }
+        {
+            std::lock_guard<std::mutex> sendLock(sendMutex);
+            conn.disconnect();
+            if (!conn.connect())
             {
+                setLastError(conn.getLastError());
                 return false;
             }
-            payload.assign(buffer.begin(), buffer.end());
+            // Responses may legitimately take longer than any fixed timeout
+            // (e.g. a worker idling between tasks); liveness comes from keep-alive.
+            conn.setReceiveTimeout(std::chrono::milliseconds(0));
+        }
+
+        {
+            std::lock_guard<std::mutex> pendingLock(pendingMutex);
+            connected.store(true);
+        }
+        connects.fetch_add(1);
+        reader = std::thread(&Client::readerLoop, this);
+        return true;
+    }
+
+    void Network::Client::disconnect()
+    {
+        std::lock_guard<std::mutex> lock(connectMutex);
+        conn.shutdown();
+        if (reader.joinable())
+        {
+            reader.join();
+        }
+        {
+            std::lock_guard<std::mutex> sendLock(sendMutex);
+            conn.disconnect();
+        }
+        failPending("Disconnected");
+    }
+
+    std::future<Message> Network::Client::request(MessageType type, const std::string &payload)
+    {
+        std::promise<Message> promise;
+        std::future<Message> future = promise.get_future();
+
+        // 0 is reserved for uncorrelated frames, the top bit for server pushes
+        uint32_t requestId = ++nextRequestId & ~kServerRequestBit;
+        if (requestId == 0)
+        {
+            requestId = ++nextRequestId & ~kServerRequestBit;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (!connected.load())
+            {
+                promise.set_value(Message());
+                return future;
+            }
+            pending.emplace(requestId, std::move(promise));
+        }
+
+        std::lock_guard<std::mutex> lock(sendMutex);
+        if (!conn.sendMessage(type, requestId, payload))
+        {
+            setLastError("Send failed");
+            // The reader notices the broken socket and fails every pending request
+            conn.shutdown();
         }
-        else
+        return future;
+    }
+
+    bool Network::Client::call(MessageType type, const std::string &payload, Message &response,
+                               std::chrono::milliseconds timeout)
+    {
+        std::future<Message> future = request(type, payload);
+        if (future.wait_for(timeout) != std::future_status::ready)
         {
-            payload.clear();
+            setLastError("Request timed out");
+            // Leave the promise registered; a late response or a disconnect
+            // fulfills it and the abandoned future simply drops the value.
+            return false;
         }
+        response = future.get();
+        return response.type != MessageType::INVALID;
+    }
 
+    bool Network::Client::notify(MessageType type, uint32_t requestId, const std::string &payload)
+    {
+        if (!connected.load())
+        {
+            setLastError("Not connected");
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(sendMutex);
+        if (!conn.sendMessage(type, requestId, payload))
+        {
+            setLastError("Send failed");
+            conn.shutdown();
+            return false;
+        }
         return true;
     }
 
+    void Network::Client::readerLoop()
+    {
+        for (;;)
+        {
+            Message message;
+            if (!conn.receiveMessage(message.type, message.requestId, message.payload))
+            {
+                break;
+            }
+            if ((message.requestId & kServerRequestBit) && pushHandler)
+            {
+                pushHandler(std::move(message));
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto it = pending.find(message.requestId);
+            if (it == pending.end())
+            {
+                Logger::getInstance().log(LogLevel::WARN, "Dropping response for unknown request " +
+                                                              std::to_string(message.requestId));
+                continue;
+            }
+            it->second.set_value(std::move(message));
+            pending.erase(it);
+        }
+        failPending("Connection closed");
+    }
+
+    void Network::Client::failPending(const std::string &reason)
+    {
+        std::unordered_map<uint32_t, std::promise<Message>> failed;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (connected.exchange(false))
+            {
+                setLastError(reason);
+            }
+            failed.swap(pending);
+        }
+        for (auto &entry : failed)
+        {
+            entry.second.set_value(Message());
+        }
+    }
+
+    void Network::Client::setLastError(const std::string &error)
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = error;
+    }
+
+    std::string Network::Client::getLastError()
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        return lastError;
+    }
+
 } // namespace dtq
@@ -0,0 +1,167 @@
+#include "PollRegistry.h"
+
+#include <utility>
+
+namespace dtq
+{
+
+    PollRegistry::PollRegistry(TakeTasks takeTasks) : takeTasks(std::move(takeTasks)) {}
+
+    PollRegistry::~PollRegistry()
+    {
+        stop();
+    }
+
+    void PollRegistry::start()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running)
+        {
+            return;
+        }
+        running = true;
+        reaper = std::thread(&PollRegistry::reaperLoop, this);
+    }
+
+    void PollRegistry::stop()
+    {
+        std::vector<Deliver> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            for (auto &poll : polls)
+            {
+                expired.push_back(std::move(poll.deliver));
+            }
+            polls.clear();
+            byId.clear();
+            deadlines.clear();
+        }
+        reaperWake.notify_all();
+        if (reaper.joinable())
+        {
+            reaper.join();
+        }
+        for (auto &deliver : expired)
+        {
+            deliver(std::vector<Task>());
+        }
+    }
+
+    PollRegistry::PollId PollRegistry::park(size_t home, size_t maxTasks, std::chrono::milliseconds timeout, Deliver deliver)
+    {
+        std::vector<Task> tasks;
+        {
+            // Checking the queue and parking under one lock pairs with
+            // onTasksAvailable(), so a task enqueued in between is not missed.
+            std::lock_guard<std::mutex> lock(mutex);
+            if (polls.empty())
+            {
+                tasks = takeTasks(home, maxTasks);
+            }
+            if (tasks.empty() && running && timeout.count() > 0)
+            {
+                Poll poll;
+                poll.id = ++nextId;
+                poll.home = home;
+                poll.maxTasks = maxTasks;
+                poll.deadline = Clock::now() + timeout;
+                poll.deliver = std::move(deliver);
+                poll.byDeadline = deadlines.emplace(poll.deadline, poll.id);
+                bool earliest = poll.byDeadline == deadlines.begin();
+                polls.push_back(std::move(poll));
+                byId[polls.back().id] = std::prev(polls.end());
+                if (earliest)
+                {
+                    reaperWake.notify_one();
+                }
+                return polls.back().id;
+            }
+        }
+        deliver(std::move(tasks));
+        return 0;
+    }
+
+    void PollRegistry::cancel(PollId id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = byId.find(id);
+        if (it != byId.end())
+        {
+            eraseLocked(it->second);
+        }
+    }
+
+    void PollRegistry::onTasksAvailable()
+    {
+        std::vector<std::pair<Deliver, std::vector<Task>>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!polls.empty())
+            {
+                std::vector<Task> tasks = takeTasks(polls.front().home, polls.front().maxTasks);
+                if (tasks.empty())
+                {
+                    break;
+                }
+                ready.emplace_back(std::move(polls.front().deliver), std::move(tasks));
+                eraseLocked(polls.begin());
+            }
+        }
+        // Deliver outside the lock; a delivery may requeue and re-enter
+        for (auto &entry : ready)
+        {
+            entry.first(std::move(entry.second));
+        }
+    }
+
+    size_t PollRegistry::parkedCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return polls.size();
+    }
+
+    void PollRegistry::eraseLocked(std::list<Poll>::iterator it)
+    {
+        deadlines.erase(it->byDeadline);
+        byId.erase(it->id);
+        polls.erase(it);
+    }
+
+    void PollRegistry::reaperLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running)
+        {
+            if (deadlines.empty())
+            {
+                reaperWake.wait(lock);
+                continue;
+            }
+
+            Clock::time_point next = deadlines.begin()->first;
+            if (Clock::now() < next)
+            {
+                reaperWake.wait_until(lock, next);
+                continue;
+            }
+
+            std::vector<Deliver> expired;
+            Clock::time_point now = Clock::now();
+            while (!deadlines.empty() && deadlines.begin()->first <= now)
+            {
+                auto it = byId[deadlines.begin()->second];
+                expired.push_back(std::move(it->deliver));
+                eraseLocked(it);
+            }
+
+            lock.unlock();
+            for (auto &deliver : expired)
+            {
+                deliver(std::vector<Task>());
+            }
+            lock.lock();
+        }
+    }
+
+} // namespace dtq
@@ -0,0 +1,103 @@
+#include "PriorityScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace dtq
+{
+
+    PriorityScheduler::PriorityScheduler(int levelCount, long long agingIntervalMs, long long defaultDeadlineMs)
+        : levels(static_cast<size_t>(std::max(1, levelCount))), agingIntervalMs(agingIntervalMs),
+          defaultDeadlineMs(defaultDeadlineMs)
+    {
+        spareKeys.reserve(2 * kSpareNodes);
+    }
+
+    void PriorityScheduler::insertKey(KeySet &keys, Key key)
+    {
+        if (spareKeys.empty())
+        {
+            keys.insert(key);
+            return;
+        }
+        KeySet::node_type node = std::move(spareKeys.back());
+        spareKeys.pop_back();
+        node.value() = key;
+        keys.insert(std::move(node));
+    }
+
+    void PriorityScheduler::eraseKey(KeySet &keys, KeySet::iterator it)
+    {
+        if (spareKeys.size() < 2 * kSpareNodes)
+        {
+            spareKeys.push_back(keys.extract(it));
+        }
+        else
+        {
+            keys.erase(it);
+        }
+    }
+
+    void PriorityScheduler::push(Task task, long long nowMs)
+    {
+        int level = std::min(std::max(task.priority, 0), static_cast<int>(levels.size()) - 1);
+        long long deadline = task.deadlineMs > 0 ? task.deadlineMs : nowMs + defaultDeadlineMs;
+        uint64_t seq = nextSeq++;
+
+        insertKey(levels[level].byDeadline, Key{deadline, seq});
+        insertKey(levels[level].byWait, Key{nowMs, seq});
+        Entry &entry = spareEntries.findOrInsert(entries, seq).first->second;
+        entry.task = std::move(task);
+        entry.deadlineMs = deadline;
+        entry.levelSinceMs = nowMs;
+    }
+
+    bool PriorityScheduler::pop(Task &out, long long nowMs)
+    {
+        age(nowMs);
+        for (size_t i = levels.size(); i-- > 0;)
+        {
+            Level &level = levels[i];
+            if (level.byDeadline.empty())
+            {
+                continue;
+            }
+            uint64_t seq = level.byDeadline.begin()->seq;
+            auto it = entries.find(seq);
+            eraseKey(level.byDeadline, level.byDeadline.begin());
+            eraseKey(level.byWait, level.byWait.find(Key{it->second.levelSinceMs, seq}));
+            out = std::move(it->second.task);
+            spareEntries.erase(entries, it);
+            return true;
+        }
+        return false;
+    }
+
+    void PriorityScheduler::age(long long nowMs)
+    {
+        if (agingIntervalMs <= 0)
+        {
+            return;
+        }
+        // Top-down, so a task promoted in this pass waits a full interval on
+        // its new level before it can move again
+        for (size_t i = levels.size() - 1; i-- > 0;)
+        {
+            Level &from = levels[i];
+            Level &to = levels[i + 1];
+            while (!from.byWait.empty() && from.byWait.begin()->timeMs + agingIntervalMs <= nowMs)
+            {
+                uint64_t seq = from.byWait.begin()->seq;
+                Entry &entry = entries.find(seq)->second;
+                // The keys' nodes move between the levels' sets as they are
+                KeySet::node_type waited = from.byWait.extract(from.byWait.begin());
+                KeySet::node_type deadline = from.byDeadline.extract(Key{entry.deadlineMs, seq});
+                entry.levelSinceMs = nowMs;
+                waited.value().timeMs = nowMs;
+                to.byDeadline.insert(std::move(deadline));
+                to.byWait.insert(std::move(waited));
+            }
+        }
+    }
+
+} // namespace dtq
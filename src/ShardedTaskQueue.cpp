@@ -0,0 +1,153 @@
+#include "ShardedTaskQueue.h"
+#include "Config.h"
+
+#include <algorithm>
+
+namespace dtq
+{
+
+    ShardedTaskQueue::ShardedTaskQueue(size_t shardCount, QueueBackend backend)
+        : taskStore(std::make_shared<TaskStore>(16, Config::ResultStoreBudgetBytes, Config::ResultTtl))
+    {
+        shardCount = std::max<size_t>(1, shardCount);
+        size_t total = static_cast<size_t>(Config::MaxQueueSize);
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            // Split the capacity so the shards together hold MaxQueueSize
+            size_t capacity = total / shardCount + (i < total % shardCount ? 1 : 0);
+            shards.push_back(std::make_unique<TaskQueue>(backend, std::max<size_t>(1, capacity), taskStore));
+        }
+    }
+
+    bool ShardedTaskQueue::enqueue(size_t home, const Task &task)
+    {
+        return push(home, task);
+    }
+
+    bool ShardedTaskQueue::enqueue(size_t home, Task &&task)
+    {
+        return push(home, std::move(task));
+    }
+
+    template <typename T>
+    bool ShardedTaskQueue::push(size_t home, T &&task)
+    {
+        home %= shards.size();
+        // Skip shards that look full or are shedding; only the last candidate
+        // logs (and counts) a rejection. A failed enqueue leaves the task
+        // untouched, so forwarding it again is safe.
+        for (size_t i = 0; i + 1 < shards.size(); ++i)
+        {
+            TaskQueue &shard = *shards[(home + i) % shards.size()];
+            if (!shard.shedding() && shard.size() < shard.capacity() && shard.enqueue(std::forward<T>(task)))
+            {
+                return true;
+            }
+        }
+        return shards[(home + shards.size() - 1) % shards.size()]->enqueue(std::forward<T>(task));
+    }
+
+    size_t ShardedTaskQueue::enqueueBulk(size_t home, std::vector<Task> &&tasks)
+    {
+        home %= shards.size();
+        size_t accepted = shards[home]->shedding() ? 0 : shards[home]->enqueueBulk(std::move(tasks));
+        // Whatever did not fit goes to the siblings one task at a time
+        while (accepted < tasks.size() && push(home + 1, std::move(tasks[accepted])))
+        {
+            ++accepted;
+        }
+        return accepted;
+    }
+
+    std::optional<Task> ShardedTaskQueue::dequeue(size_t home)
+    {
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            std::optional<Task> task = shards[(home + i) % shards.size()]->dequeue();
+            if (task)
+            {
+                return task;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<Task> ShardedTaskQueue::dequeueBulk(size_t home, size_t maxTasks)
+    {
+        home %= shards.size();
+        std::vector<Task> tasks = shards[home]->dequeueBulk(maxTasks);
+        // Steal the shortfall from siblings, one bulk dequeue per victim
+        for (size_t i = 1; i < shards.size() && tasks.size() < maxTasks; ++i)
+        {
+            TaskQueue &victim = *shards[(home + i) % shards.size()];
+            if (victim.size() == 0)
+            {
+                continue;
+            }
+            std::vector<Task> stolen = victim.dequeueBulk(maxTasks - tasks.size());
+            tasks.insert(tasks.end(), std::make_move_iterator(stolen.begin()), std::make_move_iterator(stolen.end()));
+        }
+        return tasks;
+    }
+
+    size_t ShardedTaskQueue::size()
+    {
+        size_t total = 0;
+        for (auto &shard : shards)
+        {
+            total += shard->size();
+        }
+        return total;
+    }
+
+    bool ShardedTaskQueue::updateTaskResult(int taskId, const std::string &result, TaskStatus status,
+                                            BlobRef resultBlob)
+    {
+        return shards.front()->updateTaskResult(taskId, result, status, std::move(resultBlob));
+    }
+
+    void ShardedTaskQueue::setLatencyTarget(std::chrono::microseconds target, std::chrono::microseconds interval)
+    {
+        for (auto &shard : shards)
+        {
+            shard->setLatencyTarget(target, interval);
+        }
+    }
+
+    bool ShardedTaskQueue::shedding() const
+    {
+        return std::all_of(shards.begin(), shards.end(), [](const std::unique_ptr<TaskQueue> &shard) { return shard->shedding(); });
+    }
+
+    size_t ShardedTaskQueue::bytesQueued() const
+    {
+        size_t total = 0;
+        for (const auto &shard : shards)
+        {
+            total += shard->bytesQueued();
+        }
+        return total;
+    }
+
+    uint64_t ShardedTaskQueue::shed() const
+    {
+        uint64_t total = 0;
+        for (const auto &shard : shards)
+        {
+            total += shard->shed();
+        }
+        return total;
+    }
+
+    std::vector<size_t> ShardedTaskQueue::shardDepths()
+    {
+        std::vector<size_t> depths;
+        depths.reserve(shards.size());
+        for (auto &shard : shards)
+        {
+            depths.push_back(shard->size());
+        }
+        return depths;
+    }
+
+} // namespace dtq
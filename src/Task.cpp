@@ -1,4 +1,278 @@
 #include "Task.h"
+#include "Wire.h"
 
-// If you want more complex logic, implement it here.
-// Currently, serialization/deserialization is inline in Task.h
+#include <charconv>
+
+namespace dtq
+{
+
+    namespace
+    {
+        // version, status, headerSize, taskId, retryCount, enqueueTimeMs, resultLen, payloadLen
+        const uint16_t kBaseHeaderSize = 1 + 1 + 2 + 4 + 4 + 8 + 4 + 4;
+        // Appended fields: priority, deadlineMs
+        const uint16_t kPriorityHeaderSize = kBaseHeaderSize + 4 + 8;
+        // Appended fields: the five TaskTrace stamps
+        const uint16_t kTraceHeaderSize = kPriorityHeaderSize + 5 * 8;
+        // Appended fields: notBeforeMs
+        const uint16_t kBinaryHeaderSize = kTraceHeaderSize + 8;
+
+        template <typename Int>
+        bool parseInt(std::string_view field, Int &out)
+        {
+            const char *end = field.data() + field.size();
+            auto res = std::from_chars(field.data(), end, out);
+            return res.ec == std::errc() && res.ptr == end;
+        }
+
+        // Splits off the next '|'-terminated field; the last field runs to the end
+        bool nextField(std::string_view &rest, std::string_view &field)
+        {
+            if (rest.data() == nullptr)
+                return false;
+            size_t bar = rest.find('|');
+            if (bar == std::string_view::npos)
+            {
+                field = rest;
+                rest = std::string_view();
+                return true;
+            }
+            field = rest.substr(0, bar);
+            rest.remove_prefix(bar + 1);
+            return true;
+        }
+
+        bool decodeText(std::string_view data, TaskView &view)
+        {
+            std::string_view field;
+            int status = 0;
+            if (!nextField(data, field) || !parseInt(field, view.taskId))
+                return false;
+            if (!nextField(data, view.payload))
+                return false;
+            if (!nextField(data, field) || !parseInt(field, status))
+                return false;
+            view.status = static_cast<TaskStatus>(status);
+            if (!nextField(data, view.result))
+                return false;
+            if (!nextField(data, field) || !parseInt(field, view.retryCount))
+                return false;
+            if (!nextField(data, field) || !parseInt(field, view.enqueueTimeMs))
+                return false;
+            return true;
+        }
+
+        bool decodeBinary(std::string_view data, TaskView &view)
+        {
+            wire::Reader in(data);
+            uint8_t version, status;
+            uint16_t headerSize;
+            int32_t taskId, retryCount;
+            int64_t enqueueTimeMs;
+            uint32_t resultLen, payloadLen;
+            if (!in.getU8(version) || !in.getU8(status) || !in.getU16(headerSize) ||
+                !in.getI32(taskId) || !in.getI32(retryCount) || !in.getI64(enqueueTimeMs) ||
+                !in.getU32(resultLen) || !in.getU32(payloadLen))
+            {
+                return false;
+            }
+            if (headerSize < kBaseHeaderSize)
+                return false;
+            // Older encoders stop at the base header
+            int32_t priority = 0;
+            int64_t deadlineMs = 0;
+            if (headerSize >= kPriorityHeaderSize && (!in.getI32(priority) || !in.getI64(deadlineMs)))
+                return false;
+            TaskTrace trace;
+            if (headerSize >= kTraceHeaderSize &&
+                (!in.getI64(trace.submittedUs) || !in.getI64(trace.enqueuedUs) || !in.getI64(trace.assignedUs) ||
+                 !in.getI64(trace.receivedUs) || !in.getI64(trace.completedUs)))
+                return false;
+            int64_t notBeforeMs = 0;
+            if (headerSize >= kBinaryHeaderSize && !in.getI64(notBeforeMs))
+                return false;
+            // Newer encoders may append fixed fields; skip what we do not know
+            size_t known = headerSize >= kBinaryHeaderSize     ? kBinaryHeaderSize
+                           : headerSize >= kTraceHeaderSize    ? kTraceHeaderSize
+                           : headerSize >= kPriorityHeaderSize ? kPriorityHeaderSize
+                                                               : kBaseHeaderSize;
+            if (!in.skip(headerSize - known))
+                return false;
+            if (!in.getView(resultLen, view.result) || !in.getView(payloadLen, view.payload))
+                return false;
+
+            view.taskId = taskId;
+            view.status = static_cast<TaskStatus>(status);
+            view.retryCount = retryCount;
+            view.enqueueTimeMs = enqueueTimeMs;
+            view.priority = priority;
+            view.deadlineMs = deadlineMs;
+            view.notBeforeMs = notBeforeMs;
+            view.trace = trace;
+            return true;
+        }
+
+        // Everything but a blob payload's bytes, which go last
+        void encodeBinaryHead(const Task &task, std::string &out)
+        {
+            out.reserve(out.size() + kBinaryHeaderSize + task.result.size() + task.payload.size());
+            wire::putU8(out, static_cast<uint8_t>(WireFormat::Binary));
+            wire::putU8(out, static_cast<uint8_t>(task.status));
+            wire::putU16(out, kBinaryHeaderSize);
+            wire::putI32(out, task.taskId);
+            wire::putI32(out, task.retryCount);
+            wire::putI64(out, task.enqueueTimeMs);
+            wire::putU32(out, static_cast<uint32_t>(task.result.size()));
+            wire::putU32(out, static_cast<uint32_t>(task.payload.size() + task.payloadBlob.size));
+            wire::putI32(out, task.priority);
+            wire::putI64(out, task.deadlineMs);
+            wire::putI64(out, task.trace.submittedUs);
+            wire::putI64(out, task.trace.enqueuedUs);
+            wire::putI64(out, task.trace.assignedUs);
+            wire::putI64(out, task.trace.receivedUs);
+            wire::putI64(out, task.trace.completedUs);
+            wire::putI64(out, task.notBeforeMs);
+            // Payload goes last so large payloads can be streamed after the header
+            out.append(task.result);
+            out.append(task.payload);
+        }
+
+        void putLengthAt(std::string &out, size_t at, uint32_t length)
+        {
+            for (int i = 0; i < 4; ++i)
+                out[at + i] = static_cast<char>(length >> (8 * i));
+        }
+    } // namespace
+
+    std::string Task::serialize(WireFormat format) const
+    {
+        std::string out;
+        serializeTo(out, format);
+        return out;
+    }
+
+    void Task::serializeTo(std::string &out, WireFormat format) const
+    {
+        if (format == WireFormat::Text)
+        {
+            wire::putU8(out, static_cast<uint8_t>(WireFormat::Text));
+            out += std::to_string(taskId);
+            out += '|';
+            out += payload;
+            out.append(payloadBlob.view());
+            out += '|';
+            out += std::to_string(static_cast<int>(status));
+            out += '|';
+            out += result;
+            out += '|';
+            out += std::to_string(retryCount);
+            out += '|';
+            out += std::to_string(enqueueTimeMs);
+            return;
+        }
+
+        encodeBinaryHead(*this, out);
+        out.append(payloadBlob.view());
+    }
+
+    void Task::serializeTo(SplicedPayload &out) const
+    {
+        encodeBinaryHead(*this, out.bytes);
+        out.appendBlob(payloadBlob);
+    }
+
+    bool Task::decode(std::string_view data, TaskView &view)
+    {
+        if (data.empty())
+            return false;
+
+        unsigned char version = static_cast<unsigned char>(data[0]);
+        if (version == static_cast<unsigned char>(WireFormat::Binary))
+            return decodeBinary(data, view);
+        if (version == static_cast<unsigned char>(WireFormat::Text))
+            return decodeText(data.substr(1), view);
+        // Unversioned text from peers that predate the version byte
+        if ((version >= '0' && version <= '9') || version == '-')
+            return decodeText(data, view);
+        return false;
+    }
+
+    void Task::assign(const TaskView &view)
+    {
+        taskId = view.taskId;
+        payload.assign(view.payload.data(), view.payload.size());
+        status = view.status;
+        result.assign(view.result.data(), view.result.size());
+        retryCount = view.retryCount;
+        enqueueTimeMs = view.enqueueTimeMs;
+        priority = view.priority;
+        deadlineMs = view.deadlineMs;
+        notBeforeMs = view.notBeforeMs;
+        trace = view.trace;
+        queuedUs = 0;
+        payloadBlob = BlobRef();
+    }
+
+    Task Task::fromView(const TaskView &view)
+    {
+        Task task;
+        task.assign(view);
+        return task;
+    }
+
+    Task Task::deserialize(std::string_view data)
+    {
+        TaskView view;
+        if (!decode(data, view))
+            return Task();
+        return fromView(view);
+    }
+
+    std::string Task::serializeBatch(const std::vector<Task> &tasks, WireFormat format)
+    {
+        std::string out;
+        wire::putU32(out, static_cast<uint32_t>(tasks.size()));
+        for (const Task &task : tasks)
+        {
+            // Reserve the length slot, encode in place, then patch the length
+            size_t lengthAt = out.size();
+            wire::putU32(out, 0);
+            task.serializeTo(out, format);
+            putLengthAt(out, lengthAt, static_cast<uint32_t>(out.size() - lengthAt - 4));
+        }
+        return out;
+    }
+
+    void Task::serializeBatch(const std::vector<Task> &tasks, SplicedPayload &out)
+    {
+        wire::putU32(out.bytes, static_cast<uint32_t>(tasks.size()));
+        for (const Task &task : tasks)
+        {
+            size_t lengthAt = out.bytes.size();
+            wire::putU32(out.bytes, 0);
+            task.serializeTo(out);
+            putLengthAt(out.bytes, lengthAt, static_cast<uint32_t>(out.bytes.size() - lengthAt - 4 + task.payloadBlob.size));
+        }
+    }
+
+    bool Task::decodeBatch(std::string_view data, std::vector<TaskView> &views)
+    {
+        wire::Reader in(data);
+        uint32_t count;
+        // Each task takes at least its u32 length and a version byte, so a
+        // count the body cannot hold is rejected before it sizes anything
+        if (!in.getU32(count) || in.remaining() / 5 < count)
+            return false;
+        views.reserve(views.size() + count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            std::string_view encoded;
+            TaskView view;
+            if (!in.getBytes(encoded) || !decode(encoded, view))
+                return false;
+            views.push_back(view);
+        }
+        return true;
+    }
+
+} // namespace dtq
@@ -0,0 +1,124 @@
+#include "TaskPool.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace dtq
+{
+
+    TaskPool::TaskPool(size_t capacity)
+        : slotCapacity(std::max<size_t>(1, (capacity ? capacity : Config::TaskPoolCapacity) / kSlots))
+    {
+    }
+
+    TaskPool &TaskPool::getInstance()
+    {
+        static TaskPool pool;
+        return pool;
+    }
+
+    size_t TaskPool::slotForThread()
+    {
+        // Threads take slots round-robin in the order they first use a pool
+        static std::atomic<size_t> nextThread{0};
+        thread_local size_t index = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return index % kSlots;
+    }
+
+    Task TaskPool::acquire()
+    {
+        // The thread's own slot first; a busy sibling is skipped, not waited for
+        size_t home = slotForThread();
+        for (size_t i = 0; i < kSlots; ++i)
+        {
+            Slot &slot = slots[(home + i) % kSlots];
+            std::unique_lock<std::mutex> lock(slot.mutex, std::defer_lock);
+            if (i == 0)
+            {
+                lock.lock();
+            }
+            else if (!lock.try_lock())
+            {
+                continue;
+            }
+            if (!slot.tasks.empty())
+            {
+                Task task = std::move(slot.tasks.back());
+                slot.tasks.pop_back();
+                reuseCount.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        createCount.fetch_add(1, std::memory_order_relaxed);
+        return Task();
+    }
+
+    Task TaskPool::acquire(const TaskView &view)
+    {
+        Task task = acquire();
+        task.assign(view);
+        return task;
+    }
+
+    void TaskPool::release(Task &&task)
+    {
+        if (task.payload.capacity() > kMaxRetainedBytes || task.result.capacity() > kMaxRetainedBytes)
+        {
+            return;
+        }
+        // Back to default values, keeping the string buffers
+        std::string payload = std::move(task.payload);
+        std::string result = std::move(task.result);
+        payload.clear();
+        result.clear();
+        task = Task();
+        task.payload = std::move(payload);
+        task.result = std::move(result);
+
+        size_t home = slotForThread();
+        for (size_t i = 0; i < kSlots; ++i)
+        {
+            Slot &slot = slots[(home + i) % kSlots];
+            std::unique_lock<std::mutex> lock(slot.mutex, std::defer_lock);
+            if (i == 0)
+            {
+                lock.lock();
+            }
+            else if (!lock.try_lock())
+            {
+                continue;
+            }
+            if (slot.tasks.size() < slotCapacity)
+            {
+                if (slot.tasks.capacity() == 0)
+                {
+                    slot.tasks.reserve(slotCapacity);
+                }
+                slot.tasks.push_back(std::move(task));
+                return;
+            }
+        }
+    }
+
+    void TaskPool::release(std::vector<Task> &&tasks)
+    {
+        for (Task &task : tasks)
+        {
+            release(std::move(task));
+        }
+        tasks.clear();
+    }
+
+    size_t TaskPool::idle()
+    {
+        size_t total = 0;
+        for (Slot &slot : slots)
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            total += slot.tasks.size();
+        }
+        return total;
+    }
+
+} // namespace dtq
@@ -2,54 +2,437 @@
 #include "Config.h"
 #include "Logger.h"
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 
 namespace dtq
 {
 
-    TaskQueue::TaskQueue() {}
+    namespace
+    {
+        // Stamps the time the queue takes a task; a const task is copied first
+        Task &&stamped(Task &&task, int64_t nowUs)
+        {
+            task.queuedUs = nowUs;
+            return std::move(task);
+        }
+
+        Task stamped(const Task &task, int64_t nowUs)
+        {
+            Task copy(task);
+            copy.queuedUs = nowUs;
+            return copy;
+        }
+
+        // Stays the same when a task is copied or moved, unlike capacities
+        int64_t footprint(const Task &task)
+        {
+            return static_cast<int64_t>(sizeof(Task) + task.payload.size() + task.result.size());
+        }
+    } // namespace
+
+    TaskQueue::TaskQueue(QueueBackend backend, size_t capacity, std::shared_ptr<TaskStore> store)
+        : backendKind(backend), maxSize(capacity > 0 ? capacity : static_cast<size_t>(Config::MaxQueueSize)),
+          taskStore(store ? std::move(store)
+                          : std::make_shared<TaskStore>(16, Config::ResultStoreBudgetBytes, Config::ResultTtl))
+    {
+        if (backend == QueueBackend::LockFreeRing)
+        {
+            ring = std::make_unique<MpmcRing<Task>>(maxSize);
+        }
+        else if (backend == QueueBackend::Priority)
+        {
+            scheduler = std::make_unique<PriorityScheduler>(Config::PriorityLevels,
+                                                            Config::PriorityAgingInterval.count(),
+                                                            Config::DefaultTaskDeadline.count());
+        }
+    }
+
+    size_t TaskQueue::sizeLocked() const
+    {
+        return scheduler ? scheduler->size() : queue.size();
+    }
+
+    template <typename T>
+    void TaskQueue::pushLocked(T &&task)
+    {
+        if (scheduler)
+            scheduler->push(std::forward<T>(task), wallClockMs());
+        else
+            queue.push(std::forward<T>(task));
+    }
+
+    Task TaskQueue::popLocked()
+    {
+        Task task;
+        if (scheduler)
+        {
+            scheduler->pop(task, wallClockMs());
+            return task;
+        }
+        task = std::move(queue.front());
+        queue.pop();
+        return task;
+    }
+
     TaskQueue::~TaskQueue() {}
 
     bool TaskQueue::enqueue(const Task &task)
     {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        if (queue.size() >= Config::MaxQueueSize)
+        return push(task);
+    }
+
+    bool TaskQueue::enqueue(Task &&task)
+    {
+        return push(std::move(task));
+    }
+
+    void TaskQueue::setLatencyTarget(std::chrono::microseconds target, std::chrono::microseconds interval)
+    {
+        targetUs.store(target.count(), std::memory_order_relaxed);
+        intervalUs.store(interval.count(), std::memory_order_relaxed);
+        aboveUntilUs.store(0, std::memory_order_relaxed);
+        overloaded.store(false, std::memory_order_relaxed);
+    }
+
+    int64_t TaskQueue::stampUs() const
+    {
+        // The clock is only read when something will look at the stamp
+        return targetUs.load(std::memory_order_relaxed) > 0 ? monotonicUs() : 0;
+    }
+
+    bool TaskQueue::shedIfOverloaded(size_t count)
+    {
+        if (!overloaded.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        shedCount.fetch_add(count, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Races between consumers only blur the moment shedding starts or stops
+    void TaskQueue::noteSojourn(const Task &task, size_t remaining)
+    {
+        int64_t target = targetUs.load(std::memory_order_relaxed);
+        if (target <= 0)
+        {
+            return;
+        }
+        int64_t nowUs = monotonicUs();
+        if (nowUs - task.queuedUs < target || remaining == 0)
+        {
+            aboveUntilUs.store(0, std::memory_order_relaxed);
+            if (overloaded.exchange(false, std::memory_order_relaxed))
+            {
+                Logger::getInstance().log(LogLevel::INFO, "Queue back under its latency target; admitting tasks again");
+            }
+            return;
+        }
+        int64_t until = aboveUntilUs.load(std::memory_order_relaxed);
+        if (until == 0)
+        {
+            aboveUntilUs.store(nowUs + intervalUs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        else if (nowUs >= until && !overloaded.exchange(true, std::memory_order_relaxed))
+        {
+            Logger::getInstance().log(LogLevel::WARN, "Tasks waited over the queue latency target for a whole interval (sojourn " +
+                                                          std::to_string(nowUs - task.queuedUs) + "us); shedding new tasks");
+        }
+    }
+
+    template <typename T>
+    bool TaskQueue::push(T &&task)
+    {
+        int taskId = task.taskId;
+        if (shedIfOverloaded(1))
+        {
+            DTQ_LOG(INFO, "Queue over its latency target. Task " + std::to_string(taskId) + " shed.");
+            return false;
+        }
+        size_t queueSize = 0;
+        bool accepted;
+        int64_t nowUs = stampUs();
+        int64_t bytes = footprint(task);
+        // Recorded before the task is visible to consumers, who mark it IN_PROGRESS
+        // and subtract its bytes; a rejection puts back the record it replaced
+        std::optional<TaskRecord> replaced = taskStore->markPending(taskId);
+        queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (ring)
+        {
+            accepted = ring->tryPush(stamped(std::forward<T>(task), nowUs));
+            if (accepted)
+            {
+                queueSize = ring->sizeApprox();
+                wakeWaiters(false);
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            accepted = sizeLocked() < maxSize;
+            if (accepted)
+            {
+                pushLocked(stamped(std::forward<T>(task), nowUs));
+                queueSize = sizeLocked();
+                condition.notify_one();
+            }
+        }
+
+        if (!accepted)
         {
+            queuedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+            taskStore->restore(taskId, std::move(replaced));
             Logger::getInstance().log(LogLevel::WARN,
-                                      "Queue is full. Task " + std::to_string(task.taskId) + " rejected.");
+                                      "Queue is full. Task " + std::to_string(taskId) + " rejected.");
             return false;
         }
-        queue.push(task);
-        condition.notify_one();
-        Logger::getInstance().log(LogLevel::INFO,
-                                  "Task " + std::to_string(task.taskId) + " enqueued. Queue size=" + std::to_string(queue.size()));
+        DTQ_LOG(INFO, "Task " + std::to_string(taskId) + " enqueued. Queue size=" + std::to_string(queueSize));
         return true;
     }
 
+    void TaskQueue::wakeWaiters(bool all)
+    {
+        // Pairs with the fence in dequeueFor: either the sleeper's re-check sees
+        // the task just pushed, or this load sees the sleeper.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (all)
+            condition.notify_all();
+        else
+            condition.notify_one();
+    }
+
     std::optional<Task> TaskQueue::dequeue()
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (queue.empty())
+        Task task;
+        size_t queueSize;
+        if (ring)
         {
-            return std::nullopt;
+            if (!ring->tryPop(task))
+            {
+                return std::nullopt;
+            }
+            queueSize = ring->sizeApprox();
         }
-        Task task = queue.front();
-        queue.pop();
-        Logger::getInstance().log(LogLevel::INFO,
-                                  "Task " + std::to_string(task.taskId) + " dequeued. Queue size=" + std::to_string(queue.size()));
+        else
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (sizeLocked() == 0)
+            {
+                return std::nullopt;
+            }
+            task = popLocked();
+            queueSize = sizeLocked();
+        }
+        noteSojourn(task, queueSize);
+        taskStore->transition(task.taskId, TaskStatus::IN_PROGRESS);
+        queuedBytes.fetch_sub(footprint(task), std::memory_order_relaxed);
+        DTQ_LOG(INFO, "Task " + std::to_string(task.taskId) + " dequeued. Queue size=" + std::to_string(queueSize));
+        return task;
+    }
+
+    std::optional<Task> TaskQueue::dequeueFor(std::chrono::milliseconds timeout)
+    {
+        Task task;
+        size_t queueSize;
+        if (ring)
+        {
+            if (!ring->tryPop(task))
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                waiters.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool woken = condition.wait_for(lock, timeout, [&]() { return ring->tryPop(task); });
+                waiters.fetch_sub(1, std::memory_order_relaxed);
+                if (!woken)
+                {
+                    return std::nullopt;
+                }
+            }
+            queueSize = ring->sizeApprox();
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (!condition.wait_for(lock, timeout, [this]() { return sizeLocked() > 0; }))
+            {
+                return std::nullopt;
+            }
+            task = popLocked();
+            queueSize = sizeLocked();
+        }
+        noteSojourn(task, queueSize);
+        taskStore->transition(task.taskId, TaskStatus::IN_PROGRESS);
+        queuedBytes.fetch_sub(footprint(task), std::memory_order_relaxed);
+        DTQ_LOG(INFO, "Task " + std::to_string(task.taskId) + " dequeued. Queue size=" + std::to_string(queueSize));
         return task;
     }
 
-    bool TaskQueue::updateTaskResult(int taskId, const std::string &result, TaskStatus status)
+    size_t TaskQueue::enqueueBulk(const std::vector<Task> &tasks)
+    {
+        return pushBulk(tasks);
+    }
+
+    size_t TaskQueue::enqueueBulk(std::vector<Task> &&tasks)
+    {
+        return pushBulk(std::move(tasks));
+    }
+
+    template <typename Tasks>
+    size_t TaskQueue::pushBulk(Tasks &&tasks)
     {
-        Logger::getInstance().log(LogLevel::INFO,
-                                  "Task " + std::to_string(taskId) + " updated with result: " + result);
+        // Copies from a const vector, moves from an rvalue one
+        using Element = typename std::conditional<std::is_const<typename std::remove_reference<Tasks>::type>::value,
+                                                  const Task &, Task &&>::type;
+        size_t accepted = 0;
+        size_t queueSize;
+        if (!tasks.empty() && shedIfOverloaded(tasks.size()))
+        {
+            DTQ_LOG(INFO, "Queue over its latency target. " + std::to_string(tasks.size()) + " batched tasks shed.");
+            return 0;
+        }
+        int64_t nowUs = stampUs();
+        int64_t bytes = 0;
+        // Records of already known ids, by index, to put back if their task is rejected
+        std::vector<std::pair<size_t, TaskRecord>> replaced;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            std::optional<TaskRecord> record = taskStore->markPending(tasks[i].taskId);
+            if (record)
+            {
+                replaced.emplace_back(i, std::move(*record));
+            }
+            bytes += footprint(tasks[i]);
+        }
+        queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (ring)
+        {
+            // Stop at the first failure so the accepted tasks stay a prefix
+            while (accepted < tasks.size() && ring->tryPush(stamped(static_cast<Element>(tasks[accepted]), nowUs)))
+            {
+                ++accepted;
+            }
+            queueSize = ring->sizeApprox();
+            if (accepted > 0)
+            {
+                wakeWaiters(true);
+            }
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                while (accepted < tasks.size() && sizeLocked() < maxSize)
+                {
+                    pushLocked(stamped(static_cast<Element>(tasks[accepted]), nowUs));
+                    ++accepted;
+                }
+                queueSize = sizeLocked();
+            }
+            if (accepted > 0)
+            {
+                condition.notify_all();
+            }
+        }
+        if (accepted < tasks.size())
+        {
+            // Rejected tasks were not moved from, so their ids and sizes are intact
+            int64_t rejectedBytes = 0;
+            auto prior = std::lower_bound(replaced.begin(), replaced.end(), accepted,
+                                          [](const std::pair<size_t, TaskRecord> &entry, size_t index) { return entry.first < index; });
+            for (size_t i = accepted; i < tasks.size(); ++i)
+            {
+                std::optional<TaskRecord> record;
+                if (prior != replaced.end() && prior->first == i)
+                {
+                    record = std::move(prior->second);
+                    ++prior;
+                }
+                taskStore->restore(tasks[i].taskId, std::move(record));
+                rejectedBytes += footprint(tasks[i]);
+            }
+            queuedBytes.fetch_sub(rejectedBytes, std::memory_order_relaxed);
+            Logger::getInstance().log(LogLevel::WARN,
+                                      "Queue is full. " + std::to_string(tasks.size() - accepted) + " of " +
+                                          std::to_string(tasks.size()) + " batched tasks rejected.");
+        }
+        DTQ_LOG(INFO, std::to_string(accepted) + " tasks enqueued in bulk. Queue size=" + std::to_string(queueSize));
+        return accepted;
+    }
+
+    std::vector<Task> TaskQueue::dequeueBulk(size_t maxTasks)
+    {
+        std::vector<Task> tasks;
+        size_t queueSize;
+        if (ring)
+        {
+            tasks.reserve(std::min(maxTasks, ring->sizeApprox()));
+            Task task;
+            while (tasks.size() < maxTasks && ring->tryPop(task))
+            {
+                tasks.push_back(std::move(task));
+            }
+            queueSize = ring->sizeApprox();
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            size_t count = std::min(maxTasks, sizeLocked());
+            tasks.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                tasks.push_back(popLocked());
+            }
+            queueSize = sizeLocked();
+        }
+        int64_t bytes = 0;
+        for (const Task &task : tasks)
+        {
+            noteSojourn(task, queueSize);
+            taskStore->transition(task.taskId, TaskStatus::IN_PROGRESS);
+            bytes += footprint(task);
+        }
+        queuedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        if (!tasks.empty())
+        {
+            DTQ_LOG(INFO, std::to_string(tasks.size()) + " tasks dequeued in bulk. Queue size=" + std::to_string(queueSize));
+        }
+        return tasks;
+    }
+
+    bool TaskQueue::updateTaskResult(int taskId, const std::string &result, TaskStatus status, BlobRef resultBlob)
+    {
+        size_t blobBytes = resultBlob.size;
+        if (!taskStore->transition(taskId, status, result, std::move(resultBlob)))
+        {
+            Logger::getInstance().log(LogLevel::WARN,
+                                      "Task " + std::to_string(taskId) + " cannot move to status " +
+                                          std::to_string(static_cast<int>(status)));
+            return false;
+        }
+        DTQ_LOG(INFO, "Task " + std::to_string(taskId) + " updated with result: " +
+                          (blobBytes ? std::to_string(blobBytes) + " bytes in the blob store" : result));
         return true;
     }
 
+    size_t TaskQueue::bytesQueued() const
+    {
+        return static_cast<size_t>(std::max<int64_t>(0, queuedBytes.load(std::memory_order_relaxed)));
+    }
+
     size_t TaskQueue::size()
     {
+        if (ring)
+        {
+            return ring->sizeApprox();
+        }
         std::lock_guard<std::mutex> lock(queueMutex);
-        return queue.size();
+        return sizeLocked();
     }
 
 } // namespace dtq
@@ -0,0 +1,284 @@
+#include "TaskStore.h"
+#include "Wire.h"
+
+#include <algorithm>
+
+namespace dtq
+{
+
+    TaskStore::TaskStore(size_t shardCount, size_t memoryBudgetBytes, std::chrono::milliseconds ttl)
+        : ttl(ttl)
+    {
+        shardCount = std::max<size_t>(1, shardCount);
+        shardBudgetBytes = memoryBudgetBytes / shardCount;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    TaskStore::Shard &TaskStore::shardFor(int taskId)
+    {
+        return *shards[static_cast<uint32_t>(taskId) % shards.size()];
+    }
+
+    bool TaskStore::isFinished(TaskStatus status)
+    {
+        return status == TaskStatus::COMPLETED || status == TaskStatus::FAILED;
+    }
+
+    size_t TaskStore::footprint(const Entry &entry)
+    {
+        // Rough per-entry cost: map node, list node and the result bytes
+        return sizeof(Entry) + sizeof(int) * 4 + entry.record.result.capacity() + entry.record.resultBlob.size;
+    }
+
+    void TaskStore::removeLocked(Shard &shard, EntryMap::iterator it)
+    {
+        std::string &result = it->second.record.result;
+        if (result.capacity() > kMaxSpareResultBytes)
+        {
+            std::string().swap(result);
+        }
+        it->second.record.resultBlob = BlobRef();
+        shard.spareEntries.erase(shard.entries, it);
+    }
+
+    std::list<int>::iterator TaskStore::pushFinishedLocked(Shard &shard, int taskId)
+    {
+        if (shard.spareFinished.empty())
+        {
+            return shard.finished.insert(shard.finished.end(), taskId);
+        }
+        auto pos = shard.spareFinished.begin();
+        *pos = taskId;
+        shard.finished.splice(shard.finished.end(), shard.spareFinished, pos);
+        return pos;
+    }
+
+    void TaskStore::popFinishedLocked(Shard &shard, std::list<int>::iterator pos)
+    {
+        if (shard.spareFinished.size() < kSpareNodes)
+        {
+            shard.spareFinished.splice(shard.spareFinished.end(), shard.finished, pos);
+        }
+        else
+        {
+            shard.finished.erase(pos);
+        }
+    }
+
+    std::optional<TaskRecord> TaskStore::markPending(int taskId)
+    {
+        Shard &shard = shardFor(taskId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto slot = shard.spareEntries.findOrInsert(shard.entries, taskId);
+        Entry &entry = slot.first->second;
+        std::optional<TaskRecord> replaced;
+        if (slot.second)
+        {
+            // A reused node still holds the record of the task it last tracked
+            entry.record.result.clear();
+        }
+        else if (isFinished(entry.record.status))
+        {
+            shard.finishedBytes -= footprint(entry);
+            popFinishedLocked(shard, entry.finishedPos);
+            replaced = TaskRecord{entry.record.status, std::move(entry.record.result), std::move(entry.record.resultBlob)};
+            entry.record.result.clear();
+            entry.record.resultBlob = BlobRef();
+        }
+        else
+        {
+            // Unfinished records carry no result
+            replaced = TaskRecord{entry.record.status, std::string(), BlobRef()};
+        }
+        entry.record.status = TaskStatus::PENDING;
+        return replaced;
+    }
+
+    void TaskStore::restore(int taskId, std::optional<TaskRecord> &&record)
+    {
+        if (!record)
+        {
+            erase(taskId);
+            return;
+        }
+        Shard &shard = shardFor(taskId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto slot = shard.spareEntries.findOrInsert(shard.entries, taskId);
+        Entry &entry = slot.first->second;
+        if (slot.second)
+        {
+            entry.finishedAt = Clock::now();
+        }
+        else if (isFinished(entry.record.status))
+        {
+            shard.finishedBytes -= footprint(entry);
+            popFinishedLocked(shard, entry.finishedPos);
+        }
+        entry.record = std::move(*record);
+        if (isFinished(entry.record.status))
+        {
+            // finishedAt still holds when it first finished, so its TTL is kept
+            entry.finishedPos = pushFinishedLocked(shard, taskId);
+            shard.finishedBytes += footprint(entry);
+        }
+    }
+
+    void TaskStore::erase(int taskId)
+    {
+        Shard &shard = shardFor(taskId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(taskId);
+        if (it == shard.entries.end())
+        {
+            return;
+        }
+        if (isFinished(it->second.record.status))
+        {
+            shard.finishedBytes -= footprint(it->second);
+            popFinishedLocked(shard, it->second.finishedPos);
+        }
+        removeLocked(shard, it);
+    }
+
+    bool TaskStore::transition(int taskId, TaskStatus status, const std::string &result, BlobRef resultBlob)
+    {
+        Shard &shard = shardFor(taskId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(taskId);
+        if (it == shard.entries.end())
+        {
+            return false;
+        }
+
+        Entry &entry = it->second;
+        TaskStatus from = entry.record.status;
+        bool allowed;
+        switch (status)
+        {
+        case TaskStatus::IN_PROGRESS:
+            allowed = from == TaskStatus::PENDING;
+            break;
+        case TaskStatus::PENDING:
+            allowed = from == TaskStatus::IN_PROGRESS;
+            break;
+        default:
+            allowed = !isFinished(from);
+            break;
+        }
+        if (!allowed)
+        {
+            return false;
+        }
+
+        entry.record.status = status;
+        if (isFinished(status))
+        {
+            Clock::time_point now = Clock::now();
+            entry.record.result = result;
+            entry.record.resultBlob = std::move(resultBlob);
+            entry.finishedAt = now;
+            entry.finishedPos = pushFinishedLocked(shard, taskId);
+            shard.finishedBytes += footprint(entry);
+            evictLocked(shard, now);
+        }
+        return true;
+    }
+
+    void TaskStore::evictLocked(Shard &shard, Clock::time_point now)
+    {
+        while (!shard.finished.empty())
+        {
+            auto it = shard.entries.find(shard.finished.front());
+            bool expired = ttl.count() > 0 && now - it->second.finishedAt >= ttl;
+            bool overBudget = shardBudgetBytes > 0 && shard.finishedBytes > shardBudgetBytes;
+            if (!expired && !overBudget)
+            {
+                break;
+            }
+            shard.finishedBytes -= footprint(it->second);
+            popFinishedLocked(shard, shard.finished.begin());
+            removeLocked(shard, it);
+        }
+    }
+
+    std::optional<TaskRecord> TaskStore::lookup(int taskId)
+    {
+        Shard &shard = shardFor(taskId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(taskId);
+        if (it == shard.entries.end())
+        {
+            return std::nullopt;
+        }
+        if (isFinished(it->second.record.status) && ttl.count() > 0 && Clock::now() - it->second.finishedAt >= ttl)
+        {
+            return std::nullopt; // expired, evicted on the next write to this shard
+        }
+        return it->second.record;
+    }
+
+    size_t TaskStore::size()
+    {
+        size_t total = 0;
+        for (auto &shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->entries.size();
+        }
+        return total;
+    }
+
+    void TaskStore::encodeRecord(std::string &out, int taskId, const std::optional<TaskRecord> &record)
+    {
+        wire::putI32(out, taskId);
+        wire::putU8(out, record ? 1 : 0);
+        wire::putU8(out, static_cast<uint8_t>(record ? record->status : TaskStatus::PENDING));
+        if (!record || record->resultBlob.empty())
+        {
+            wire::putBytes(out, record ? std::string_view(record->result) : std::string_view());
+            return;
+        }
+        wire::putU32(out, static_cast<uint32_t>(record->result.size() + record->resultBlob.size));
+        out.append(record->result);
+        out.append(record->resultBlob.view());
+    }
+
+    void TaskStore::encodeRecord(SplicedPayload &out, int taskId, const std::optional<TaskRecord> &record)
+    {
+        if (!record || record->resultBlob.empty())
+        {
+            encodeRecord(out.bytes, taskId, record);
+            return;
+        }
+        wire::putI32(out.bytes, taskId);
+        wire::putU8(out.bytes, 1);
+        wire::putU8(out.bytes, static_cast<uint8_t>(record->status));
+        wire::putU32(out.bytes, static_cast<uint32_t>(record->result.size() + record->resultBlob.size));
+        out.bytes.append(record->result);
+        out.appendBlob(record->resultBlob);
+    }
+
+    bool TaskStore::decodeRecord(std::string_view &in, int &taskId, std::optional<TaskRecord> &record)
+    {
+        wire::Reader reader(in);
+        int32_t id;
+        uint8_t found, status;
+        std::string_view result;
+        if (!reader.getI32(id) || !reader.getU8(found) || !reader.getU8(status) || !reader.getBytes(result))
+        {
+            return false;
+        }
+        taskId = id;
+        record.reset();
+        if (found)
+        {
+            record = TaskRecord{static_cast<TaskStatus>(status), std::string(result), BlobRef()};
+        }
+        in = reader.rest();
+        return true;
+    }
+
+} // namespace dtq
@@ -0,0 +1,745 @@
+#include "TcpServer.h"
+#include "Config.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+#undef ERROR
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+#ifdef __linux__
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+namespace dtq
+{
+
+    // ---------------------------------------------------------------------
+    // Thread-per-connection transport
+    // ---------------------------------------------------------------------
+
+    class TcpServer::BlockingSession : public Session
+    {
+    public:
+        BlockingSession(SOCKET sock, uint64_t id)
+            : conn(sock), sock(sock), sessionId(id) {}
+
+        using Session::send;
+
+        bool send(MessageType type, uint32_t requestId, const std::string &payload) override
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (closing.load())
+            {
+                return false;
+            }
+            return conn.sendMessage(type, requestId, payload);
+        }
+
+        void close() override
+        {
+            // Replies are written synchronously, so shutting down wakes the reader
+            // without losing anything already sent.
+            if (!closing.exchange(true))
+            {
+                shutdown(sock, SHUT_RDWR);
+            }
+        }
+
+        uint64_t id() const override { return sessionId; }
+        bool isClosing() const { return closing.load(); }
+
+        Network::Connection conn;
+        std::unique_ptr<SessionHandler> handler;
+
+    private:
+        SOCKET sock;
+        uint64_t sessionId;
+        std::mutex sendMutex;
+        std::atomic<bool> closing{false};
+    };
+
+    void TcpServer::acceptLoop()
+    {
+        while (!stopping.load())
+        {
+            sockaddr_in clientAddr;
+            socklen_t clientSize = sizeof(clientAddr);
+            SOCKET clientSock = accept(listenSocket, reinterpret_cast<sockaddr *>(&clientAddr), &clientSize);
+            if (clientSock == INVALID_SOCKET)
+            {
+                if (!stopping.load())
+                {
+                    Logger::getInstance().log(LogLevel::ERR, "Accept failed: " + std::to_string(Network::lastSocketError()));
+                }
+                continue;
+            }
+
+            auto session = std::make_shared<BlockingSession>(clientSock, nextSessionId());
+            session->handler = handlerFactory();
+            {
+                std::lock_guard<std::mutex> lock(sessionsMutex);
+                blockingSessions[session->id()] = session;
+            }
+            // Connection threads are detached and counted through blockingSessions,
+            // so finished connections do not accumulate until shutdown.
+            std::thread(&TcpServer::serveBlocking, this, session).detach();
+        }
+    }
+
+    void TcpServer::serveBlocking(std::shared_ptr<BlockingSession> session)
+    {
+        SessionPtr asSession = session;
+        while (!session->isClosing())
+        {
+            MessageType type;
+            uint32_t requestId;
+            std::string payload;
+            if (!session->conn.receiveMessage(type, requestId, payload))
+            {
+                break;
+            }
+            session->handler->onMessage(asSession, type, requestId, payload);
+        }
+        session->close();
+        session->handler->onClose(asSession);
+
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        blockingSessions.erase(session->id());
+        sessionsDrained.notify_all();
+    }
+
+    // ---------------------------------------------------------------------
+    // Event-loop transport
+    // ---------------------------------------------------------------------
+
+#ifdef __linux__
+
+    namespace
+    {
+        const size_t kFrameHeaderSize = sizeof(FrameHeader);
+        const size_t kReadChunk = 64 * 1024;
+        // Most input a session buffers: one whole frame of the largest size allowed
+        const size_t kMaxBufferedInput = Config::MaxFrameBytes + kFrameHeaderSize;
+
+        bool setNonBlocking(int fd)
+        {
+            int flags = fcntl(fd, F_GETFL, 0);
+            return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+        }
+    } // namespace
+
+    struct TcpServer::LoopContext
+    {
+        EventLoop loop;
+        std::thread thread;
+        std::unique_ptr<char[]> readBuffer{new char[kReadChunk]}; // shared by the loop's sessions
+        std::unordered_map<int, std::shared_ptr<EpollSession>> sessions;
+    };
+
+    // Edge-triggered connection driven entirely by its owning loop thread. Input is
+    // parsed as a two-state machine (frame header, then frame body); output is
+    // buffered and drained on EPOLLOUT when the socket would block.
+    class TcpServer::EpollSession : public Session, public std::enable_shared_from_this<EpollSession>
+    {
+    public:
+        EpollSession(LoopContext &ctx, int fd, uint64_t id, std::unique_ptr<SessionHandler> handler)
+            : ctx(ctx), fd(fd), sessionId(id), handler(std::move(handler)) {}
+
+        ~EpollSession() override
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+
+        bool open()
+        {
+            auto weak = std::weak_ptr<EpollSession>(shared_from_this());
+            return ctx.loop.add(fd, EPOLLIN | EPOLLRDHUP | EPOLLET, [weak](uint32_t events) {
+                if (auto self = weak.lock())
+                {
+                    self->onEvents(events);
+                }
+            });
+        }
+
+        bool send(MessageType type, uint32_t requestId, const std::string &payload) override
+        {
+            FrameHeader header = frameHeader(type, requestId, payload.size());
+            bool flushNow;
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                if (closed)
+                {
+                    return false;
+                }
+                std::string &tail = outTail();
+                tail.append(reinterpret_cast<const char *>(&header), sizeof(header));
+                tail.append(payload);
+                flushNow = scheduleFlushLocked();
+            }
+            if (flushNow)
+            {
+                flush();
+            }
+            return true;
+        }
+
+        // The blobs are queued by reference and sent with sendfile(), never
+        // copied into outBuf
+        bool send(MessageType type, uint32_t requestId, SplicedPayload &&payload) override
+        {
+            FrameHeader header = frameHeader(type, requestId, payload.size());
+            bool flushNow;
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                if (closed)
+                {
+                    return false;
+                }
+                std::string *tail = &outTail();
+                tail->append(reinterpret_cast<const char *>(&header), sizeof(header));
+                size_t from = 0;
+                for (SplicedPayload::Splice &splice : payload.splices)
+                {
+                    tail->append(payload.bytes, from, splice.at - from);
+                    from = splice.at;
+                    outBlobs.push_back(PendingBlob{std::move(splice.blob), 0, std::string()});
+                    tail = &outBlobs.back().after;
+                }
+                tail->append(payload.bytes, from, std::string::npos);
+                flushNow = scheduleFlushLocked();
+            }
+            if (flushNow)
+            {
+                flush();
+            }
+            return true;
+        }
+
+        void close() override
+        {
+            if (!ctx.loop.isInLoopThread())
+            {
+                auto self = shared_from_this();
+                ctx.loop.post([self]() { self->close(); });
+                return;
+            }
+            closing = true;
+            flush();
+        }
+
+        uint64_t id() const override { return sessionId; }
+
+        void teardown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                if (closed)
+                {
+                    return;
+                }
+                closed = true;
+            }
+            auto self = shared_from_this();
+            ctx.loop.remove(fd);
+            ::close(fd);
+            fd = -1;
+            handler->onClose(self);
+            ctx.sessions.erase(sessionFd);
+        }
+
+        int sessionFd = -1;
+
+    private:
+        enum class ReadState
+        {
+            Header,
+            Body
+        };
+
+        // A blob queued for sendfile(), then the bytes queued behind it
+        struct PendingBlob
+        {
+            BlobRef blob;
+            uint64_t sent;
+            std::string after;
+        };
+
+        static FrameHeader frameHeader(MessageType type, uint32_t requestId, size_t size)
+        {
+            FrameHeader header;
+            header.type = static_cast<int32_t>(type);
+            header.requestId = requestId;
+            header.size = static_cast<int32_t>(size);
+            return header;
+        }
+
+        // Where new output goes; outMutex must be held
+        std::string &outTail()
+        {
+            return outBlobs.empty() ? outBuf : outBlobs.back().after;
+        }
+
+        // With outMutex held: true if the caller is the loop thread and should
+        // flush now, otherwise a flush is posted to the loop
+        bool scheduleFlushLocked()
+        {
+            if (ctx.loop.isInLoopThread())
+            {
+                return true;
+            }
+            if (!flushPosted)
+            {
+                flushPosted = true;
+                auto self = shared_from_this();
+                ctx.loop.post([self]() { self->flush(); });
+            }
+            return false;
+        }
+
+        void onEvents(uint32_t events)
+        {
+            if (events & EPOLLOUT)
+            {
+                flush();
+            }
+            if (fd < 0)
+            {
+                return;
+            }
+            if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            {
+                readAvailable();
+            }
+        }
+
+        // Frames are parsed after every read, so inBuf never holds more than
+        // the frame in progress: at most kMaxBufferedInput bytes
+        void readAvailable()
+        {
+            bool peerClosed = false;
+            bool failed = false;
+            while (!closing)
+            {
+                size_t room = std::min(kReadChunk, kMaxBufferedInput - inBuf.size());
+                ssize_t n = ::recv(fd, ctx.readBuffer.get(), room, 0);
+                if (n > 0)
+                {
+                    inBuf.append(ctx.readBuffer.get(), static_cast<size_t>(n));
+                    if (!parseFrames())
+                    {
+                        failed = true;
+                        break;
+                    }
+                    continue;
+                }
+                if (n == 0)
+                {
+                    peerClosed = true;
+                }
+                else if (errno == EINTR)
+                {
+                    continue;
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    failed = true;
+                }
+                break;
+            }
+
+            if (failed)
+            {
+                teardown();
+            }
+            else if (peerClosed)
+            {
+                // The peer is done sending; replies already queued still go
+                // out, and flush() tears the session down once they have
+                closing = true;
+                flush();
+            }
+        }
+
+        // Returns false on a malformed frame
+        bool parseFrames()
+        {
+            size_t offset = 0;
+            while (!closing)
+            {
+                size_t available = inBuf.size() - offset;
+                if (readState == ReadState::Header)
+                {
+                    if (available < kFrameHeaderSize)
+                        break;
+                    FrameHeader header;
+                    std::memcpy(&header, inBuf.data() + offset, sizeof(header));
+                    // A bogus size must not turn into a huge allocation
+                    if (header.size < 0 || static_cast<size_t>(header.size) > Config::MaxFrameBytes)
+                    {
+                        Logger::getInstance().log(LogLevel::ERR, "Malformed frame size from session " + std::to_string(sessionId));
+                        return false;
+                    }
+                    pendingType = static_cast<MessageType>(header.type);
+                    pendingRequestId = header.requestId;
+                    pendingSize = static_cast<size_t>(header.size);
+                    offset += kFrameHeaderSize;
+                    readState = ReadState::Body;
+                }
+                else
+                {
+                    if (available < pendingSize)
+                    {
+                        // Room for the rest of a large body up front instead of regrowing per read
+                        inBuf.reserve(inBuf.size() + (pendingSize - available));
+                        break;
+                    }
+                    std::string payload;
+                    if (offset == 0 && inBuf.size() == pendingSize)
+                    {
+                        // The body is all that is buffered: hand the buffer over
+                        payload.swap(inBuf);
+                    }
+                    else
+                    {
+                        payload.assign(inBuf.data() + offset, pendingSize);
+                        offset += pendingSize;
+                    }
+                    readState = ReadState::Header;
+                    handler->onMessage(shared_from_this(), pendingType, pendingRequestId, payload);
+                }
+            }
+            inBuf.erase(0, offset);
+            return true;
+        }
+
+        void flush()
+        {
+            bool drained;
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                flushPosted = false;
+                if (closed)
+                {
+                    return;
+                }
+                bool failed = false;
+                for (;;)
+                {
+                    ssize_t n;
+                    if (!outBuf.empty())
+                    {
+                        n = ::send(fd, outBuf.data(), outBuf.size(), MSG_NOSIGNAL);
+                        if (n > 0)
+                        {
+                            outBuf.erase(0, static_cast<size_t>(n));
+                            continue;
+                        }
+                    }
+                    else if (outBlobs.empty())
+                    {
+                        break;
+                    }
+                    else if (outBlobs.front().sent < outBlobs.front().blob.size)
+                    {
+                        PendingBlob &front = outBlobs.front();
+                        off_t at = static_cast<off_t>(front.blob.offset + front.sent);
+                        n = ::sendfile(fd, front.blob.segment->fd(), &at, front.blob.size - front.sent);
+                        if (n > 0)
+                        {
+                            front.sent += static_cast<uint64_t>(n);
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        // Blob done: the bytes queued behind it are next
+                        outBuf.swap(outBlobs.front().after);
+                        outBlobs.pop_front();
+                        continue;
+                    }
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                        break;
+                    failed = true;
+                    break;
+                }
+                if (failed)
+                {
+                    outBuf.clear();
+                    outBlobs.clear();
+                    closing = true; // write error, give up on the peer
+                }
+                drained = outBuf.empty() && outBlobs.empty();
+                if (!drained != wantWrite)
+                {
+                    wantWrite = !drained;
+                    ctx.loop.modify(fd, EPOLLIN | EPOLLRDHUP | EPOLLET | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u));
+                }
+            }
+            if (drained && closing)
+            {
+                teardown();
+            }
+        }
+
+        LoopContext &ctx;
+        int fd;
+        uint64_t sessionId;
+        std::unique_ptr<SessionHandler> handler;
+
+        // Loop-thread only
+        ReadState readState = ReadState::Header;
+        MessageType pendingType = MessageType::INVALID;
+        uint32_t pendingRequestId = 0;
+        size_t pendingSize = 0;
+        std::string inBuf;
+        bool closing = false;
+
+        // Shared with senders on other threads
+        std::mutex outMutex;
+        std::string outBuf;
+        std::deque<PendingBlob> outBlobs; // sent in order after outBuf
+        bool flushPosted = false;
+        bool wantWrite = false;
+        bool closed = false;
+    };
+
+    bool TcpServer::startEventLoops()
+    {
+        int count = numThreads > 0 ? numThreads : 1;
+        for (int i = 0; i < count; ++i)
+        {
+            auto ctx = std::make_unique<LoopContext>();
+            if (!ctx->loop.valid())
+            {
+                lastError = "Failed to create event loop";
+                return false;
+            }
+            loops.push_back(std::move(ctx));
+        }
+
+        setNonBlocking(listenSocket);
+        if (!loops[0]->loop.add(listenSocket, EPOLLIN | EPOLLET, [this](uint32_t) { acceptReady(); }))
+        {
+            lastError = "Failed to watch listen socket";
+            return false;
+        }
+
+        for (auto &ctx : loops)
+        {
+            LoopContext *raw = ctx.get();
+            ctx->thread = std::thread([raw]() { raw->loop.run(); });
+        }
+        return true;
+    }
+
+    // Runs on loop 0. Accepts until the backlog is empty and deals the new
+    // connections round-robin across all loops.
+    void TcpServer::acceptReady()
+    {
+        for (;;)
+        {
+            int fd = accept4(listenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK && !stopping.load())
+                {
+                    Logger::getInstance().log(LogLevel::ERR, "Accept failed: " + std::string(std::strerror(errno)));
+                }
+                return;
+            }
+
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+            LoopContext *ctx = loops[nextLoop++ % loops.size()].get();
+            uint64_t id = nextSessionId();
+            ctx->loop.post([this, ctx, fd, id]() {
+                auto session = std::make_shared<EpollSession>(*ctx, fd, id, handlerFactory());
+                session->sessionFd = fd;
+                if (!session->open())
+                {
+                    Logger::getInstance().log(LogLevel::ERR, "Failed to register connection " + std::to_string(id));
+                    return;
+                }
+                ctx->sessions[fd] = session;
+            });
+        }
+    }
+
+    void TcpServer::stopEventLoops()
+    {
+        for (auto &ctx : loops)
+        {
+            LoopContext *raw = ctx.get();
+            raw->loop.post([raw]() {
+                std::vector<std::shared_ptr<EpollSession>> open;
+                for (auto &entry : raw->sessions)
+                    open.push_back(entry.second);
+                for (auto &session : open)
+                    session->teardown();
+            });
+            raw->loop.stop();
+        }
+        for (auto &ctx : loops)
+        {
+            if (ctx->thread.joinable())
+                ctx->thread.join();
+        }
+        loops.clear();
+    }
+
+#endif // __linux__
+
+    // ---------------------------------------------------------------------
+    // Common
+    // ---------------------------------------------------------------------
+
+    TcpServer::TcpServer(int port, ServerMode mode, int numThreads)
+        : listenPort(port), serverMode(mode), numThreads(numThreads), listenSocket(INVALID_SOCKET)
+    {
+#ifndef __linux__
+        if (serverMode == ServerMode::EventLoop)
+        {
+            Logger::getInstance().log(LogLevel::WARN, "Event-loop mode needs epoll; using thread-per-connection.");
+            serverMode = ServerMode::ThreadPerConnection;
+        }
+#endif
+    }
+
+    TcpServer::~TcpServer()
+    {
+        stop();
+    }
+
+    ServerMode TcpServer::defaultMode()
+    {
+#ifdef __linux__
+        return ServerMode::EventLoop;
+#else
+        return ServerMode::ThreadPerConnection;
+#endif
+    }
+
+    bool TcpServer::openListenSocket()
+    {
+        listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == INVALID_SOCKET)
+        {
+            lastError = "Server socket creation failed";
+            return false;
+        }
+
+        int reuse = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse));
+
+        sockaddr_in serverAddr;
+        std::memset(&serverAddr, 0, sizeof(serverAddr));
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_addr.s_addr = INADDR_ANY;
+        serverAddr.sin_port = htons(static_cast<unsigned short>(listenPort));
+
+        if (bind(listenSocket, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr)) == SOCKET_ERROR)
+        {
+            lastError = "Bind failed: " + std::to_string(Network::lastSocketError());
+            return false;
+        }
+        if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR)
+        {
+            lastError = "Listen failed: " + std::to_string(Network::lastSocketError());
+            return false;
+        }
+
+        socklen_t len = sizeof(serverAddr);
+        if (getsockname(listenSocket, reinterpret_cast<sockaddr *>(&serverAddr), &len) == 0)
+        {
+            listenPort = ntohs(serverAddr.sin_port);
+        }
+        return true;
+    }
+
+    bool TcpServer::start(SessionHandlerFactory factory)
+    {
+        handlerFactory = std::move(factory);
+        stopping.store(false);
+        if (!openListenSocket())
+        {
+            return false;
+        }
+
+#ifdef __linux__
+        if (serverMode == ServerMode::EventLoop)
+        {
+            return startEventLoops();
+        }
+#endif
+        acceptThread = std::thread(&TcpServer::acceptLoop, this);
+        return true;
+    }
+
+    void TcpServer::stop()
+    {
+        if (stopping.exchange(true))
+        {
+            return;
+        }
+
+        if (listenSocket != INVALID_SOCKET)
+        {
+            // shutdown() is what actually wakes a blocked accept() on Linux
+            shutdown(listenSocket, SHUT_RDWR);
+        }
+
+#ifdef __linux__
+        stopEventLoops();
+#endif
+
+        if (acceptThread.joinable())
+        {
+            acceptThread.join();
+        }
+
+        std::unique_lock<std::mutex> lock(sessionsMutex);
+        for (auto &entry : blockingSessions)
+        {
+            if (auto session = entry.second.lock())
+            {
+                session->close();
+            }
+        }
+        sessionsDrained.wait(lock, [this]() { return blockingSessions.empty(); });
+        lock.unlock();
+
+        if (listenSocket != INVALID_SOCKET)
+        {
+            Network::closeSocket(listenSocket);
+            listenSocket = INVALID_SOCKET;
+        }
+    }
+
+} // namespace dtq
@@ -0,0 +1,157 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+
+namespace dtq
+{
+
+    TimingWheel::TimingWheel(int64_t tickMs, int64_t nowMs)
+        : tickMs(std::max<int64_t>(tickMs, 1)), currentTick(static_cast<uint64_t>(std::max<int64_t>(nowMs, 0)) / this->tickMs),
+          heads(kLevels * kSlots, kNil)
+    {
+    }
+
+    TimingWheel::TimerId TimingWheel::schedule(int64_t deadlineMs, uint64_t key)
+    {
+        uint32_t index;
+        if (!freeNodes.empty())
+        {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+
+        // Round up so a timer never fires before its deadline
+        int64_t deadline = std::max<int64_t>(deadlineMs, 0);
+        uint64_t tick = static_cast<uint64_t>((deadline + tickMs - 1) / tickMs);
+        Node &node = nodes[index];
+        node.key = key;
+        node.deadlineTick = std::max(tick, currentTick + 1);
+        place(index);
+        ++live;
+        return (static_cast<uint64_t>(node.generation) << 32) | index;
+    }
+
+    bool TimingWheel::cancel(TimerId id)
+    {
+        uint32_t index = static_cast<uint32_t>(id);
+        if (index >= nodes.size() || nodes[index].generation != static_cast<uint32_t>(id >> 32) ||
+            nodes[index].slot == kNil)
+        {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    void TimingWheel::advance(int64_t nowMs, std::vector<uint64_t> &expired)
+    {
+        uint64_t target = static_cast<uint64_t>(std::max<int64_t>(nowMs, 0)) / tickMs;
+        while (currentTick < target)
+        {
+            if (live == 0)
+            {
+                // Nothing can fire; skip the empty ticks
+                currentTick = target;
+                break;
+            }
+            ++currentTick;
+
+            // Refill lower levels from the highest one whose slot just came up,
+            // so a timer can drop several levels within this tick
+            int top = 0;
+            while (top + 1 < kLevels && (currentTick & ((uint64_t(1) << (kSlotBits * (top + 1))) - 1)) == 0)
+            {
+                ++top;
+            }
+            for (int level = top; level >= 1; --level)
+            {
+                cascade(level);
+            }
+
+            uint32_t slot = static_cast<uint32_t>(currentTick & (kSlots - 1));
+            while (heads[slot] != kNil)
+            {
+                uint32_t index = heads[slot];
+                unlink(index);
+                expired.push_back(nodes[index].key);
+                release(index);
+            }
+        }
+    }
+
+    void TimingWheel::place(uint32_t index)
+    {
+        Node &node = nodes[index];
+        uint64_t delta = node.deadlineTick > currentTick ? node.deadlineTick - currentTick : 0;
+        int level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1))))
+        {
+            ++level;
+        }
+        // Beyond the top level's reach: park in its farthest slot and re-place
+        // when that slot cascades
+        uint64_t maxDelta = (uint64_t(1) << (kSlotBits * kLevels)) - 1;
+        uint64_t tick = currentTick + std::min(delta, maxDelta);
+        uint32_t slot = level * kSlots + static_cast<uint32_t>((tick >> (kSlotBits * level)) & (kSlots - 1));
+
+        node.slot = slot;
+        node.prev = kNil;
+        node.next = heads[slot];
+        if (node.next != kNil)
+        {
+            nodes[node.next].prev = index;
+        }
+        heads[slot] = index;
+    }
+
+    void TimingWheel::unlink(uint32_t index)
+    {
+        Node &node = nodes[index];
+        if (node.prev != kNil)
+        {
+            nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            heads[node.slot] = node.next;
+        }
+        if (node.next != kNil)
+        {
+            nodes[node.next].prev = node.prev;
+        }
+        node.prev = node.next = kNil;
+    }
+
+    void TimingWheel::release(uint32_t index)
+    {
+        Node &node = nodes[index];
+        node.slot = kNil;
+        ++node.generation; // invalidates outstanding TimerIds
+        if (node.generation == 0)
+        {
+            node.generation = 1;
+        }
+        freeNodes.push_back(index);
+        --live;
+    }
+
+    void TimingWheel::cascade(int level)
+    {
+        uint32_t slot = level * kSlots + static_cast<uint32_t>((currentTick >> (kSlotBits * level)) & (kSlots - 1));
+        uint32_t index = heads[slot];
+        heads[slot] = kNil;
+        while (index != kNil)
+        {
+            uint32_t next = nodes[index].next;
+            place(index);
+            index = next;
+        }
+    }
+
+} // namespace dtq
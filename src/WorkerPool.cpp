@@ -0,0 +1,153 @@
+#include "WorkerPool.h"
+#include "Config.h"
+
+namespace dtq
+{
+
+    WorkerPool::WorkerPool(size_t threadCount, Process process)
+        : process(std::move(process))
+    {
+        size_t count = threadCount ? threadCount : static_cast<size_t>(Config::ThreadPoolSize);
+        for (size_t i = 0; i < count; ++i)
+        {
+            lanes.push_back(std::make_unique<Lane>());
+        }
+        running = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            threads.emplace_back(&WorkerPool::run, this, i);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        stop();
+    }
+
+    void WorkerPool::submit(std::vector<Task> &&tasks)
+    {
+        if (tasks.empty())
+        {
+            return;
+        }
+        // Counted before any is visible: a thread may take one the moment it
+        // is pushed, and its decrement must not wrap the count below zero
+        waiting.fetch_add(tasks.size());
+        for (Task &task : tasks)
+        {
+            Lane &lane = *lanes[nextLane.fetch_add(1, std::memory_order_relaxed) % lanes.size()];
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            lane.tasks.push_back(std::move(task));
+        }
+        {
+            // Pairs with the predicate check in run() so no wakeup is lost
+            std::lock_guard<std::mutex> lock(stateMutex);
+        }
+        if (tasks.size() == 1)
+        {
+            workAvailable.notify_one();
+        }
+        else
+        {
+            workAvailable.notify_all();
+        }
+    }
+
+    bool WorkerPool::waitForRoom(size_t limit, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        bool room = roomAvailable.wait_for(lock, timeout, [&]() { return stopping.load() || waiting.load() < limit; });
+        return room && !stopping.load();
+    }
+
+    std::vector<Task> WorkerPool::takeResults(std::chrono::milliseconds timeout)
+    {
+        std::vector<Task> out;
+        std::unique_lock<std::mutex> lock(resultsMutex);
+        resultsReady.wait_for(lock, timeout, [&]() { return !results.empty() || running == 0; });
+        out.swap(results);
+        return out;
+    }
+
+    void WorkerPool::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping.store(true);
+        }
+        workAvailable.notify_all();
+        roomAvailable.notify_all();
+        for (std::thread &thread : threads)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+        for (auto &lane : lanes)
+        {
+            std::lock_guard<std::mutex> lock(lane->mutex);
+            lane->tasks.clear();
+        }
+        waiting.store(0);
+    }
+
+    // Own deque from the front, then siblings' from the back
+    bool WorkerPool::takeTask(size_t index, Task &task)
+    {
+        for (size_t i = 0; i < lanes.size(); ++i)
+        {
+            Lane &lane = *lanes[(index + i) % lanes.size()];
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            if (lane.tasks.empty())
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                task = std::move(lane.tasks.front());
+                lane.tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(lane.tasks.back());
+                lane.tasks.pop_back();
+                stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+            waiting.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    void WorkerPool::run(size_t index)
+    {
+        while (!stopping.load())
+        {
+            Task task;
+            if (!takeTask(index, task))
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                workAvailable.wait(lock, [&]() { return stopping.load() || waiting.load() > 0; });
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+            }
+            roomAvailable.notify_one();
+
+            int64_t startUs = monotonicUs();
+            process(task, static_cast<int>(index) + 1);
+            busy.fetch_add(static_cast<uint64_t>(monotonicUs() - startUs), std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            results.push_back(std::move(task));
+            resultsReady.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        --running;
+        resultsReady.notify_all();
+    }
+
+} // namespace dtq
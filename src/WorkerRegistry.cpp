@@ -0,0 +1,159 @@
+#include "WorkerRegistry.h"
+#include "Config.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace dtq
+{
+
+    WorkerRegistry::WorkerRegistry(TakeTasks takeTasks, size_t maxBatch)
+        : takeTasks(std::move(takeTasks)), maxBatch(maxBatch ? maxBatch : static_cast<size_t>(Config::BatchSize))
+    {
+    }
+
+    void WorkerRegistry::add(WorkerId id, size_t home, uint32_t credits, int64_t nowMs, Push push, Evict evict)
+    {
+        std::vector<std::pair<Push, std::vector<Task>>> pushes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Worker &worker = workers[id];
+            worker.home = home;
+            worker.credits = credits;
+            worker.lastSeenMs = nowMs;
+            worker.push = std::move(push);
+            worker.evict = std::move(evict);
+            markReadyLocked(id, worker);
+            dispatchLocked(pushes);
+        }
+        deliver(pushes);
+    }
+
+    bool WorkerRegistry::heartbeat(WorkerId id, uint32_t credits, int64_t nowMs)
+    {
+        std::vector<std::pair<Push, std::vector<Task>>> pushes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = workers.find(id);
+            if (it == workers.end())
+            {
+                return false;
+            }
+            Worker &worker = it->second;
+            worker.lastSeenMs = nowMs;
+            if (credits == 0)
+            {
+                return true;
+            }
+            worker.credits += credits;
+            markReadyLocked(id, worker);
+            dispatchLocked(pushes);
+        }
+        deliver(pushes);
+        return true;
+    }
+
+    void WorkerRegistry::remove(WorkerId id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = workers.find(id);
+        if (it == workers.end())
+        {
+            return;
+        }
+        if (it->second.ready)
+        {
+            readyOrder.erase(it->second.readyPos);
+        }
+        workers.erase(it);
+    }
+
+    void WorkerRegistry::onTasksAvailable()
+    {
+        std::vector<std::pair<Push, std::vector<Task>>> pushes;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            dispatchLocked(pushes);
+        }
+        deliver(pushes);
+    }
+
+    std::vector<WorkerRegistry::Evict> WorkerRegistry::expire(int64_t silentSinceMs)
+    {
+        std::vector<Evict> evicted;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = workers.begin(); it != workers.end();)
+        {
+            if (it->second.lastSeenMs >= silentSinceMs)
+            {
+                ++it;
+                continue;
+            }
+            if (it->second.ready)
+            {
+                readyOrder.erase(it->second.readyPos);
+            }
+            evicted.push_back(std::move(it->second.evict));
+            it = workers.erase(it);
+        }
+        return evicted;
+    }
+
+    size_t WorkerRegistry::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return workers.size();
+    }
+
+    uint64_t WorkerRegistry::credits()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const auto &entry : workers)
+        {
+            total += entry.second.credits;
+        }
+        return total;
+    }
+
+    void WorkerRegistry::markReadyLocked(WorkerId id, Worker &worker)
+    {
+        if (worker.credits > 0 && !worker.ready)
+        {
+            worker.readyPos = readyOrder.insert(readyOrder.end(), id);
+            worker.ready = true;
+        }
+    }
+
+    // Taking tasks under the lock pairs with onTasksAvailable(), so a task
+    // enqueued while a worker registers or returns credit is not missed.
+    void WorkerRegistry::dispatchLocked(std::vector<std::pair<Push, std::vector<Task>>> &pushes)
+    {
+        while (!readyOrder.empty())
+        {
+            WorkerId id = readyOrder.front();
+            Worker &worker = workers[id];
+            std::vector<Task> tasks = takeTasks(worker.home, std::min<size_t>(worker.credits, maxBatch));
+            if (tasks.empty())
+            {
+                break;
+            }
+            worker.credits -= static_cast<uint32_t>(tasks.size());
+            pushes.emplace_back(worker.push, std::move(tasks));
+            // To the back of the line, or out of it if its credit is used up
+            readyOrder.pop_front();
+            worker.ready = false;
+            markReadyLocked(id, worker);
+        }
+    }
+
+    // Outside the lock: a push may requeue tasks and re-enter
+    void WorkerRegistry::deliver(std::vector<std::pair<Push, std::vector<Task>>> &pushes)
+    {
+        for (auto &entry : pushes)
+        {
+            entry.first(std::move(entry.second));
+        }
+    }
+
+} // namespace dtq
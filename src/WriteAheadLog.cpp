@@ -0,0 +1,437 @@
+#include "WriteAheadLog.h"
+#include "Wire.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace dtq
+{
+
+    namespace
+    {
+        const size_t kRecordHeaderSize = 4 + 4 + 1;
+        // Flush early once this much is buffered, whatever the delay
+        const size_t kMaxBatchBytes = 4 * 1024 * 1024;
+        const size_t kReadChunk = 4 * 1024 * 1024;
+        // Larger lengths can only come from a corrupt header
+        const uint32_t kMaxRecordBytes = 1u << 30;
+
+        uint32_t crc32(uint8_t type, std::string_view body)
+        {
+            static uint32_t table[256] = {0};
+            static bool ready = [] {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    table[i] = c;
+                }
+                return true;
+            }();
+            (void)ready;
+
+            uint32_t crc = 0xFFFFFFFFu;
+            crc = table[(crc ^ type) & 0xFF] ^ (crc >> 8);
+            for (char ch : body)
+                crc = table[(crc ^ static_cast<uint8_t>(ch)) & 0xFF] ^ (crc >> 8);
+            return crc ^ 0xFFFFFFFFu;
+        }
+
+        void encodeRecord(std::string &out, WriteAheadLog::RecordType type, std::string_view body)
+        {
+            uint8_t t = static_cast<uint8_t>(type);
+            wire::putU32(out, static_cast<uint32_t>(body.size()));
+            wire::putU32(out, crc32(t, body));
+            wire::putU8(out, t);
+            out.append(body.data(), body.size());
+        }
+
+        std::string idBody(int taskId)
+        {
+            std::string body;
+            wire::putI32(body, taskId);
+            return body;
+        }
+
+        int openFile(const std::string &path, bool truncate)
+        {
+#ifdef _WIN32
+            int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND);
+            return _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+            int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND);
+            return ::open(path.c_str(), flags, 0644);
+#endif
+        }
+
+        void closeFile(int fd)
+        {
+#ifdef _WIN32
+            _close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+
+        bool writeFile(int fd, const std::string &data)
+        {
+            size_t written = 0;
+            while (written < data.size())
+            {
+#ifdef _WIN32
+                int n = _write(fd, data.data() + written, static_cast<unsigned>(data.size() - written));
+#else
+                ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+                if (n < 0 && errno == EINTR)
+                    continue;
+#endif
+                if (n <= 0)
+                    return false;
+                written += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool syncFd(int fd)
+        {
+#ifdef _WIN32
+            return _commit(fd) == 0;
+#elif defined(__linux__)
+            return ::fdatasync(fd) == 0;
+#else
+            return ::fsync(fd) == 0;
+#endif
+        }
+    } // namespace
+
+    WriteAheadLog::WriteAheadLog(std::chrono::microseconds maxCommitDelay) : maxCommitDelay(maxCommitDelay) {}
+
+    WriteAheadLog::~WriteAheadLog()
+    {
+        close();
+    }
+
+    bool WriteAheadLog::replay(const std::string &path, Recovered &recovered, std::string &error)
+    {
+        struct Live
+        {
+            uint64_t order; // queue position; a requeue moves the task to the back
+            bool inFlight;
+            Task task;
+        };
+        std::unordered_map<int, Live> live;
+        uint64_t order = 0;
+
+        FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file)
+        {
+            if (errno == ENOENT)
+                return true; // first start
+            error = "Cannot open WAL " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        std::string data;
+        size_t offset = 0;
+        bool eof = false;
+        // Makes at least need unread bytes available unless the file ends first
+        auto ensure = [&](size_t need) {
+            while (data.size() - offset < need && !eof)
+            {
+                data.erase(0, offset);
+                offset = 0;
+                size_t have = data.size();
+                data.resize(have + std::max(kReadChunk, need));
+                size_t n = std::fread(&data[have], 1, data.size() - have, file);
+                data.resize(have + n);
+                eof = n == 0;
+            }
+            return data.size() - offset >= need;
+        };
+
+        for (;;)
+        {
+            if (!ensure(kRecordHeaderSize))
+            {
+                recovered.truncated = offset < data.size();
+                break;
+            }
+            wire::Reader header(std::string_view(data).substr(offset, kRecordHeaderSize));
+            uint32_t length, crc;
+            uint8_t type;
+            header.getU32(length);
+            header.getU32(crc);
+            header.getU8(type);
+            if (length > kMaxRecordBytes || !ensure(kRecordHeaderSize + length))
+            {
+                recovered.truncated = true;
+                break;
+            }
+            std::string_view body = std::string_view(data).substr(offset + kRecordHeaderSize, length);
+            if (crc32(type, body) != crc)
+            {
+                recovered.truncated = true;
+                break;
+            }
+            offset += kRecordHeaderSize + length;
+            ++recovered.records;
+
+            wire::Reader fields(body);
+            int32_t taskId = 0;
+            switch (static_cast<RecordType>(type))
+            {
+            case RecordType::Enqueue:
+            {
+                TaskView view;
+                if (Task::decode(body, view))
+                    live[view.taskId] = Live{order++, false, Task::fromView(view)};
+                break;
+            }
+            case RecordType::Assign:
+                if (fields.getI32(taskId))
+                {
+                    auto it = live.find(taskId);
+                    if (it != live.end())
+                        it->second.inFlight = true;
+                }
+                break;
+            case RecordType::Requeue:
+                if (fields.getI32(taskId))
+                {
+                    auto it = live.find(taskId);
+                    if (it != live.end())
+                    {
+                        it->second.inFlight = false;
+                        it->second.order = order++;
+                    }
+                }
+                break;
+            case RecordType::Complete:
+            case RecordType::Drop:
+                if (fields.getI32(taskId))
+                    live.erase(taskId);
+                break;
+            default:
+                break; // unknown record types from newer versions are skipped
+            }
+        }
+        std::fclose(file);
+
+        std::vector<Live *> ordered;
+        ordered.reserve(live.size());
+        for (auto &entry : live)
+            ordered.push_back(&entry.second);
+        std::sort(ordered.begin(), ordered.end(), [](const Live *a, const Live *b) { return a->order < b->order; });
+        for (Live *entry : ordered)
+            (entry->inFlight ? recovered.inFlight : recovered.pending).push_back(std::move(entry->task));
+        return true;
+    }
+
+    bool WriteAheadLog::open(const std::string &path, Recovered &recovered)
+    {
+        std::string error;
+        if (!replay(path, recovered, error))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastError = error;
+            return false;
+        }
+
+        // Compact: rewrite the log with just the live tasks, then swap it in
+        std::string snapshot;
+        for (const std::vector<Task> *tasks : {&recovered.pending, &recovered.inFlight})
+        {
+            for (const Task &task : *tasks)
+                encodeRecord(snapshot, RecordType::Enqueue, task.serialize());
+        }
+        std::string tmpPath = path + ".tmp";
+        int tmp = openFile(tmpPath, true);
+        bool ok = tmp >= 0 && writeFile(tmp, snapshot) && syncFd(tmp);
+        if (tmp >= 0)
+            closeFile(tmp);
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastError = "Cannot rewrite WAL " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        fd = openFile(path, false);
+        if (fd < 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastError = "Cannot open WAL " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running = true;
+        failed = false;
+        flusher = std::thread(&WriteAheadLog::flusherLoop, this);
+        return true;
+    }
+
+    void WriteAheadLog::close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running)
+                return;
+            running = false;
+        }
+        flushWake.notify_all();
+        if (flusher.joinable())
+            flusher.join();
+        closeFile(fd);
+        fd = -1;
+    }
+
+    uint64_t WriteAheadLog::append(RecordType type, std::string_view body)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (buffer.empty())
+        {
+            oldestBuffered = std::chrono::steady_clock::now();
+            flushWake.notify_one();
+        }
+        encodeRecord(buffer, type, body);
+        if (buffer.size() >= kMaxBatchBytes)
+            flushWake.notify_one();
+        return nextLsn++;
+    }
+
+    uint64_t WriteAheadLog::logEnqueue(const Task &task)
+    {
+        return append(RecordType::Enqueue, task.serialize());
+    }
+
+    uint64_t WriteAheadLog::logAssign(int taskId)
+    {
+        return append(RecordType::Assign, idBody(taskId));
+    }
+
+    uint64_t WriteAheadLog::logComplete(int taskId, TaskStatus status, std::string_view result)
+    {
+        std::string body = idBody(taskId);
+        wire::putU8(body, static_cast<uint8_t>(status));
+        wire::putBytes(body, result);
+        return append(RecordType::Complete, body);
+    }
+
+    uint64_t WriteAheadLog::logRequeue(int taskId)
+    {
+        return append(RecordType::Requeue, idBody(taskId));
+    }
+
+    uint64_t WriteAheadLog::logDrop(int taskId)
+    {
+        return append(RecordType::Drop, idBody(taskId));
+    }
+
+    void WriteAheadLog::whenDurable(uint64_t lsn, Durable done)
+    {
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (lsn > durableLsn && !failed)
+            {
+                callbacks.emplace_back(lsn, std::move(done));
+                return;
+            }
+            ok = !failed;
+        }
+        done(ok);
+    }
+
+    bool WriteAheadLog::waitDurable(uint64_t lsn)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        durableWake.wait(lock, [&]() { return durableLsn >= lsn || failed; });
+        return durableLsn >= lsn;
+    }
+
+    uint64_t WriteAheadLog::syncCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return syncs;
+    }
+
+    std::string WriteAheadLog::getLastError()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lastError;
+    }
+
+    void WriteAheadLog::flusherLoop()
+    {
+        std::string writing;
+        std::vector<std::pair<uint64_t, Durable>> done;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            flushWake.wait(lock, [this]() { return !buffer.empty() || !running; });
+            if (buffer.empty())
+                break; // stopped with nothing left to flush
+
+            // Give other connections until the window closes to join this fsync
+            auto deadline = oldestBuffered + maxCommitDelay;
+            flushWake.wait_until(lock, deadline, [this]() { return !running || buffer.size() >= kMaxBatchBytes; });
+
+            writing.clear();
+            writing.swap(buffer);
+            uint64_t batchEnd = nextLsn - 1;
+            done.clear();
+            done.swap(callbacks);
+
+            lock.unlock();
+            bool ok = writeAll(writing) && syncFile();
+            lock.lock();
+
+            ++syncs;
+            if (ok)
+                durableLsn = batchEnd;
+            else
+                failed = true;
+            durableWake.notify_all();
+
+            lock.unlock();
+            for (auto &entry : done)
+                entry.second(ok);
+            lock.lock();
+        }
+    }
+
+    bool WriteAheadLog::writeAll(const std::string &data)
+    {
+        if (writeFile(fd, data))
+            return true;
+        std::lock_guard<std::mutex> lock(mutex);
+        lastError = std::string("WAL write failed: ") + std::strerror(errno);
+        return false;
+    }
+
+    bool WriteAheadLog::syncFile()
+    {
+        if (syncFd(fd))
+            return true;
+        std::lock_guard<std::mutex> lock(mutex);
+        lastError = std::string("WAL fsync failed: ") + std::strerror(errno);
+        return false;
+    }
+
+} // namespace dtq
@@ -1,21 +1,73 @@
 #include "Network.h"
 #include "Task.h"
 #include "Logger.h"
+#include "Config.h"
+#include "TaskStore.h"
+#include "Metrics.h"
+#include "Wire.h"
+#include "Admission.h"
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 using namespace dtq;
 
-int main()
+// Submissions of the task before giving up on a server that keeps rejecting it
+static constexpr int kSubmitAttempts = 5;
+
+// Lists the server's dead-lettered tasks with their last error; with
+// requeueAll, sends them all back to the queue with a fresh retry budget
+static void inspectDeadLetters(Network::Client &client, bool requeueAll)
 {
+    std::string request;
+    wire::putU32(request, 0);
+    Message response;
+    std::vector<TaskView> tasks;
+    if (!client.call(MessageType::CLIENT_GET_DEAD_LETTERS, request, response, Config::NetworkTimeout) ||
+        response.type != MessageType::SERVER_DEAD_LETTERS || !Task::decodeBatch(response.payload, tasks))
+    {
+        Logger::getInstance().log(LogLevel::ERR, "Dead-letter lookup failed: " + client.getLastError());
+        return;
+    }
+    for (const TaskView &task : tasks)
+    {
+        Logger::getInstance().log(LogLevel::INFO, "Dead letter: task " + std::to_string(task.taskId) + ": " + std::string(task.result));
+    }
+    if (!requeueAll || tasks.empty())
+    {
+        return;
+    }
+
+    // count 0 requeues everything, including tasks dead-lettered since the listing
+    request.clear();
+    wire::putU32(request, 0);
+    uint32_t requeued = 0;
+    if (client.call(MessageType::CLIENT_REQUEUE_DEAD_LETTERS, request, response, Config::NetworkTimeout) &&
+        response.type == MessageType::SERVER_DEAD_LETTERS_REQUEUED && wire::Reader(response.payload).getU32(requeued))
+    {
+        Logger::getInstance().log(LogLevel::INFO, "Requeued " + std::to_string(requeued) + " dead-lettered tasks");
+    }
+    else
+    {
+        Logger::getInstance().log(LogLevel::ERR, "Dead-letter requeue failed: " + client.getLastError());
+    }
+}
+
+// client [--requeue-dead-letters]
+int main(int argc, char **argv)
+{
+    bool requeueDeadLetters = argc > 1 && std::strcmp(argv[1], "--requeue-dead-letters") == 0;
+
     Logger::getInstance().setLogFile("client.log");
     Logger::getInstance().log(LogLevel::INFO, "Starting Task Queue Client...");
 
     // Initialize network
     if (!Network::initialize())
     {
-        Logger::getInstance().log(LogLevel::ERROR, "Network initialization failed.");
+        Logger::getInstance().log(LogLevel::ERR, "Network initialization failed.");
         return -1;
     }
 
@@ -24,34 +76,106 @@ int main()
     task.taskId = 1;
     task.payload = "Process Data XYZ";
     task.status = TaskStatus::PENDING;
+    // Interactive submission: ahead of bulk work when the server runs --queue=priority
+    task.priority = Config::PriorityLevels - 1;
+    task.trace.submittedUs = monotonicUs();
+    task.enqueueTimeMs = task.trace.submittedUs / 1000;
 
     // Serialize the task
     std::string serializedTask = task.serialize();
 
     // Connect to the server (change IP and port as necessary)
-    Network::Connection connection("127.0.0.1", 5555); // Updated to match server port
-    if (!connection.connect())
+    Network::Client client("127.0.0.1", 5555); // Updated to match server port
+    if (!client.connect())
     {
-        Logger::getInstance().log(LogLevel::ERR, "Client failed to connect to server: " + connection.getLastError());
+        Logger::getInstance().log(LogLevel::ERR, "Client failed to connect to server: " + client.getLastError());
         Network::cleanup();
         return -1;
     }
 
-    // Send the task using the appropriate message type
-    if (!connection.sendMessage(MessageType::CLIENT_ADD_TASK, serializedTask))
+    // Send the task using the appropriate message type and wait for the server's
+    // verdict. A full queue says when to try again; give it a few tries.
+    Message response;
+    for (int attempt = 1;; ++attempt)
     {
-        Logger::getInstance().log(LogLevel::ERROR, "Client failed to send task: " + connection.getLastError());
-        connection.disconnect();
-        Network::cleanup();
-        return -1;
+        if (!client.call(MessageType::CLIENT_ADD_TASK, serializedTask, response, Config::NetworkTimeout))
+        {
+            Logger::getInstance().log(LogLevel::ERR, "Client failed to send task: " + client.getLastError());
+            client.disconnect();
+            Network::cleanup();
+            return -1;
+        }
+        if (response.type == MessageType::SERVER_TASK_ACCEPTED)
+        {
+            break;
+        }
+
+        uint32_t retryAfter = 0;
+        std::string reason = "unexpected reply";
+        if (response.type == MessageType::SERVER_TASK_REJECTED)
+        {
+            decodeRejection(response.payload, retryAfter, reason);
+        }
+        if (retryAfter == 0 || attempt == kSubmitAttempts)
+        {
+            Logger::getInstance().log(LogLevel::WARN, "Task " + std::to_string(task.taskId) + " not accepted: " + reason);
+            client.disconnect();
+            Network::cleanup();
+            return 0;
+        }
+        Logger::getInstance().log(LogLevel::INFO, "Task " + std::to_string(task.taskId) + " rejected (" + reason +
+                                                      "), retrying in " + std::to_string(retryAfter) + "ms");
+        std::this_thread::sleep_for(std::chrono::milliseconds(retryAfter));
     }
+    Logger::getInstance().log(LogLevel::INFO, "Task " + std::to_string(task.taskId) + " accepted by server.");
 
-    Logger::getInstance().log(LogLevel::INFO, "Task " + std::to_string(task.taskId) + " sent to server.");
+    // Poll for the result until the task finishes
+    std::string request;
+    wire::putI32(request, task.taskId);
+    auto giveUpAt = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (std::chrono::steady_clock::now() < giveUpAt)
+    {
+        if (!client.call(MessageType::CLIENT_GET_RESULT, request, response, Config::NetworkTimeout) ||
+            response.type != MessageType::SERVER_TASK_RESULT)
+        {
+            Logger::getInstance().log(LogLevel::ERR, "Result lookup failed: " + client.getLastError());
+            break;
+        }
+
+        std::string_view body(response.payload);
+        int taskId = 0;
+        std::optional<TaskRecord> record;
+        if (TaskStore::decodeRecord(body, taskId, record) && record &&
+            (record->status == TaskStatus::COMPLETED || record->status == TaskStatus::FAILED))
+        {
+            Logger::getInstance().log(LogLevel::INFO, "Task " + std::to_string(taskId) +
+                                                          (record->status == TaskStatus::COMPLETED ? " completed: " : " failed: ") +
+                                                          record->result);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
 
-    // Optionally, wait for a response from the server
-    // (Not implemented in this demo; in a real system, you might receive an acknowledgement)
+    // Server-wide view, including how long tasks spend in each stage
+    StatsSnapshot stats;
+    if (client.call(MessageType::CLIENT_GET_STATS, "", response, Config::NetworkTimeout) &&
+        response.type == MessageType::SERVER_STATS && StatsSnapshot::decode(response.payload, stats))
+    {
+        const StatsSnapshot::StageStats &endToEnd = stats.stages[static_cast<size_t>(Stage::EndToEnd)];
+        Logger::getInstance().log(LogLevel::INFO, "Server stats: queueDepth=" + std::to_string(stats.queueDepth) +
+                                                      " inFlight=" + std::to_string(stats.inFlight) +
+                                                      " accepted=" + std::to_string(stats.accepted) +
+                                                      " completed=" + std::to_string(stats.completed) +
+                                                      " deadLetters=" + std::to_string(stats.deadLetters) +
+                                                      " workers=" + std::to_string(stats.workers.size()) +
+                                                      " endToEnd p99=" + std::to_string(endToEnd.p99) + "us");
+        if (stats.deadLetters > 0)
+        {
+            inspectDeadLetters(client, requeueDeadLetters);
+        }
+    }
 
-    connection.disconnect();
+    client.disconnect();
     Network::cleanup();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,704 @@
+// Open-loop load generator. Each client connection submits tasks on its own
+// arrival schedule (Poisson or constant rate), independent of how fast the
+// server answers, then polls for results. Latency is measured from each
+// task's *scheduled* submit time, so a stalled server (or generator) shows up
+// as latency instead of silently lowering the offered load (coordinated
+// omission).
+//
+//   load_generator [--host=127.0.0.1] [--port=5555] [--clients=2] [--rate=2]
+//                  [--arrival=poisson|constant] [--duration=5] [--drain=30]
+//                  [--payload=64] [--task-ms=uniform:500:1500] [--delay-ms=0]
+//                  [--priority=0] [--fail-rate=0] [--poll-ms=10] [--first-id=1000]
+//                  [--adaptive] [--json=path|-]
+//
+// Distributions (--payload bytes, --task-ms, --delay-ms): N, uniform:MIN:MAX or
+// exp:MEAN. --delay-ms sets each task's not-before time that far past its
+// submission; end-to-end latency then includes the delay. --fail-rate=P marks
+// that fraction of tasks to fail on every attempt, exercising retries and the
+// dead-letter queue.
+//
+// --adaptive closes the loop the way a well-behaved client would: arrivals
+// wait in a local backlog that is sent at an AIMD rate (AimdRate), which
+// backs off when the server rejects tasks and pauses for its retry-after
+// hint; rejected tasks go back to the front of the backlog instead of being
+// lost. Latency is still measured from the scheduled time, so the backlog
+// shows up in it.
+
+#include "Network.h"
+#include "Task.h"
+#include "TaskStore.h"
+#include "Logger.h"
+#include "Config.h"
+#include "Histogram.h"
+#include "Metrics.h"
+#include "Wire.h"
+#include "Admission.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace dtq;
+
+namespace
+{
+    struct Distribution
+    {
+        enum class Kind
+        {
+            Fixed,
+            Uniform,
+            Exponential
+        };
+
+        Kind kind = Kind::Fixed;
+        double a = 0;
+        double b = 0;
+
+        static bool parse(const std::string &spec, Distribution &out)
+        {
+            char *end = nullptr;
+            if (spec.rfind("uniform:", 0) == 0)
+            {
+                out.kind = Kind::Uniform;
+                out.a = std::strtod(spec.c_str() + 8, &end);
+                if (*end != ':')
+                    return false;
+                out.b = std::strtod(end + 1, &end);
+                return *end == '\0' && out.a >= 0 && out.b >= out.a;
+            }
+            if (spec.rfind("exp:", 0) == 0)
+            {
+                out.kind = Kind::Exponential;
+                out.a = std::strtod(spec.c_str() + 4, &end);
+                return *end == '\0' && out.a > 0;
+            }
+            out.kind = Kind::Fixed;
+            out.a = std::strtod(spec.c_str(), &end);
+            return !spec.empty() && *end == '\0' && out.a >= 0;
+        }
+
+        long long sample(std::mt19937_64 &rng) const
+        {
+            switch (kind)
+            {
+            case Kind::Uniform:
+                return static_cast<long long>(std::uniform_real_distribution<double>(a, b)(rng));
+            case Kind::Exponential:
+                return static_cast<long long>(std::exponential_distribution<double>(1.0 / a)(rng));
+            default:
+                return static_cast<long long>(a);
+            }
+        }
+
+        std::string describe() const
+        {
+            switch (kind)
+            {
+            case Kind::Uniform:
+                return "uniform:" + std::to_string(static_cast<long long>(a)) + ":" + std::to_string(static_cast<long long>(b));
+            case Kind::Exponential:
+                return "exp:" + std::to_string(static_cast<long long>(a));
+            default:
+                return std::to_string(static_cast<long long>(a));
+            }
+        }
+    };
+
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 5555;
+        int clients = 2;
+        double rate = 2.0; // tasks per second, all clients together
+        bool poisson = true;
+        double durationSec = 5.0;
+        double drainSec = 30.0;
+        Distribution payloadBytes;
+        Distribution taskMs;
+        Distribution delayMs;
+        int priority = 0;
+        double failRate = 0.0;
+        int pollMs = 10;
+        int firstId = 1000;
+        bool adaptive = false;
+        std::string jsonPath;
+    };
+
+    // Shared by all client threads; histograms and counters are lock-free
+    struct Results
+    {
+        Histogram ackLatencyUs;      // scheduled submit -> accept/reject verdict
+        Histogram endToEndLatencyUs; // scheduled submit -> result observed
+        Histogram sendLagUs;         // how late the generator itself sent each task
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> resent{0}; // --adaptive: rejected tasks sent again
+        std::atomic<uint64_t> unsent{0}; // --adaptive: still in the backlog at the end
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> errors{0}; // lost to connection failures
+        std::atomic<int64_t> lastResultUs{0};
+    };
+
+    struct Submitted
+    {
+        int taskId;
+        int64_t scheduledUs;
+    };
+
+    struct OutstandingSubmit
+    {
+        std::future<Message> reply;
+        std::vector<Submitted> tasks;
+        std::vector<Task> sentTasks; // --adaptive only, to resend rejected ones
+    };
+
+    // Waiting in an --adaptive client's backlog
+    struct Pending
+    {
+        Task task;
+        bool resend;
+    };
+
+    bool ready(std::future<Message> &future)
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    void noteLatest(std::atomic<int64_t> &latest, int64_t value)
+    {
+        int64_t current = latest.load(std::memory_order_relaxed);
+        while (current < value && !latest.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    class LoadClient
+    {
+    public:
+        LoadClient(const Options &options, Results &results, std::atomic<int> &nextTaskId, int index)
+            : options(options), results(results), nextTaskId(nextTaskId), client(options.host, options.port),
+              rng(0x5eed0000ULL + static_cast<uint64_t>(index)),
+              // Starts at the offered rate, may reach twice it to work off a
+              // backlog, and regains a tenth of it per second after backing off
+              rate(options.rate / options.clients, 1.0, 2 * options.rate / options.clients,
+                   std::max(1.0, 0.1 * options.rate / options.clients))
+        {
+        }
+
+        void run(int64_t startUs)
+        {
+            int64_t endUs = startUs + static_cast<int64_t>(options.durationSec * 1e6);
+            int64_t drainUntilUs = endUs + static_cast<int64_t>(options.drainSec * 1e6);
+            int64_t nextArrivalUs = startUs + interArrivalUs();
+            int64_t nextPollUs = startUs;
+
+            for (;;)
+            {
+                int64_t now = monotonicUs();
+                bool arriving = now < endUs;
+                if (!arriving && ((submits.empty() && outstanding.empty() && pending.empty() && !poll.valid()) ||
+                                  now >= drainUntilUs))
+                {
+                    break;
+                }
+                if (!client.connect())
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    continue;
+                }
+
+                // Everything scheduled up to now goes out in one frame, so a
+                // generator that falls behind catches up instead of drifting
+                while (arriving && nextArrivalUs <= now && nextArrivalUs < endUs)
+                {
+                    pending.push_back({makeTask(nextArrivalUs), false});
+                    nextArrivalUs += interArrivalUs();
+                }
+                size_t sendable = options.adaptive ? std::min(pending.size(), rate.available(now)) : pending.size();
+                if (sendable > 0)
+                {
+                    sendBatch(sendable, now);
+                }
+
+                harvestSubmits();
+                harvestPoll();
+
+                if (!poll.valid() && !outstanding.empty() && now >= nextPollUs)
+                {
+                    sendPoll();
+                    nextPollUs = now + options.pollMs * 1000LL;
+                }
+
+                // Wake for the next arrival or poll, but at least every
+                // millisecond to pick up replies
+                int64_t wakeUs = std::min<int64_t>(now + 1000, arriving ? nextArrivalUs : now + 1000);
+                if (!outstanding.empty())
+                {
+                    wakeUs = std::min(wakeUs, std::max(nextPollUs, now));
+                }
+                if (!pending.empty())
+                {
+                    wakeUs = std::min(wakeUs, std::max(rate.nextSendUs(), now));
+                }
+                if (wakeUs > now)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(wakeUs - now));
+                }
+            }
+            results.unsent.fetch_add(pending.size(), std::memory_order_relaxed);
+            client.disconnect();
+        }
+
+    private:
+        void sendBatch(size_t count, int64_t now)
+        {
+            std::vector<Task> batch;
+            OutstandingSubmit submit;
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                Pending next = std::move(pending.front());
+                pending.pop_front();
+                int64_t scheduledUs = next.task.trace.submittedUs;
+                submit.tasks.push_back({next.task.taskId, scheduledUs});
+                if (next.resend)
+                {
+                    results.resent.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    results.sent.fetch_add(1, std::memory_order_relaxed);
+                    results.sendLagUs.record(now - scheduledUs);
+                }
+                batch.push_back(std::move(next.task));
+            }
+            if (options.adaptive)
+            {
+                rate.take(count);
+                submit.sentTasks = batch;
+            }
+            submit.reply = client.request(MessageType::CLIENT_ADD_TASK_BATCH, Task::serializeBatch(batch));
+            submits.push_back(std::move(submit));
+        }
+
+        // --adaptive: back to the front of the backlog, in their original order
+        void resend(std::vector<Task> &sentTasks, const std::vector<size_t> &positions)
+        {
+            for (auto it = positions.rbegin(); it != positions.rend(); ++it)
+            {
+                pending.push_front({std::move(sentTasks[*it]), true});
+            }
+        }
+
+        int64_t interArrivalUs()
+        {
+            double perClient = options.rate / options.clients;
+            double meanUs = 1e6 / perClient;
+            if (!options.poisson)
+            {
+                return std::max<int64_t>(1, static_cast<int64_t>(meanUs));
+            }
+            return std::max<int64_t>(1, static_cast<int64_t>(std::exponential_distribution<double>(1.0 / meanUs)(rng)));
+        }
+
+        Task makeTask(int64_t scheduledUs)
+        {
+            Task task;
+            task.taskId = nextTaskId.fetch_add(1);
+            task.priority = options.priority;
+            task.payload = "Load task " + std::to_string(task.taskId) +
+                           " (Duration: " + std::to_string(std::max(0LL, options.taskMs.sample(rng))) + "ms)";
+            if (options.failRate > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < options.failRate)
+            {
+                task.payload += " (Fail)";
+            }
+            long long size = options.payloadBytes.sample(rng);
+            if (size > static_cast<long long>(task.payload.size()))
+            {
+                task.payload.resize(static_cast<size_t>(size), 'x');
+            }
+            long long delay = options.delayMs.sample(rng);
+            if (delay > 0)
+            {
+                task.notBeforeMs = wallClockMs() + delay;
+            }
+            // Stamped with the schedule so server-side stages line up with ours
+            task.trace.submittedUs = scheduledUs;
+            task.enqueueTimeMs = scheduledUs / 1000;
+            return task;
+        }
+
+        void harvestSubmits()
+        {
+            while (!submits.empty() && ready(submits.front().reply))
+            {
+                OutstandingSubmit submit = std::move(submits.front());
+                submits.pop_front();
+                Message reply = submit.reply.get();
+                int64_t now = monotonicUs();
+
+                wire::Reader in(reply.payload);
+                uint32_t count = 0;
+                std::vector<size_t> rejected;
+                uint32_t retryAfter = 0;
+                if (reply.type != MessageType::SERVER_TASK_BATCH_RESULT || !in.getU32(count) || count != submit.tasks.size())
+                {
+                    std::string reason;
+                    bool isRejection = reply.type == MessageType::SERVER_TASK_REJECTED &&
+                                       decodeRejection(reply.payload, retryAfter, reason);
+                    (isRejection ? results.rejected : results.errors).fetch_add(submit.tasks.size(), std::memory_order_relaxed);
+                    if (options.adaptive && isRejection && retryAfter > 0)
+                    {
+                        rejected.resize(submit.tasks.size());
+                        for (size_t i = 0; i < rejected.size(); ++i)
+                            rejected[i] = i;
+                        rate.onRejected(retryAfter, now);
+                        resend(submit.sentTasks, rejected);
+                    }
+                    continue;
+                }
+                for (size_t i = 0; i < submit.tasks.size(); ++i)
+                {
+                    const Submitted &task = submit.tasks[i];
+                    uint8_t verdict = 0;
+                    in.getU8(verdict);
+                    results.ackLatencyUs.record(now - task.scheduledUs);
+                    if (verdict)
+                    {
+                        results.accepted.fetch_add(1, std::memory_order_relaxed);
+                        outstanding.emplace(task.taskId, task.scheduledUs);
+                    }
+                    else
+                    {
+                        results.rejected.fetch_add(1, std::memory_order_relaxed);
+                        rejected.push_back(i);
+                    }
+                }
+                if (!options.adaptive)
+                {
+                    continue;
+                }
+                in.getU32(retryAfter);
+                rate.onAccepted(submit.tasks.size() - rejected.size());
+                if (!rejected.empty())
+                {
+                    rate.onRejected(retryAfter, now);
+                    resend(submit.sentTasks, rejected);
+                }
+            }
+        }
+
+        void sendPoll()
+        {
+            // Ask about a bounded slice of the outstanding tasks per round trip
+            std::string request;
+            wire::putU32(request, 0);
+            uint32_t count = 0;
+            for (const auto &entry : outstanding)
+            {
+                if (count == kMaxPollIds)
+                    break;
+                wire::putI32(request, entry.first);
+                ++count;
+            }
+            std::string header;
+            wire::putU32(header, count);
+            request.replace(0, header.size(), header);
+            poll = client.request(MessageType::CLIENT_GET_RESULTS_BATCH, request);
+        }
+
+        void harvestPoll()
+        {
+            if (!poll.valid() || !ready(poll))
+            {
+                return;
+            }
+            Message reply = poll.get();
+            int64_t now = monotonicUs();
+            if (reply.type != MessageType::SERVER_TASK_RESULTS)
+            {
+                return; // connection lost; the next poll asks again
+            }
+
+            wire::Reader in(reply.payload);
+            uint32_t count = 0;
+            in.getU32(count);
+            std::string_view rest = in.rest();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                int taskId = 0;
+                std::optional<TaskRecord> record;
+                if (!TaskStore::decodeRecord(rest, taskId, record))
+                {
+                    break;
+                }
+                if (!record || (record->status != TaskStatus::COMPLETED && record->status != TaskStatus::FAILED))
+                {
+                    continue;
+                }
+                auto it = outstanding.find(taskId);
+                if (it == outstanding.end())
+                {
+                    continue;
+                }
+                results.endToEndLatencyUs.record(now - it->second);
+                (record->status == TaskStatus::COMPLETED ? results.completed : results.failed)
+                    .fetch_add(1, std::memory_order_relaxed);
+                noteLatest(results.lastResultUs, now);
+                outstanding.erase(it);
+            }
+        }
+
+        static constexpr uint32_t kMaxPollIds = 1024;
+
+        const Options &options;
+        Results &results;
+        std::atomic<int> &nextTaskId;
+        Network::Client client;
+        std::mt19937_64 rng;
+        AimdRate rate;                // --adaptive pacing
+        std::deque<Pending> pending;  // scheduled, not yet sent
+        std::deque<OutstandingSubmit> submits;
+        std::unordered_map<int, int64_t> outstanding; // accepted, result not seen yet
+        std::future<Message> poll;
+    };
+
+    bool parseArgs(int argc, char **argv, Options &options)
+    {
+        Distribution::parse("64", options.payloadBytes);
+        Distribution::parse("uniform:500:1500", options.taskMs);
+        Distribution::parse("0", options.delayMs);
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            size_t eq = arg.find('=');
+            std::string name = arg.substr(0, eq);
+            std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if (name == "--host")
+                options.host = value;
+            else if (name == "--port")
+                options.port = std::atoi(value.c_str());
+            else if (name == "--clients")
+                options.clients = std::max(1, std::atoi(value.c_str()));
+            else if (name == "--rate")
+                options.rate = std::atof(value.c_str());
+            else if (name == "--arrival" && (value == "poisson" || value == "constant"))
+                options.poisson = value == "poisson";
+            else if (name == "--duration")
+                options.durationSec = std::atof(value.c_str());
+            else if (name == "--drain")
+                options.drainSec = std::atof(value.c_str());
+            else if (name == "--payload" && Distribution::parse(value, options.payloadBytes))
+                continue;
+            else if (name == "--task-ms" && Distribution::parse(value, options.taskMs))
+                continue;
+            else if (name == "--delay-ms" && Distribution::parse(value, options.delayMs))
+                continue;
+            else if (name == "--priority")
+                options.priority = std::atoi(value.c_str());
+            else if (name == "--fail-rate")
+                options.failRate = std::min(1.0, std::max(0.0, std::atof(value.c_str())));
+            else if (name == "--poll-ms")
+                options.pollMs = std::max(1, std::atoi(value.c_str()));
+            else if (name == "--first-id")
+                options.firstId = std::atoi(value.c_str());
+            else if (name == "--adaptive")
+                options.adaptive = true;
+            else if (name == "--json")
+                options.jsonPath = value;
+            else
+            {
+                std::cerr << "Unknown or malformed option: " << arg << std::endl;
+                return false;
+            }
+        }
+        if (options.rate <= 0 || options.durationSec <= 0)
+        {
+            std::cerr << "--rate and --duration must be positive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string percentilesJson(const Histogram::Snapshot &snap)
+    {
+        char buf[256];
+        std::snprintf(buf, sizeof(buf),
+                      "{\"count\": %llu, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"p999\": %lld, \"max\": %lld}",
+                      static_cast<unsigned long long>(snap.total), static_cast<long long>(snap.percentile(50)),
+                      static_cast<long long>(snap.percentile(90)), static_cast<long long>(snap.percentile(99)),
+                      static_cast<long long>(snap.percentile(99.9)), static_cast<long long>(snap.max()));
+        return buf;
+    }
+
+    std::string escapeJson(const std::string &in)
+    {
+        std::string out;
+        for (char c : in)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        return 2;
+    }
+    if (!Network::initialize())
+    {
+        std::cerr << "Failed to initialize network. Exiting." << std::endl;
+        return 1;
+    }
+    // Per-task logging would perturb the measurement; only problems are logged
+    Logger::getInstance().setLogFile("load_generator.log");
+    Logger::getInstance().setMinLevel(LogLevel::WARN);
+
+    Results results;
+    std::atomic<int> nextTaskId{options.firstId};
+    std::vector<std::unique_ptr<LoadClient>> clients;
+    for (int i = 0; i < options.clients; ++i)
+    {
+        clients.push_back(std::make_unique<LoadClient>(options, results, nextTaskId, i));
+    }
+
+    int64_t startUs = monotonicUs();
+    std::vector<std::thread> threads;
+    for (auto &client : clients)
+    {
+        threads.emplace_back([&client, startUs]() { client->run(startUs); });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // Server-side view of the same run: where the end-to-end time went
+    StatsSnapshot server;
+    bool haveServerStats = false;
+    {
+        Network::Client statsClient(options.host, options.port);
+        Message reply;
+        haveServerStats = statsClient.connect() &&
+                          statsClient.call(MessageType::CLIENT_GET_STATS, "", reply, Config::NetworkTimeout) &&
+                          reply.type == MessageType::SERVER_STATS && StatsSnapshot::decode(reply.payload, server);
+        statsClient.disconnect();
+    }
+
+    uint64_t sent = results.sent.load();
+    uint64_t finished = results.completed.load() + results.failed.load();
+    int64_t lastResultUs = results.lastResultUs.load();
+    double elapsedSec = lastResultUs > startUs ? (lastResultUs - startUs) / 1e6 : options.durationSec;
+    double throughput = finished / elapsedSec;
+    uint64_t attempts = sent + results.resent.load();
+    double rejectionRate = attempts ? static_cast<double>(results.rejected.load()) / attempts : 0.0;
+    uint64_t unfinished = results.accepted.load() > finished ? results.accepted.load() - finished : 0;
+    Histogram::Snapshot ack = results.ackLatencyUs.snapshot();
+    Histogram::Snapshot endToEnd = results.endToEndLatencyUs.snapshot();
+    Histogram::Snapshot lag = results.sendLagUs.snapshot();
+
+    std::printf("offered   %.1f tasks/s (%s) over %.1fs from %d clients\n", options.rate,
+                options.poisson ? "poisson" : "constant", options.durationSec, options.clients);
+    std::printf("sent      %llu  accepted %llu  rejected %llu (%.2f%%)  errors %llu\n",
+                static_cast<unsigned long long>(sent), static_cast<unsigned long long>(results.accepted.load()),
+                static_cast<unsigned long long>(results.rejected.load()), rejectionRate * 100,
+                static_cast<unsigned long long>(results.errors.load()));
+    if (options.adaptive)
+    {
+        std::printf("adaptive  resent %llu  unsent %llu\n", static_cast<unsigned long long>(results.resent.load()),
+                    static_cast<unsigned long long>(results.unsent.load()));
+    }
+    std::printf("finished  %llu (completed %llu, failed %llu, unfinished %llu)  throughput %.1f tasks/s\n",
+                static_cast<unsigned long long>(finished), static_cast<unsigned long long>(results.completed.load()),
+                static_cast<unsigned long long>(results.failed.load()), static_cast<unsigned long long>(unfinished),
+                throughput);
+    std::printf("%-12s %10s %10s %10s %10s %10s\n", "latency(us)", "p50", "p90", "p99", "p999", "max");
+    for (auto row : {std::make_pair("ack", &ack), std::make_pair("end-to-end", &endToEnd), std::make_pair("send lag", &lag)})
+    {
+        std::printf("%-12s %10lld %10lld %10lld %10lld %10lld\n", row.first,
+                    static_cast<long long>(row.second->percentile(50)), static_cast<long long>(row.second->percentile(90)),
+                    static_cast<long long>(row.second->percentile(99)), static_cast<long long>(row.second->percentile(99.9)),
+                    static_cast<long long>(row.second->max()));
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        std::string json = "{\n  \"config\": {";
+        json += "\"host\": \"" + escapeJson(options.host) + "\", \"port\": " + std::to_string(options.port);
+        json += ", \"clients\": " + std::to_string(options.clients);
+        json += ", \"rate\": " + std::to_string(options.rate);
+        json += ", \"arrival\": \"" + std::string(options.poisson ? "poisson" : "constant") + "\"";
+        json += ", \"duration_s\": " + std::to_string(options.durationSec);
+        json += ", \"payload_bytes\": \"" + options.payloadBytes.describe() + "\"";
+        json += ", \"task_ms\": \"" + options.taskMs.describe() + "\"";
+        json += ", \"delay_ms\": \"" + options.delayMs.describe() + "\"";
+        json += ", \"priority\": " + std::to_string(options.priority);
+        json += ", \"fail_rate\": " + std::to_string(options.failRate);
+        json += ", \"adaptive\": " + std::string(options.adaptive ? "true" : "false") + "},\n";
+        json += "  \"results\": {";
+        json += "\"sent\": " + std::to_string(sent);
+        json += ", \"accepted\": " + std::to_string(results.accepted.load());
+        json += ", \"rejected\": " + std::to_string(results.rejected.load());
+        json += ", \"errors\": " + std::to_string(results.errors.load());
+        json += ", \"resent\": " + std::to_string(results.resent.load());
+        json += ", \"unsent\": " + std::to_string(results.unsent.load());
+        json += ", \"completed\": " + std::to_string(results.completed.load());
+        json += ", \"failed\": " + std::to_string(results.failed.load());
+        json += ", \"unfinished\": " + std::to_string(unfinished);
+        json += ", \"rejection_rate\": " + std::to_string(rejectionRate);
+        json += ", \"throughput_tps\": " + std::to_string(throughput) + "},\n";
+        json += "  \"latency_us\": {\"ack\": " + percentilesJson(ack) + ",\n";
+        json += "                 \"end_to_end\": " + percentilesJson(endToEnd) + ",\n";
+        json += "                 \"send_lag\": " + percentilesJson(lag) + "}";
+        if (haveServerStats)
+        {
+            json += ",\n  \"server_stages_us\": {";
+            for (size_t i = 0; i < server.stages.size(); ++i)
+            {
+                const StatsSnapshot::StageStats &stage = server.stages[i];
+                json += std::string(i ? ", " : "") + "\"" + stageName(static_cast<Stage>(i)) + "\": {\"count\": " +
+                        std::to_string(stage.count) + ", \"p50\": " + std::to_string(stage.p50) +
+                        ", \"p99\": " + std::to_string(stage.p99) + "}";
+            }
+            json += "}";
+        }
+        json += "\n}\n";
+
+        if (options.jsonPath == "-")
+        {
+            std::fwrite(json.data(), 1, json.size(), stdout);
+        }
+        else if (FILE *out = std::fopen(options.jsonPath.c_str(), "w"))
+        {
+            std::fwrite(json.data(), 1, json.size(), out);
+            std::fclose(out);
+        }
+        else
+        {
+            std::cerr << "Cannot write " << options.jsonPath << std::endl;
+        }
+    }
+
+    Network::cleanup();
+    return 0;
+}
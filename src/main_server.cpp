@@ -1,213 +1,1169 @@
 #include "Network.h"
-#include "TaskQueue.h"
+#include "TcpServer.h"
+#include "BlobStore.h"
+#include "ShardedTaskQueue.h"
 #include "Logger.h"
 #include "Config.h"
 #include "Task.h"
+#include "TaskPool.h"
+#include "Wire.h"
+#include "PollRegistry.h"
+#include "WorkerRegistry.h"
+#include "WriteAheadLog.h"
+#include "LeaseTable.h"
+#include "DelayedTaskQueue.h"
+#include "DeadLetterQueue.h"
+#include "Admission.h"
+#include "Metrics.h"
+#include "MetricsHttpServer.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <thread>
 #include <atomic>
 #include <vector>
 #include <iostream>
 #include <chrono>
 #include <mutex>
-
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
-#endif
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace dtq;
 
-TaskQueue globalTaskQueue;
-std::mutex queueMutex;
+// Built in main() (--queue=ring|mutex|priority, --shards=N); thread-safe on its own.
+// Each connection has a home shard, see homeShard().
+std::unique_ptr<ShardedTaskQueue> globalTaskQueue;
+
+// Set by --wal=path: enqueue/assign/complete events are logged and replayed on
+// startup, and acknowledgments wait until their record is durable
+std::unique_ptr<WriteAheadLog> wal;
+
+// Every assigned task is leased until its result arrives; built in main()
+// (--lease-ms=N). Tasks whose lease runs out are redelivered by leaseReaper().
+std::unique_ptr<LeaseTable> leases;
+static const std::chrono::milliseconds kLeaseCheckInterval(100);
+
+// Tasks submitted with a future not-before time; delayedPromoter() moves them
+// into the ready queue in bulk as they come due
+std::unique_ptr<DelayedTaskQueue> delayedTasks;
+static const std::chrono::milliseconds kPromoteInterval(10);
+
+// Tasks already accepted that found the ready queue full or shedding when they
+// went back to it; delayedPromoter() moves them in as room frees up. Unbounded,
+// since dropping them would lose work the queue acknowledged.
+static std::mutex overflowMutex;
+static std::vector<Task> overflowTasks;
+
+// Tasks that failed or lost their lease Config::TaskRetryLimit times; listed
+// with CLIENT_GET_DEAD_LETTERS and sent back with CLIENT_REQUEUE_DEAD_LETTERS
+static DeadLetterQueue deadLetters;
+
+// Set by --blob-dir=path: payloads and results of at least blobThreshold bytes
+// (--blob-threshold=N) are kept in memory-mapped files there instead of on the
+// heap, and sent to sockets straight from those files
+static std::shared_ptr<BlobStore> blobs;
+static size_t blobThreshold = Config::BlobThresholdBytes;
+
+// Puts bytes in the blob store if they are large enough, emptying bytes; an
+// empty ref, with bytes left as they were, if there is no store or no room
+static BlobRef storeBlob(std::string_view &bytes)
+{
+    if (!blobs || bytes.size() < blobThreshold)
+    {
+        return BlobRef();
+    }
+    BlobRef blob = blobs->put(bytes);
+    if (!blob.empty())
+    {
+        bytes = std::string_view();
+    }
+    return blob;
+}
 
-// Counters
-std::atomic<long long> tasksCompleted{0};
-std::atomic<long long> totalLatencyMs{0};
 std::atomic<bool> stopServer{false};
-std::atomic<long long> tasksReceived{0};
-std::mutex metricsMutex;
 
-// For throughput
-static auto serverStartTime = std::chrono::steady_clock::now();
+// Counters, striped per thread and summed when stats are read
+static Counter tasksAccepted;
+static Counter tasksRejected;
+static Counter tasksCompleted;
+static Counter tasksFailed;
+static Counter tasksRetried;
+static Counter tasksShed; // turned away up front; the queue counts the ones it sheds itself
+
+// Per-stage latency of completed tasks and the completion rate, fed from the
+// TaskTrace stamps each task collects on its way through
+static LifecycleMetrics lifecycle;
 
-// Current time in ms
-static long long nowMs()
+// Results submitted over one worker connection. Only that connection's
+// handler updates it; the registry is locked on connect, close and stats reads.
+struct WorkerActivity
 {
-    auto tp = std::chrono::steady_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
-    return (long long)ms;
+    std::atomic<uint64_t> completed{0};
+    ThroughputWindow window;
+};
+
+static std::mutex workersMutex;
+static std::unordered_map<uint64_t, std::shared_ptr<WorkerActivity>> workers;
+
+static void requeue(size_t home, Task &&task);
+
+static size_t homeShard(const SessionPtr &session)
+{
+    return globalTaskQueue->shardFor(session->id());
 }
 
-// For throughput - using a sliding window
-static auto lastReportTime = std::chrono::steady_clock::now();
-static std::atomic<long long> tasksSinceLastReport{0};
+// Holds a task whose not-before time is still ahead (task.notBeforeMs >
+// nowWallMs). Returns false, leaving the task untouched, if too many are held.
+static bool holdUntilDue(Task &&task, int64_t nowWallMs)
+{
+    int taskId = task.taskId;
+    // Due on the monotonic clock, so wall-clock steps do not move it
+    int64_t dueMs = monotonicUs() / 1000 + (task.notBeforeMs - nowWallMs);
+    std::optional<TaskRecord> replaced = globalTaskQueue->store().markPending(taskId);
+    if (!delayedTasks->schedule(std::move(task), dueMs))
+    {
+        globalTaskQueue->store().restore(taskId, std::move(replaced));
+        return false;
+    }
+    return true;
+}
 
-// Handle exactly one message from the client/worker, then close
-static void handleClientConnection(SOCKET clientSock)
+// Keeps a task the ready queue turned away for delayedPromoter() to retry,
+// PENDING in the store meanwhile (a rejected requeue left it IN_PROGRESS)
+static void holdForRoom(Task &&task)
 {
-    Network::Connection conn(clientSock);
-    
-    // Receive the message
-    MessageType msgType;
-    std::string payload;
-    
-    if (!conn.receiveMessage(msgType, payload))
-    {
-        Logger::getInstance().log(LogLevel::ERR, "Failed to receive message: " + conn.getLastError());
-        return;
+    globalTaskQueue->store().markPending(task.taskId);
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflowTasks.push_back(std::move(task));
+}
+
+// Called with a leased task that failed or whose lease ran out, already
+// released. Retries it after an exponential backoff with jitter, held in
+// delayedTasks so it does not hot-loop through the ready queue; past
+// Config::TaskRetryLimit it is failed and parked in deadLetters. Returns the
+// WAL lsn to wait on, 0 without a WAL.
+static uint64_t retryOrDeadLetter(Task &&task, const std::string &reason)
+{
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    std::string id = std::to_string(task.taskId);
+    if (task.retryCount < Config::TaskRetryLimit)
+    {
+        ++task.retryCount;
+        int64_t nowWallMs = wallClockMs();
+        int64_t backoffMs = retryBackoffMs(task.retryCount, std::uniform_real_distribution<double>(0.0, 1.0)(rng));
+        task.notBeforeMs = nowWallMs + backoffMs;
+        task.status = TaskStatus::PENDING;
+        task.result.clear();
+        // An Enqueue record replaces the task on replay, keeping the retry count and not-before time
+        uint64_t lsn = wal ? wal->logEnqueue(task) : 0;
+        int retry = task.retryCount;
+        if (holdUntilDue(std::move(task), nowWallMs))
+        {
+            tasksRetried.add();
+            Logger::getInstance().log(LogLevel::WARN, "Task " + id + " " + reason + ", retry " + std::to_string(retry) + "/" +
+                                                          std::to_string(Config::TaskRetryLimit) + " in " +
+                                                          std::to_string(backoffMs) + "ms");
+            return lsn;
+        }
+        Logger::getInstance().log(LogLevel::ERR, "No room to hold task " + id + " for a retry");
+    }
+
+    task.status = TaskStatus::FAILED;
+    task.result = reason + " after " + std::to_string(task.retryCount + 1) + " attempts";
+    // Dead letters can sit for a long time; one must not pin a whole blob segment
+    if (!task.payloadBlob.empty())
+    {
+        task.payload.assign(task.payloadBlob.view());
+        task.payloadBlob = BlobRef();
+    }
+    Logger::getInstance().log(LogLevel::ERR, "Task " + id + " dead-lettered: " + task.result);
+    globalTaskQueue->updateTaskResult(task.taskId, task.result, TaskStatus::FAILED);
+    uint64_t lsn = wal ? wal->logComplete(task.taskId, TaskStatus::FAILED, task.result) : 0;
+    tasksFailed.add();
+    if (!deadLetters.add(std::move(task)))
+    {
+        Logger::getInstance().log(LogLevel::WARN, "Dead-letter queue full, dropped its oldest task");
     }
-    
-    // Process the message based on its type
-    if (msgType == MessageType::CLIENT_ADD_TASK)
+    return lsn;
+}
+
+// Takes from the home shard first, stealing from siblings if it is empty
+static std::vector<Task> takeTasks(size_t home, size_t maxTasks)
+{
+    return globalTaskQueue->dequeueBulk(home, maxTasks);
+}
+
+// Queue latency target set by --queue-target-ms; 0 when off
+static std::chrono::milliseconds queueTarget(0);
+
+// Retry-after hint for tasks turned away because the ready queue is full or
+// over its latency target, from its depth and how fast workers are draining
+// it: the time to get back to half full, or to a backlog that drains within
+// the latency target.
+static uint32_t overloadRetryAfterMs()
+{
+    double drainPerSec = lifecycle.completedPerSecond();
+    size_t targetDepth = static_cast<size_t>(Config::MaxQueueSize) / 2;
+    if (globalTaskQueue->shedding())
+    {
+        targetDepth = static_cast<size_t>(drainPerSec * static_cast<double>(queueTarget.count()) / 1000.0);
+    }
+    return retryAfterMs(globalTaskQueue->size(), targetDepth, drainPerSec);
+}
+
+// Sends the reply once the WAL record lsn is on disk, or right away without a
+// WAL. Returns false only if an immediate send fails.
+static bool replyWhenDurable(const SessionPtr &session, uint64_t lsn, MessageType type, uint32_t requestId,
+                             std::string payload)
+{
+    if (!wal)
     {
-        // Deserialize the task
-        Task task = Task::deserialize(payload);
-        
-        // Add the task to the queue
+        return session->send(type, requestId, payload);
+    }
+    wal->whenDurable(lsn, [session, type, requestId, payload = std::move(payload)](bool ok) {
+        if (ok)
         {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            globalTaskQueue.enqueue(task);
-            Logger::getInstance().log(LogLevel::INFO, "Task added to queue: ID=" + std::to_string(task.taskId));
+            session->send(type, requestId, payload);
+            return;
         }
-        
-        // Send acknowledgment to the client
-        if (!conn.sendMessage(MessageType::SERVER_TASK_ACCEPTED, ""))
+        Logger::getInstance().log(LogLevel::ERR, wal->getLastError());
+        session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Write-ahead log failure"));
+    });
+    return true;
+}
+
+// Parked WORKER_POLL_TASKS requests, woken whenever tasks are enqueued
+PollRegistry pollRegistry(takeTasks);
+
+// Workers that registered for pushed tasks, with the credit each has left
+WorkerRegistry workerRegistry(takeTasks);
+
+// Offers newly ready tasks to workers with credit first, then to parked polls
+static void tasksAvailable()
+{
+    workerRegistry.onTasksAvailable();
+    pollRegistry.onTasksAvailable();
+}
+
+// Assignments a worker connection has been sent but not yet acknowledged.
+// Shared with parked polls, which may deliver from another connection's thread.
+struct AssignmentState
+{
+    std::mutex mutex;
+    bool closed = false;
+    std::unordered_map<uint32_t, std::vector<int>> awaitingAck; // task ids; the lease table holds the tasks
+    // Parked polls by requestId. A poll answered before park() returned
+    // leaves a 0 here, which tells the parking thread not to record it.
+    std::unordered_map<uint32_t, PollRegistry::PollId> parkedPolls;
+    std::unordered_set<int> leased; // assigned here and not yet settled by this worker
+    uint32_t nextPushId = 0;
+};
+
+// Sends tasks to a worker and holds them until it acknowledges the requestId.
+// Tasks that cannot be delivered go back to the queue. The tasks are moved
+// into their leases, which own them from then on.
+static void assignTasks(const SessionPtr &session, AssignmentState &state, MessageType replyType,
+                        uint32_t requestId, std::vector<Task> &&tasks)
+{
+    int64_t assignedUs = monotonicUs();
+    for (Task &task : tasks)
+    {
+        task.trace.assignedUs = assignedUs;
+    }
+    // Blob payloads are spliced in, to be sent from their files
+    SplicedPayload reply;
+    if (replyType != MessageType::SERVER_ASSIGN_TASK)
+    {
+        Task::serializeBatch(tasks, reply);
+    }
+    else if (!tasks.empty())
+    {
+        tasks.front().serializeTo(reply);
+    }
+    bool hasTasks = !tasks.empty();
+
+    // Record before sending: the acknowledgment may be handled on another
+    // thread as soon as the reply is on the wire.
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.closed)
         {
-            Logger::getInstance().log(LogLevel::ERR, "Failed to send acknowledgment: " + conn.getLastError());
+            for (Task &task : tasks)
+            {
+                requeue(homeShard(session), std::move(task));
+            }
             return;
         }
-        
-        // Update metrics
+        if (hasTasks)
+        {
+            // Logged under state.mutex so a requeue from onClose follows it in the log
+            if (wal)
+            {
+                for (const Task &task : tasks)
+                {
+                    wal->logAssign(task.taskId);
+                }
+            }
+            int64_t nowMs = assignedUs / 1000;
+            std::vector<int> &held = state.awaitingAck[requestId];
+            for (Task &task : tasks)
+            {
+                int taskId = task.taskId;
+                leases->grant(std::move(task), nowMs, session->id());
+                state.leased.insert(taskId);
+                held.push_back(taskId);
+            }
+        }
+    }
+
+    // send() may tear the connection down (and run onClose) on this thread,
+    // so it must not be called with state.mutex held.
+    if (session->send(replyType, requestId, std::move(reply)))
+    {
+        return;
+    }
+
+    Logger::getInstance().log(LogLevel::ERR, "Failed to send tasks to worker on session " + std::to_string(session->id()));
+    std::vector<int> undelivered;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto it = state.awaitingAck.find(requestId);
+        if (it != state.awaitingAck.end())
         {
-            std::lock_guard<std::mutex> lock(metricsMutex);
-            tasksReceived++;
+            undelivered = std::move(it->second);
+            state.awaitingAck.erase(it);
         }
     }
-    else if (msgType == MessageType::WORKER_REQUEST_TASK)
+
+    // Put the tasks back in the queue (unless onClose or the reaper already did)
+    for (int taskId : undelivered)
     {
-        // Try to get a task from the queue
-        Task task;
-        bool hasTask = false;
-        
+        std::optional<Task> task = leases->revoke(taskId, session->id());
+        if (task)
         {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            auto optTask = globalTaskQueue.dequeue();
-            if (optTask.has_value())
+            requeue(homeShard(session), std::move(*task));
+        }
+    }
+}
+
+// Snapshot for CLIENT_GET_STATS and the metrics endpoint
+static StatsSnapshot collectStats()
+{
+    StatsSnapshot stats;
+    for (size_t depth : globalTaskQueue->shardDepths())
+    {
+        stats.shardDepths.push_back(depth);
+        stats.queueDepth += depth;
+    }
+    stats.accepted = tasksAccepted.value();
+    stats.rejected = tasksRejected.value();
+    stats.completed = tasksCompleted.value();
+    stats.failed = tasksFailed.value();
+    stats.inFlight = leases->size();
+    stats.delayed = delayedTasks->size();
+    stats.retried = tasksRetried.value();
+    stats.deadLetters = deadLetters.size();
+    stats.shed = tasksShed.value() + globalTaskQueue->shed();
+    stats.queueBytes = globalTaskQueue->bytesQueued();
+    stats.blobBytes = blobs ? blobs->bytesStored() : 0;
+    stats.tasksPerSec = lifecycle.completedPerSecond();
+    for (size_t i = 0; i < stats.stages.size(); ++i)
+    {
+        stats.setStage(static_cast<Stage>(i), lifecycle.snapshot(static_cast<Stage>(i)));
+    }
+
+    std::lock_guard<std::mutex> lock(workersMutex);
+    for (const auto &entry : workers)
+    {
+        StatsSnapshot::WorkerStats worker;
+        worker.sessionId = entry.first;
+        worker.completed = entry.second->completed.load(std::memory_order_relaxed);
+        worker.tasksPerSec = entry.second->window.perSecond();
+        stats.workers.push_back(worker);
+    }
+    return stats;
+}
+
+// Per-connection protocol state. Connections are persistent and multiplexed:
+// every request carries a requestId that the reply echoes, and a worker
+// connection may hold several assignments (single tasks or batches) awaiting
+// WORKER_TASK_RECEIVED at once.
+class ServerSession : public SessionHandler
+{
+public:
+    void onMessage(const SessionPtr &session, MessageType msgType, uint32_t requestId, std::string &payload) override
+    {
+        // Process the message based on its type
+        if (msgType == MessageType::CLIENT_ADD_TASK)
+        {
+            // Decode in place; the task is only copied out once it is admitted.
+            // Malformed input reads as a default task, as Task::deserialize does
+            TaskView view;
+            if (!Task::decode(payload, view))
             {
-                task = optTask.value();
-                hasTask = true;
+                view = TaskView();
+            }
+            int64_t nowWallMs = wallClockMs();
+            bool delayed = view.notBeforeMs > nowWallMs;
+
+            // Admission: a full queue, or one over its latency target, turns the
+            // task away before it costs a WAL write, telling the client when
+            // there should be room again
+            int taskId = view.taskId;
+            bool shedding = !delayed && globalTaskQueue->shedding();
+            if (shedding || (!delayed && globalTaskQueue->size() >= static_cast<size_t>(Config::MaxQueueSize)))
+            {
+                tasksRejected.add();
+                if (shedding)
+                {
+                    tasksShed.add();
+                }
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId,
+                              encodeRejection(overloadRetryAfterMs(), shedding ? "Queue over latency target" : "Queue full"));
+                return;
+            }
+            BlobRef payloadBlob = storeBlob(view.payload);
+            Task task = TaskPool::getInstance().acquire(view);
+            task.payloadBlob = std::move(payloadBlob);
+            if (!delayed)
+            {
+                task.trace.enqueuedUs = monotonicUs();
+            }
+
+            // Add the task to the queue (or hold it until its not-before time),
+            // logging it first so the log never holds an assignment before its enqueue
+            uint64_t lsn = wal ? wal->logEnqueue(task) : 0;
+            bool accepted = delayed ? holdUntilDue(std::move(task), nowWallMs)
+                                    : globalTaskQueue->enqueue(homeShard(session), std::move(task));
+            (accepted ? tasksAccepted : tasksRejected).add();
+            if (!accepted)
+            {
+                // Lost a race for the last slots, or too many held tasks
+                if (wal)
+                {
+                    lsn = wal->logDrop(taskId);
+                }
+                uint32_t retryAfter = delayed ? static_cast<uint32_t>(Config::RetryAfterMax.count()) : overloadRetryAfterMs();
+                replyWhenDurable(session, lsn, MessageType::SERVER_TASK_REJECTED, requestId,
+                                 encodeRejection(retryAfter, delayed ? "Too many delayed tasks" : "Queue full"));
+                return;
+            }
+            if (delayed)
+            {
+                DTQ_LOG(INFO, "Task held until its not-before time: ID=" + std::to_string(taskId));
+            }
+            else
+            {
+                DTQ_LOG(INFO, "Task added to queue: ID=" + std::to_string(taskId));
+                tasksAvailable();
+            }
+
+            // Send acknowledgment to the client
+            if (!replyWhenDurable(session, lsn, MessageType::SERVER_TASK_ACCEPTED, requestId, ""))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Failed to send acknowledgment to session " + std::to_string(session->id()));
             }
         }
-        
-        if (hasTask)
+        else if (msgType == MessageType::CLIENT_ADD_TASK_BATCH)
         {
-            // Serialize the task and send it to the worker
-            std::string serializedTask = task.serialize();
-            if (!conn.sendMessage(MessageType::SERVER_ASSIGN_TASK, serializedTask))
+            std::vector<TaskView> views;
+            if (!Task::decodeBatch(payload, views))
             {
-                Logger::getInstance().log(LogLevel::ERR, "Failed to send task to worker: " + conn.getLastError());
-                
-                // Put the task back in the queue
-                std::lock_guard<std::mutex> lock(queueMutex);
-                globalTaskQueue.enqueue(task);
+                Logger::getInstance().log(LogLevel::ERR, "Malformed task batch from session " + std::to_string(session->id()));
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed task batch"));
                 return;
             }
-            
-            // Wait for acknowledgment from worker
-            MessageType ackType;
-            std::string ackPayload;
-            
-            if (!conn.receiveMessage(ackType, ackPayload))
-            {
-                Logger::getInstance().log(LogLevel::ERR, "Failed to receive worker acknowledgment: " + conn.getLastError());
-                
-                // Put the task back in the queue
-                std::lock_guard<std::mutex> lock(queueMutex);
-                globalTaskQueue.enqueue(task);
+
+            // Tasks with a future not-before time are held aside; the rest
+            // go to the ready queue together. Ready tasks beyond the queue's
+            // free room (none while shedding) are rejected up front, without a WAL write.
+            size_t batchSize = views.size();
+            bool shedding = globalTaskQueue->shedding();
+            size_t room = shedding ? 0
+                                   : static_cast<size_t>(Config::MaxQueueSize) -
+                                         std::min(globalTaskQueue->size(), static_cast<size_t>(Config::MaxQueueSize));
+            size_t turnedAway = 0;
+            std::vector<uint8_t> verdicts(batchSize, 0);
+            std::vector<Task> tasks;
+            std::vector<size_t> readyPositions;
+            tasks.reserve(batchSize);
+            int64_t enqueuedUs = monotonicUs();
+            int64_t nowWallMs = wallClockMs();
+            uint64_t lsn = 0;
+            for (size_t i = 0; i < batchSize; ++i)
+            {
+                bool ready = views[i].notBeforeMs <= nowWallMs;
+                if (ready && tasks.size() >= room)
+                {
+                    ++turnedAway;
+                    continue;
+                }
+                BlobRef payloadBlob = storeBlob(views[i].payload);
+                Task task = TaskPool::getInstance().acquire(views[i]);
+                task.payloadBlob = std::move(payloadBlob);
+                if (wal)
+                {
+                    lsn = wal->logEnqueue(task);
+                }
+                if (!ready)
+                {
+                    int taskId = task.taskId;
+                    verdicts[i] = holdUntilDue(std::move(task), nowWallMs) ? 1 : 0;
+                    if (!verdicts[i] && wal)
+                    {
+                        lsn = wal->logDrop(taskId);
+                    }
+                    continue;
+                }
+                task.trace.enqueuedUs = enqueuedUs;
+                tasks.push_back(std::move(task));
+                readyPositions.push_back(i);
+            }
+
+            // One queue operation for the ready tasks
+            size_t readyCount = tasks.size();
+            size_t enqueued = readyCount ? globalTaskQueue->enqueueBulk(homeShard(session), std::move(tasks)) : 0;
+            for (size_t j = 0; j < readyCount; ++j)
+            {
+                if (j < enqueued)
+                {
+                    verdicts[readyPositions[j]] = 1;
+                }
+                else
+                {
+                    // Rejected tasks were not moved from
+                    if (wal)
+                    {
+                        lsn = wal->logDrop(tasks[j].taskId);
+                    }
+                    TaskPool::getInstance().release(std::move(tasks[j]));
+                }
+            }
+            size_t accepted = static_cast<size_t>(std::count(verdicts.begin(), verdicts.end(), 1));
+            tasksAccepted.add(accepted);
+            tasksRejected.add(batchSize - accepted);
+            if (shedding)
+            {
+                tasksShed.add(turnedAway);
+            }
+            if (enqueued > 0)
+            {
+                tasksAvailable();
+            }
+
+            // Per-task verdict, in submission order, then when to retry the rejected ones
+            std::string reply;
+            wire::putU32(reply, static_cast<uint32_t>(batchSize));
+            for (uint8_t verdict : verdicts)
+            {
+                wire::putU8(reply, verdict);
+            }
+            wire::putU32(reply, accepted == batchSize ? 0 : overloadRetryAfterMs());
+            if (!replyWhenDurable(session, lsn, MessageType::SERVER_TASK_BATCH_RESULT, requestId, std::move(reply)))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Failed to send batch result to session " + std::to_string(session->id()));
+            }
+        }
+        else if (msgType == MessageType::WORKER_REQUEST_TASK)
+        {
+            // Try to get a task from the queue; an empty reply means none available
+            assignTasks(session, *state, MessageType::SERVER_ASSIGN_TASK, requestId, takeTasks(homeShard(session), 1));
+        }
+        else if (msgType == MessageType::WORKER_REQUEST_TASKS)
+        {
+            wire::Reader in(payload);
+            uint32_t maxTasks = 1;
+            in.getU32(maxTasks);
+
+            assignTasks(session, *state, MessageType::SERVER_ASSIGN_TASKS, requestId, takeTasks(homeShard(session), maxTasks));
+        }
+        else if (msgType == MessageType::WORKER_POLL_TASKS)
+        {
+            wire::Reader in(payload);
+            uint32_t maxTasks = 1;
+            uint32_t timeoutMs = 0;
+            in.getU32(maxTasks);
+            in.getU32(timeoutMs);
+            timeoutMs = std::min<uint32_t>(timeoutMs, kMaxPollTimeoutMs);
+
+            // The poll is parked without a thread and answered by whichever
+            // thread enqueues the next task, or by the registry on timeout.
+            std::shared_ptr<AssignmentState> held = state;
+            SessionPtr target = session;
+            PollRegistry::PollId id = pollRegistry.park(
+                homeShard(session), std::max<uint32_t>(maxTasks, 1), std::chrono::milliseconds(timeoutMs),
+                [held, target, requestId](std::vector<Task> &&tasks) {
+                    {
+                        std::lock_guard<std::mutex> lock(held->mutex);
+                        if (held->parkedPolls.erase(requestId) == 0)
+                        {
+                            held->parkedPolls.emplace(requestId, 0);
+                        }
+                    }
+                    assignTasks(target, *held, MessageType::SERVER_ASSIGN_TASKS, requestId, std::move(tasks));
+                });
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto answered = state->parkedPolls.find(requestId);
+                if (answered != state->parkedPolls.end())
+                {
+                    state->parkedPolls.erase(answered);
+                }
+                else if (id != 0)
+                {
+                    state->parkedPolls.emplace(requestId, id);
+                }
+            }
+        }
+        else if (msgType == MessageType::WORKER_REGISTER)
+        {
+            wire::Reader in(payload);
+            uint32_t credits = 0;
+            if (!in.getU32(credits))
+            {
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed registration"));
                 return;
             }
-            
-            if (ackType != MessageType::WORKER_TASK_RECEIVED)
+            std::string reply;
+            wire::putU32(reply, static_cast<uint32_t>(Config::HeartbeatInterval.count()));
+            session->send(MessageType::SERVER_WORKER_REGISTERED, requestId, reply);
+
+            // From here on tasks are pushed as the worker's credit allows
+            std::shared_ptr<AssignmentState> held = state;
+            SessionPtr target = session;
+            workerRegistry.add(
+                session->id(), homeShard(session), credits, monotonicUs() / 1000,
+                [held, target](std::vector<Task> &&tasks) {
+                    uint32_t pushId;
+                    {
+                        std::lock_guard<std::mutex> lock(held->mutex);
+                        pushId = kServerRequestBit | (++held->nextPushId & ~kServerRequestBit);
+                    }
+                    assignTasks(target, *held, MessageType::SERVER_PUSH_TASKS, pushId, std::move(tasks));
+                },
+                [target]() {
+                    Logger::getInstance().log(LogLevel::WARN, "Worker on session " + std::to_string(target->id()) +
+                                                                  " missed its heartbeats; disconnecting it");
+                    target->close();
+                });
+            Logger::getInstance().log(LogLevel::INFO, "Worker registered on session " + std::to_string(session->id()) +
+                                                          " with " + std::to_string(credits) + " credits");
+        }
+        else if (msgType == MessageType::WORKER_HEARTBEAT)
+        {
+            wire::Reader in(payload);
+            uint32_t credits = 0;
+            in.getU32(credits);
+            if (!workerRegistry.heartbeat(session->id(), credits, monotonicUs() / 1000))
+            {
+                // Evicted, or never registered; it reconnects and registers again
+                Logger::getInstance().log(LogLevel::WARN, "Heartbeat from unregistered session " + std::to_string(session->id()));
+                session->close();
+            }
+        }
+        else if (msgType == MessageType::WORKER_TASK_RECEIVED)
+        {
+            std::vector<int> acked;
             {
-                Logger::getInstance().log(LogLevel::ERR, "Unexpected acknowledgment type from worker");
-                
-                // Put the task back in the queue
-                std::lock_guard<std::mutex> lock(queueMutex);
-                globalTaskQueue.enqueue(task);
+                std::lock_guard<std::mutex> lock(state->mutex);
+                auto it = state->awaitingAck.find(requestId);
+                if (it != state->awaitingAck.end())
+                {
+                    acked = std::move(it->second);
+                    state->awaitingAck.erase(it);
+                }
+            }
+            if (acked.empty())
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Unexpected acknowledgment from worker for request " + std::to_string(requestId));
                 return;
             }
-            
-            Logger::getInstance().log(LogLevel::INFO, "Task assigned to worker: ID=" + std::to_string(task.taskId));
+            for (int taskId : acked)
+            {
+                DTQ_LOG(INFO, "Task assigned to worker: ID=" + std::to_string(taskId));
+            }
         }
-        else
+        else if (msgType == MessageType::WORKER_SUBMIT_RESULT)
         {
-            // No tasks available, send empty response
-            if (!conn.sendMessage(MessageType::SERVER_ASSIGN_TASK, ""))
+            // Decode the task result in place; only the id and result are needed
+            TaskView completedTask;
+            if (!Task::decode(payload, completedTask))
             {
-                Logger::getInstance().log(LogLevel::ERR, "Failed to send empty task response: " + conn.getLastError());
+                Logger::getInstance().log(LogLevel::ERR, "Malformed result from session " + std::to_string(session->id()));
                 return;
             }
+
+            // Process the completed task. A result from a worker that no
+            // longer holds the lease is still recorded, but leaves the lease
+            // alone: the task may have been redelivered to another worker.
+            DTQ_LOG(INFO, "Task completed: ID=" + std::to_string(completedTask.taskId) +
+                              ", Result=" + std::string(completedTask.result));
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->leased.erase(completedTask.taskId);
+            }
+            std::optional<Task> leased = leases->revoke(completedTask.taskId, session->id());
+            if (leased)
+            {
+                TaskPool::getInstance().release(std::move(*leased));
+            }
+            else
+            {
+                Logger::getInstance().log(LogLevel::WARN, "Result for task " + std::to_string(completedTask.taskId) +
+                                                              " arrived after session " + std::to_string(session->id()) +
+                                                              " lost its lease");
+            }
+            TaskStatus outcome = completedTask.status == TaskStatus::FAILED ? TaskStatus::FAILED : TaskStatus::COMPLETED;
+            std::string_view result = completedTask.result;
+            BlobRef resultBlob = storeBlob(result);
+            globalTaskQueue->updateTaskResult(completedTask.taskId, std::string(result), outcome, std::move(resultBlob));
+            uint64_t lsn = wal ? wal->logComplete(completedTask.taskId, outcome, completedTask.result) : 0;
+
+            // Update metrics
+            (outcome == TaskStatus::FAILED ? tasksFailed : tasksCompleted).add();
+            int64_t confirmedUs = monotonicUs();
+            lifecycle.recordCompletion(completedTask.trace, confirmedUs);
+            if (!activity)
+            {
+                activity = std::make_shared<WorkerActivity>();
+                std::lock_guard<std::mutex> lock(workersMutex);
+                workers[session->id()] = activity;
+            }
+            activity->completed.fetch_add(1, std::memory_order_relaxed);
+            activity->window.add(1, confirmedUs);
+
+            // Send acknowledgment to the worker
+            if (!replyWhenDurable(session, lsn, MessageType::SERVER_RESULT_CONFIRMED, requestId, ""))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Failed to send result confirmation on session " + std::to_string(session->id()));
+            }
+        }
+        else if (msgType == MessageType::WORKER_REPORT_FAILURE)
+        {
+            TaskView failedTask;
+            if (!Task::decode(payload, failedTask))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Malformed failure report from session " + std::to_string(session->id()));
+                return;
+            }
+
+            // Only the lease holder's report retries the task. One from a worker
+            // whose lease expired is dropped: the reaper already retried it,
+            // and another worker may hold it now.
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->leased.erase(failedTask.taskId);
+            }
+            uint64_t lsn = 0;
+            std::optional<Task> task = leases->revoke(failedTask.taskId, session->id());
+            if (task)
+            {
+                // The reported copy carries the attempt's error in its result;
+                // the leased task keeps its payload (and any blob it is in)
+                task->result.assign(failedTask.result);
+                task->trace = failedTask.trace;
+                std::string reason = "failed: " + task->result;
+                lsn = retryOrDeadLetter(std::move(*task), reason);
+            }
+            else
+            {
+                Logger::getInstance().log(LogLevel::WARN, "Failure report for task " + std::to_string(failedTask.taskId) +
+                                                              " arrived after session " + std::to_string(session->id()) +
+                                                              " lost its lease; dropped");
+            }
+            if (!replyWhenDurable(session, lsn, MessageType::SERVER_RESULT_CONFIRMED, requestId, ""))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Failed to send result confirmation on session " + std::to_string(session->id()));
+            }
+        }
+        else if (msgType == MessageType::CLIENT_GET_DEAD_LETTERS)
+        {
+            wire::Reader in(payload);
+            uint32_t max = 0;
+            if (!in.getU32(max))
+            {
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed dead-letter request"));
+                return;
+            }
+            session->send(MessageType::SERVER_DEAD_LETTERS, requestId, Task::serializeBatch(deadLetters.list(max)));
+        }
+        else if (msgType == MessageType::CLIENT_REQUEUE_DEAD_LETTERS)
+        {
+            wire::Reader in(payload);
+            uint32_t count = 0;
+            if (!in.getU32(count) || in.remaining() / 4 < count)
+            {
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed dead-letter request"));
+                return;
+            }
+            std::vector<int> taskIds(count);
+            for (int &taskId : taskIds)
+            {
+                in.getI32(taskId);
+            }
+
+            // Requeued tasks start over with a fresh retry budget
+            std::vector<Task> tasks = deadLetters.take(taskIds);
+            std::vector<std::string> errors;
+            errors.reserve(tasks.size());
+            uint64_t lsn = 0;
+            int64_t enqueuedUs = monotonicUs();
+            for (Task &task : tasks)
+            {
+                errors.push_back(std::move(task.result));
+                task.result.clear();
+                task.status = TaskStatus::PENDING;
+                task.retryCount = 0;
+                task.notBeforeMs = 0;
+                task.trace.enqueuedUs = enqueuedUs;
+                lsn = wal ? wal->logEnqueue(task) : 0;
+            }
+            size_t requeued = globalTaskQueue->enqueueBulk(homeShard(session), std::move(tasks));
+            // The rest did not fit; they stay dead-lettered with their last error
+            for (size_t i = requeued; i < tasks.size(); ++i)
+            {
+                Task &task = tasks[i];
+                task.result = std::move(errors[i]);
+                task.status = TaskStatus::FAILED;
+                globalTaskQueue->store().markPending(task.taskId);
+                globalTaskQueue->updateTaskResult(task.taskId, task.result, TaskStatus::FAILED);
+                lsn = wal ? wal->logComplete(task.taskId, TaskStatus::FAILED, task.result) : lsn;
+                deadLetters.add(std::move(task));
+            }
+            if (requeued > 0)
+            {
+                Logger::getInstance().log(LogLevel::INFO, "Requeued " + std::to_string(requeued) + " dead-lettered tasks");
+                tasksAvailable();
+            }
+            std::string reply;
+            wire::putU32(reply, static_cast<uint32_t>(requeued));
+            if (!replyWhenDurable(session, lsn, MessageType::SERVER_DEAD_LETTERS_REQUEUED, requestId, std::move(reply)))
+            {
+                Logger::getInstance().log(LogLevel::ERR, "Failed to send requeue reply on session " + std::to_string(session->id()));
+            }
+        }
+        else if (msgType == MessageType::CLIENT_GET_RESULT)
+        {
+            // Served from the task store; never touches the queue
+            wire::Reader in(payload);
+            int32_t taskId = 0;
+            if (!in.getI32(taskId))
+            {
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed result request"));
+                return;
+            }
+            SplicedPayload reply;
+            TaskStore::encodeRecord(reply, taskId, globalTaskQueue->store().lookup(taskId));
+            session->send(MessageType::SERVER_TASK_RESULT, requestId, std::move(reply));
+        }
+        else if (msgType == MessageType::CLIENT_GET_RESULTS_BATCH)
+        {
+            wire::Reader in(payload);
+            uint32_t count = 0;
+            if (!in.getU32(count) || in.remaining() / 4 < count)
+            {
+                session->send(MessageType::SERVER_TASK_REJECTED, requestId, encodeRejection(0, "Malformed result request"));
+                return;
+            }
+            SplicedPayload reply;
+            wire::putU32(reply.bytes, count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                int32_t taskId = 0;
+                in.getI32(taskId);
+                TaskStore::encodeRecord(reply, taskId, globalTaskQueue->store().lookup(taskId));
+            }
+            session->send(MessageType::SERVER_TASK_RESULTS, requestId, std::move(reply));
+        }
+        else if (msgType == MessageType::CLIENT_GET_STATS)
+        {
+            std::string reply;
+            collectStats().encode(reply);
+            session->send(MessageType::SERVER_STATS, requestId, reply);
+        }
+        else
+        {
+            Logger::getInstance().log(LogLevel::ERR, "Received unknown message type: " + std::to_string(static_cast<int>(msgType)));
+            session->close();
         }
     }
-    else if (msgType == MessageType::WORKER_SUBMIT_RESULT)
+
+    void onClose(const SessionPtr &session) override
     {
-        // Deserialize the task result
-        Task completedTask = Task::deserialize(payload);
-        
-        // Process the completed task
-        Logger::getInstance().log(LogLevel::INFO, "Task completed: ID=" + std::to_string(completedTask.taskId) + 
-                                  ", Result=" + completedTask.result);
-        
-        // Update metrics
+        workerRegistry.remove(session->id());
+        std::unordered_map<uint32_t, std::vector<int>> unacked;
+        std::unordered_map<uint32_t, PollRegistry::PollId> parked;
+        std::unordered_set<int> leased;
         {
-            std::lock_guard<std::mutex> lock(metricsMutex);
-            tasksCompleted++;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->closed = true;
+            unacked.swap(state->awaitingAck);
+            parked.swap(state->parkedPolls);
+            leased.swap(state->leased);
         }
-        
-        // Send acknowledgment to the worker
-        if (!conn.sendMessage(MessageType::SERVER_RESULT_CONFIRMED, ""))
+        for (auto &entry : parked)
         {
-            Logger::getInstance().log(LogLevel::ERR, "Failed to send result confirmation: " + conn.getLastError());
-            return;
+            pollRegistry.cancel(entry.second);
+        }
+        if (activity)
+        {
+            std::lock_guard<std::mutex> lock(workersMutex);
+            workers.erase(session->id());
+        }
+
+        // Assignments the worker never acknowledged go back to the queue
+        for (auto &entry : unacked)
+        {
+            for (int taskId : entry.second)
+            {
+                std::optional<Task> task = leases->revoke(taskId, session->id());
+                if (!task)
+                {
+                    continue; // already redelivered by the reaper
+                }
+                Logger::getInstance().log(LogLevel::ERR, "Connection closed before worker acknowledged task " +
+                                                             std::to_string(taskId));
+                requeue(homeShard(session), std::move(*task));
+            }
+        }
+
+        // Tasks the worker acknowledged but never finished are retried now
+        // instead of when their leases run out. Acknowledged tasks may have
+        // run, so this counts as an attempt like a lease expiry. Ids whose
+        // lease expired stay in leased; the reaper already retried those,
+        // and another worker may hold them now, so they are left alone.
+        for (int taskId : leased)
+        {
+            std::optional<Task> task = leases->revoke(taskId, session->id());
+            if (task)
+            {
+                retryOrDeadLetter(std::move(*task), "worker lost");
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t kMaxPollTimeoutMs = 60000;
+
+    std::shared_ptr<AssignmentState> state = std::make_shared<AssignmentState>();
+    std::shared_ptr<WorkerActivity> activity; // created on the first submitted result
+};
+
+static void requeue(size_t home, Task &&task)
+{
+    if (wal)
+    {
+        wal->logRequeue(task.taskId);
+    }
+    // A requeued task was accepted once already, so a full or shedding queue
+    // only delays it; a rejected enqueue leaves the task untouched
+    if (!globalTaskQueue->enqueue(home, std::move(task)))
+    {
+        Logger::getInstance().log(LogLevel::WARN, "No room to requeue task " + std::to_string(task.taskId) +
+                                                      "; held until the ready queue takes it");
+        holdForRoom(std::move(task));
+    }
+    tasksAvailable();
+}
+
+// Thread that retries tasks whose lease ran out, each expiry counting as a
+// retry with the same backoff and dead-lettering as a reported failure, and
+// disconnects registered workers that stopped sending heartbeats.
+static void leaseReaper()
+{
+    while (!stopServer.load())
+    {
+        std::this_thread::sleep_for(kLeaseCheckInterval);
+
+        int64_t nowMs = monotonicUs() / 1000;
+        // Registered workers silent for too long are disconnected; closing
+        // the connection reclaims their tasks
+        int64_t silentSinceMs = nowMs - Config::HeartbeatInterval.count() * Config::HeartbeatMissLimit;
+        for (WorkerRegistry::Evict &evict : workerRegistry.expire(silentSinceMs))
+        {
+            evict();
+        }
+
+        for (Task &task : leases->expire(nowMs))
+        {
+            // A result that raced the expiry already settled it
+            std::optional<TaskRecord> record = globalTaskQueue->store().lookup(task.taskId);
+            if (record && (record->status == TaskStatus::COMPLETED || record->status == TaskStatus::FAILED))
+            {
+                continue;
+            }
+
+            retryOrDeadLetter(std::move(task), "lease expired");
         }
     }
-    else
+}
+
+// Thread that moves delayed tasks into the ready queue once they are due, one
+// bulk enqueue per tick, along with tasks held in overflowTasks. Those the
+// ready queue has no room for wait here for the next tick instead of being
+// dropped, still PENDING: a rejected enqueue puts back their store record.
+static void delayedPromoter()
+{
+    std::vector<Task> waiting;
+    size_t nextShard = 0;
+    while (!stopServer.load())
     {
-        Logger::getInstance().log(LogLevel::ERR, "Received unknown message type: " + std::to_string(static_cast<int>(msgType)));
+        std::this_thread::sleep_for(kPromoteInterval);
+
+        std::vector<Task> due = delayedTasks->takeDue(monotonicUs() / 1000);
+        waiting.insert(waiting.end(), std::make_move_iterator(due.begin()), std::make_move_iterator(due.end()));
+        {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            waiting.insert(waiting.end(), std::make_move_iterator(overflowTasks.begin()),
+                           std::make_move_iterator(overflowTasks.end()));
+            overflowTasks.clear();
+        }
+        if (waiting.empty())
+        {
+            continue;
+        }
+        int64_t enqueuedUs = monotonicUs();
+        for (Task &task : waiting)
+        {
+            task.trace.enqueuedUs = enqueuedUs;
+        }
+        // Spread promotions over the shards; enqueueBulk spills to siblings when one is full
+        size_t promoted = globalTaskQueue->enqueueBulk(nextShard++ % globalTaskQueue->shardCount(), std::move(waiting));
+        waiting.erase(waiting.begin(), waiting.begin() + static_cast<std::ptrdiff_t>(promoted));
+        if (promoted > 0)
+        {
+            DTQ_LOG(INFO, "Promoted " + std::to_string(promoted) + " delayed tasks");
+            tasksAvailable();
+        }
     }
 }
 
-// Thread that logs tasks/s every 5 seconds using a sliding window
+// Thread that logs tasks/s every 5 seconds, with each stage's latency
+// percentiles over the same 5 seconds
 static void throughputReporter()
 {
+    std::vector<Histogram::Snapshot> previous(static_cast<size_t>(Stage::Count));
     while (!stopServer.load())
     {
         std::this_thread::sleep_for(std::chrono::seconds(5));
 
-        auto now = std::chrono::steady_clock::now();
-        auto elapsedSec = std::chrono::duration_cast<std::chrono::seconds>(now - lastReportTime).count();
-        
-        long long tasksDone = tasksSinceLastReport.exchange(0);  // Reset counter
-        lastReportTime = now;
+        double tps = lifecycle.completedPerSecond();
+        uint64_t totalDone = tasksCompleted.value() + tasksFailed.value();
 
-        if (elapsedSec > 0)
+        std::string depths;
+        size_t queued = 0;
+        for (size_t depth : globalTaskQueue->shardDepths())
         {
-            double tps = static_cast<double>(tasksDone) / elapsedSec;
-            long long totalDone = tasksCompleted.load();
-            
-            Logger::getInstance().log(LogLevel::INFO,
-                                    "[THROUGHPUT REPORT] Recent tasks/sec=" + std::to_string(tps) +
-                                    " totalCompleted=" + std::to_string(totalDone));
+            depths += (depths.empty() ? "" : ",") + std::to_string(depth);
+            queued += depth;
+        }
+        size_t bytesPerTask = queued ? globalTaskQueue->bytesQueued() / queued : 0;
+
+        Logger::getInstance().log(LogLevel::INFO,
+                                  "[THROUGHPUT REPORT] Recent tasks/sec=" + std::to_string(tps) +
+                                      " totalCompleted=" + std::to_string(totalDone) +
+                                      " delayed=" + std::to_string(delayedTasks->size()) +
+                                      " dead=" + std::to_string(deadLetters.size()) +
+                                      " shed=" + std::to_string(tasksShed.value() + globalTaskQueue->shed()) +
+                                      " pushWorkers=" + std::to_string(workerRegistry.size()) +
+                                      " bytesPerQueuedTask=" + std::to_string(bytesPerTask) +
+                                      " blobBytes=" + std::to_string(blobs ? blobs->bytesStored() : 0) +
+                                      " shardDepths=[" + depths + "]");
+
+        std::string latency;
+        for (size_t i = 0; i < previous.size(); ++i)
+        {
+            Stage stage = static_cast<Stage>(i);
+            Histogram::Snapshot current = lifecycle.snapshot(stage);
+            Histogram::Snapshot recent = current.since(previous[i]);
+            previous[i] = std::move(current);
+            if (recent.total > 0)
+            {
+                latency += (latency.empty() ? "" : " | ") + LifecycleMetrics::describe(stage, recent);
+            }
+        }
+        if (!latency.empty())
+        {
+            Logger::getInstance().log(LogLevel::INFO, "[LATENCY REPORT] " + latency);
         }
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    // --queue=ring|mutex|priority: TaskQueue backend; --shards=N: queue shards (default: one per core)
+    // --wal=path: durable queue state; --wal-window-us=N: group commit window
+    // --metrics-port=N: serve Prometheus text at http://host:N/metrics
+    // --lease-ms=N: time a worker has to return a result before the task is redelivered
+    // --queue-target-ms=N: shed new tasks while queueing delay stays above N ms (0: off)
+    // --blob-dir=path: keep large payloads and results in files there; --blob-threshold=N: what counts as large
+    QueueBackend backend = QueueBackend::LockFreeRing;
+    size_t shards = std::max(1u, std::thread::hardware_concurrency());
+    std::string walPath;
+    std::chrono::microseconds walWindow = Config::WalCommitWindow;
+    int metricsPort = -1;
+    std::chrono::milliseconds leaseTimeout = Config::LeaseTimeout;
+    std::string blobDir;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--queue=mutex")
+        {
+            backend = QueueBackend::Mutex;
+        }
+        else if (arg == "--queue=ring")
+        {
+            backend = QueueBackend::LockFreeRing;
+        }
+        else if (arg == "--queue=priority")
+        {
+            backend = QueueBackend::Priority;
+        }
+        else if (arg.rfind("--shards=", 0) == 0)
+        {
+            shards = static_cast<size_t>(std::max(1, std::atoi(arg.c_str() + 9)));
+        }
+        else if (arg.rfind("--wal=", 0) == 0)
+        {
+            walPath = arg.substr(6);
+        }
+        else if (arg.rfind("--wal-window-us=", 0) == 0)
+        {
+            walWindow = std::chrono::microseconds(std::max(0, std::atoi(arg.c_str() + 16)));
+        }
+        else if (arg.rfind("--metrics-port=", 0) == 0)
+        {
+            metricsPort = std::atoi(arg.c_str() + 15);
+        }
+        else if (arg.rfind("--lease-ms=", 0) == 0)
+        {
+            leaseTimeout = std::chrono::milliseconds(std::max(1, std::atoi(arg.c_str() + 11)));
+        }
+        else if (arg.rfind("--queue-target-ms=", 0) == 0)
+        {
+            queueTarget = std::chrono::milliseconds(std::max(0, std::atoi(arg.c_str() + 18)));
+        }
+        else if (arg.rfind("--blob-dir=", 0) == 0)
+        {
+            blobDir = arg.substr(11);
+        }
+        else if (arg.rfind("--blob-threshold=", 0) == 0)
+        {
+            blobThreshold = static_cast<size_t>(std::max(1LL, std::atoll(arg.c_str() + 17)));
+        }
+    }
+    globalTaskQueue = std::make_unique<ShardedTaskQueue>(shards, backend);
+    globalTaskQueue->setLatencyTarget(queueTarget);
+    leases = std::make_unique<LeaseTable>(leaseTimeout, monotonicUs() / 1000);
+    delayedTasks = std::make_unique<DelayedTaskQueue>(monotonicUs() / 1000);
+
     Logger::getInstance().setLogFile("server.log");
-    Logger::getInstance().log(LogLevel::INFO, "Starting Dist. Task Queue Server (One msg/connection).");
+    // Session threads only queue log records; a background thread writes them
+    Logger::getInstance().setAsync(true);
+    Logger::getInstance().log(LogLevel::INFO, "Starting Dist. Task Queue Server (persistent connections).");
 
     if (!Network::initialize())
     {
@@ -215,82 +1171,123 @@ int main()
         return -1;
     }
 
-#ifdef _WIN32
-    SOCKET serverSock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (serverSock == INVALID_SOCKET)
+    if (!blobDir.empty())
     {
-        Logger::getInstance().log(LogLevel::ERR, "Server socket creation failed.");
-        return -1;
+        blobs = std::make_shared<BlobStore>(blobDir);
+        if (!blobs->open())
+        {
+            Logger::getInstance().log(LogLevel::ERR, blobs->getLastError());
+            Network::cleanup();
+            return -1;
+        }
+        Logger::getInstance().log(LogLevel::INFO, "Payloads and results of " + std::to_string(blobThreshold) +
+                                                      " bytes or more are kept in " + blobDir);
     }
 
-    sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(5555);
-
-    if (bind(serverSock, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr)) == SOCKET_ERROR)
+    if (!walPath.empty())
     {
-        Logger::getInstance().log(LogLevel::ERR, "Bind failed.");
-        return -1;
+        // Replay before accepting connections; tasks that were in flight when
+        // the server stopped lost their worker, so they are queued again too
+        wal = std::make_unique<WriteAheadLog>(walWindow);
+        WriteAheadLog::Recovered recovered;
+        if (!wal->open(walPath, recovered))
+        {
+            Logger::getInstance().log(LogLevel::ERR, wal->getLastError());
+            Network::cleanup();
+            return -1;
+        }
+        // A log may hold more tasks than Config::MaxQueueSize; those that do
+        // not fit wait for room with the promoter, as the compacted log keeps them
+        size_t next = 0;
+        size_t overflowed = 0;
+        int64_t nowWallMs = wallClockMs();
+        for (std::vector<Task> *tasks : {&recovered.pending, &recovered.inFlight})
+        {
+            for (Task &task : *tasks)
+            {
+                if (task.notBeforeMs > nowWallMs && holdUntilDue(std::move(task), nowWallMs))
+                {
+                    continue;
+                }
+                if (!globalTaskQueue->enqueue(next++ % globalTaskQueue->shardCount(), std::move(task)))
+                {
+                    holdForRoom(std::move(task));
+                    ++overflowed;
+                }
+            }
+        }
+        Logger::getInstance().log(LogLevel::INFO, "Recovered " + std::to_string(recovered.pending.size()) + " pending and " +
+                                                      std::to_string(recovered.inFlight.size()) + " in-flight tasks from " +
+                                                      std::to_string(recovered.records) + " WAL records" +
+                                                      (recovered.truncated ? " (discarded a torn tail)" : ""));
+        if (overflowed > 0)
+        {
+            Logger::getInstance().log(LogLevel::WARN, std::to_string(overflowed) + " recovered tasks could not be queued; "
+                                                                                   "held until the ready queue has room");
+        }
     }
-    if (listen(serverSock, SOMAXCONN) == SOCKET_ERROR)
+
+    // Connections are multiplexed over a fixed set of event-loop threads where
+    // epoll is available; elsewhere each connection gets its own thread.
+    TcpServer server(5555, TcpServer::defaultMode(), Config::ThreadPoolSize);
+    if (!server.start([]() { return std::make_unique<ServerSession>(); }))
     {
-        Logger::getInstance().log(LogLevel::ERR, "Listen failed.");
+        Logger::getInstance().log(LogLevel::ERR, server.getLastError());
+        Network::cleanup();
         return -1;
     }
 
     Logger::getInstance().log(LogLevel::INFO, "Server listening on port 5555...");
 
-    // Launch stats thread
-    std::thread statsThread(throughputReporter);
+    pollRegistry.start();
 
-    std::vector<std::thread> connectionThreads;
-    connectionThreads.reserve(128);
+    std::unique_ptr<MetricsHttpServer> metricsServer;
+    if (metricsPort >= 0)
+    {
+        metricsServer = std::make_unique<MetricsHttpServer>(metricsPort);
+        if (metricsServer->start([]() { return collectStats().toPrometheus(); }))
+        {
+            Logger::getInstance().log(LogLevel::INFO, "Metrics at http://0.0.0.0:" + std::to_string(metricsServer->boundPort()) + "/metrics");
+        }
+        else
+        {
+            Logger::getInstance().log(LogLevel::ERR, metricsServer->getLastError());
+            metricsServer.reset();
+        }
+    }
+
+    // Launch stats, lease expiry and delayed task threads
+    std::thread statsThread(throughputReporter);
+    std::thread reaperThread(leaseReaper);
+    std::thread promoterThread(delayedPromoter);
 
     std::cout << "Server running. Press Enter to stop..." << std::endl;
-    
-    // Run server in a separate thread so we can handle shutdown
-    std::thread serverThread([&]() {
-        while (!stopServer.load())
-        {
-            sockaddr_in clientAddr;
-            int clientSize = sizeof(clientAddr);
-            SOCKET clientSock = accept(serverSock, reinterpret_cast<sockaddr *>(&clientAddr), &clientSize);
-            if (clientSock == INVALID_SOCKET)
-            {
-                if (!stopServer.load()) {
-                    Logger::getInstance().log(LogLevel::ERR, "Accept failed.");
-                }
-                continue;
-            }
-            connectionThreads.emplace_back(std::thread(handleClientConnection, clientSock));
-        }
-    });
 
     // Wait for user input to stop
     std::cin.get();
     stopServer.store(true);
-    
-    // Force close the server socket to unblock accept
-    closesocket(serverSock);
-    
-    // Wait for server thread
-    if (serverThread.joinable())
-        serverThread.join();
-
-    // Wait for stats thread
-    if (statsThread.joinable())
-        statsThread.join();
 
-    // Wait for connection threads
-    for (auto &t : connectionThreads)
+    if (metricsServer)
     {
-        if (t.joinable())
-            t.join();
+        metricsServer->stop();
     }
+    server.stop();
+    pollRegistry.stop();
+    if (wal)
+    {
+        wal->close();
+    }
+
+    // Wait for stats, lease expiry and delayed task threads
+    if (statsThread.joinable())
+        statsThread.join();
+    if (reaperThread.joinable())
+        reaperThread.join();
+    if (promoterThread.joinable())
+        promoterThread.join();
 
     Network::cleanup();
-#endif
+    Logger::getInstance().setAsync(false);
 
     return 0;
 }
@@ -1,230 +1,368 @@
 #include "Network.h"
 #include "Task.h"
+#include "TaskPool.h"
 #include "TaskQueue.h"
 #include "Logger.h"
 #include "Config.h"
+#include "Wire.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <vector>
 #include <atomic>
+#include <functional>
+#include <future>
 
 using namespace dtq;
 
 static std::atomic<bool> stopWorkers{false};
 
-void workerThread(int workerId)
+// Push mode: tasks received and not yet finished, credits freed since the
+// last heartbeat, and the connection generation the registration belongs to
+static std::atomic<size_t> outstanding{0};
+static std::atomic<uint32_t> freedCredits{0};
+static std::atomic<uint64_t> registeredGeneration{0};
+
+// The fetcher (or heartbeat) and submitter threads share one persistent connection.
+// Client::connect() is a no-op while it is up, so whichever thread notices a
+// drop re-establishes it.
+static bool connectWithRetries(dtq::Network::Client &client, const std::string &who)
 {
-    dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "[Worker " + std::to_string(workerId) + "] Worker starting");
-    
-    // Get server address and port from config
-    std::string serverAddress = "127.0.0.1"; // Default value
-    int serverPort = 5555; // Default value
-    
     // Retry parameters
     int maxRetries = 3;
     int retryDelayMs = 500; // 500 milliseconds
+
+    for (int retries = 0; retries < maxRetries && !stopWorkers.load(); retries++)
+    {
+        if (client.connect())
+        {
+            return true;
+        }
+        dtq::Logger::getInstance().log(dtq::LogLevel::WARN, 
+            "[" + who + "] Connection failed: " + client.getLastError() + 
+            ". Retrying in " + std::to_string(retryDelayMs) + "ms...");
+
+        // Wait before retrying
+        std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMs));
+    }
+    return false;
+}
+
+// Simulates the work described by the payload and fills in the result. A
+// payload containing "(Fail)" simulates a task that always fails.
+static void processTask(dtq::Task &task, int workerId)
+{
+    DTQ_LOG(INFO, 
+        "[Worker " + std::to_string(workerId) + "] Processing task ID=" + std::to_string(task.taskId));
+    
+    // Extract duration from payload if available
+    int processingTime = 1000; // Default 1 second
+    size_t durationPos = task.payload.find("Duration: ");
+    if (durationPos != std::string::npos) {
+        size_t msPos = task.payload.find("ms", durationPos);
+        if (msPos != std::string::npos) {
+            std::string durationStr = task.payload.substr(durationPos + 10, msPos - (durationPos + 10));
+            try {
+                processingTime = std::stoi(durationStr);
+            } catch (const std::exception& e) {
+                dtq::Logger::getInstance().log(dtq::LogLevel::WARN, 
+                    "[Worker " + std::to_string(workerId) + "] Failed to parse duration: " + e.what());
+            }
+        }
+    }
+    
+    // Simulate task processing
+    std::this_thread::sleep_for(std::chrono::milliseconds(processingTime));
+    
+    // Update task status and result
+    task.trace.completedUs = dtq::monotonicUs();
+    if (task.payload.find("(Fail)") != std::string::npos) {
+        task.status = dtq::TaskStatus::FAILED;
+        task.result = "Simulated failure on Worker " + std::to_string(workerId);
+        return;
+    }
+    task.status = dtq::TaskStatus::COMPLETED;
+    task.result = "Processed by Worker " + std::to_string(workerId) + " in " + std::to_string(processingTime) + "ms";
+}
+
+// Returns false if the server did not confirm the result
+static bool submitResult(dtq::Network::Client &client, const dtq::Task &task)
+{
+    if (!connectWithRetries(client, "Submitter"))
+    {
+        dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
+            "[Submitter] Failed to connect for result submission. Retrying task later...");
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        return false;
+    }
     
+    // Submit the result to the server and wait for confirmation; the server
+    // decides whether a failed task is retried
+    std::string serializedResult = task.serialize();
+    dtq::MessageType type = task.status == dtq::TaskStatus::FAILED ? dtq::MessageType::WORKER_REPORT_FAILURE
+                                                                    : dtq::MessageType::WORKER_SUBMIT_RESULT;
+    dtq::Message confirmation;
+    if (!client.call(type, serializedResult, confirmation, dtq::Config::NetworkTimeout))
+    {
+        dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
+            "[Submitter] Failed to submit result: " + client.getLastError());
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        return false;
+    }
+    
+    if (confirmation.type != dtq::MessageType::SERVER_RESULT_CONFIRMED)
+    {
+        dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
+            "[Submitter] Received unexpected confirmation type: " + 
+            std::to_string(static_cast<int>(confirmation.type)));
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        return false;
+    }
+    
+    DTQ_LOG(INFO, "[Submitter] Result for task ID=" + std::to_string(task.taskId) + " confirmed by server");
+    return true;
+}
+
+// Copies received tasks out of the response buffer into pooled tasks,
+// stamping their receipt
+static std::vector<dtq::Task> copyTasks(const std::vector<dtq::TaskView> &views)
+{
+    int64_t receivedUs = dtq::monotonicUs();
+    std::vector<dtq::Task> tasks;
+    tasks.reserve(views.size());
+    for (const dtq::TaskView &view : views)
+    {
+        tasks.push_back(dtq::TaskPool::getInstance().acquire(view));
+        tasks.back().trace.receivedUs = receivedUs;
+    }
+    return tasks;
+}
+
+// Returns the credits freed so far. False if the current connection is not
+// registered yet or the heartbeat could not be sent.
+static bool sendHeartbeat(dtq::Network::Client &client)
+{
+    if (registeredGeneration.load() != client.generation())
+    {
+        return false;
+    }
+    std::string payload;
+    dtq::wire::putU32(payload, freedCredits.exchange(0));
+    return client.notify(dtq::MessageType::WORKER_HEARTBEAT, 0, payload);
+}
+
+// Push mode: registers with the server, again after every reconnect, and
+// heartbeats at the interval it asks for. Credits start at capacity minus the
+// tasks still held locally; the submitter returns them as tasks finish.
+static void heartbeatLoop(dtq::Network::Client &client, size_t capacity)
+{
+    std::chrono::milliseconds interval = dtq::Config::HeartbeatInterval;
     while (!stopWorkers.load())
     {
-        // Create a connection to the server
-        dtq::Network::Connection conn(serverAddress, serverPort);
-        
-        // Connect to the server with retries
-        bool connected = false;
-        int retries = 0;
-        
-        while (!connected && retries < maxRetries && !stopWorkers.load())
+        if (!client.isConnected() || registeredGeneration.load() != client.generation())
         {
-            if (conn.connect())
+            if (!connectWithRetries(client, "Heartbeat"))
             {
-                connected = true;
+                dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Heartbeat] Failed to connect. Retrying later...");
+                std::this_thread::sleep_for(std::chrono::seconds(3));
+                continue;
             }
-            else
+            uint64_t generation = client.generation();
+            freedCredits.store(0);
+            uint32_t credits = static_cast<uint32_t>(capacity - std::min(outstanding.load(), capacity));
+            std::string request;
+            dtq::wire::putU32(request, credits);
+            dtq::Message response;
+            uint32_t intervalMs = 0;
+            if (!client.call(dtq::MessageType::WORKER_REGISTER, request, response, dtq::Config::NetworkTimeout) ||
+                response.type != dtq::MessageType::SERVER_WORKER_REGISTERED ||
+                !dtq::wire::Reader(response.payload).getU32(intervalMs))
             {
-                dtq::Logger::getInstance().log(dtq::LogLevel::WARN, 
-                    "[Worker " + std::to_string(workerId) + "] Connection failed: " + conn.getLastError() + 
-                    ". Retrying in " + std::to_string(retryDelayMs) + "ms...");
-                
-                // Wait before retrying
-                std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMs));
-                retries++;
+                dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Heartbeat] Registration failed: " + client.getLastError());
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
             }
+            interval = std::chrono::milliseconds(std::max<uint32_t>(intervalMs, 100));
+            registeredGeneration.store(generation);
+            dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "[Heartbeat] Registered with " + std::to_string(credits) +
+                                                                    " credits, heartbeat every " + std::to_string(interval.count()) + "ms");
         }
-        
-        if (!connected)
+        else if (!sendHeartbeat(client))
+        {
+            continue; // reconnect and register again
+        }
+
+        // Sleep in short steps so a stop is noticed promptly
+        for (std::chrono::milliseconds waited(0); waited < interval && !stopWorkers.load(); waited += std::chrono::milliseconds(50))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+// Poll mode (--poll) I/O thread: keeps up to `prefetch` tasks queued in the
+// pool, long-polling for just enough to top it up, so compute threads find
+// work waiting
+static void fetchLoop(dtq::Network::Client &client, dtq::WorkerPool &pool, int fetchBatch, int prefetch)
+{
+    while (!stopWorkers.load())
+    {
+        if (!pool.waitForRoom(static_cast<size_t>(prefetch), std::chrono::milliseconds(200)))
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to connect after " + 
-                std::to_string(maxRetries) + " retries. Retrying later...");
-            std::this_thread::sleep_for(std::chrono::seconds(3));
             continue;
         }
-        
-        // Request a task from the server
-        if (!conn.sendMessage(dtq::MessageType::WORKER_REQUEST_TASK, ""))
+        if (!connectWithRetries(client, "Fetcher"))
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to request task: " + conn.getLastError());
-            conn.disconnect();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Fetcher] Failed to connect. Retrying later...");
+            std::this_thread::sleep_for(std::chrono::seconds(3));
             continue;
         }
-        
-        // Receive the task from the server
-        dtq::MessageType responseType;
-        std::string payload;
-        
-        if (!conn.receiveMessage(responseType, payload))
+
+        // Long-poll: the server holds the request until tasks arrive or the timeout expires
+        size_t room = static_cast<size_t>(prefetch) - std::min(pool.queued(), static_cast<size_t>(prefetch));
+        std::string request;
+        dtq::wire::putU32(request, static_cast<uint32_t>(std::max<size_t>(1, std::min(room, static_cast<size_t>(fetchBatch)))));
+        dtq::wire::putU32(request, static_cast<uint32_t>(dtq::Config::LongPollTimeout.count()));
+        dtq::Message response;
+        if (!client.call(dtq::MessageType::WORKER_POLL_TASKS, request, response,
+                         dtq::Config::LongPollTimeout + dtq::Config::NetworkTimeout))
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to receive task: " + conn.getLastError());
-            conn.disconnect();
+            if (stopWorkers.load())
+            {
+                break; // the poll was cut short by the shutdown
+            }
+            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Fetcher] Failed to receive tasks: " + client.getLastError());
             std::this_thread::sleep_for(std::chrono::seconds(1));
             continue;
         }
-        
-        if (responseType != dtq::MessageType::SERVER_ASSIGN_TASK)
+
+        std::vector<dtq::TaskView> views;
+        if (response.type != dtq::MessageType::SERVER_ASSIGN_TASKS || !dtq::Task::decodeBatch(response.payload, views))
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Received unexpected message type: " + 
-                std::to_string(static_cast<int>(responseType)));
-            conn.disconnect();
+            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Fetcher] Received unexpected message type: " +
+                                                                   std::to_string(static_cast<int>(response.type)));
             std::this_thread::sleep_for(std::chrono::seconds(1));
             continue;
         }
-        
-        // Check if we received an empty payload (no tasks available)
-        if (payload.empty())
+
+        // An empty batch means the poll timed out with no tasks; poll again right away
+        if (views.empty())
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::INFO, 
-                "[Worker " + std::to_string(workerId) + "] No tasks available");
-            conn.disconnect();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            DTQ_LOG(INFO, "[Fetcher] No tasks available");
             continue;
         }
-        
-        // Deserialize the task
-        dtq::Task task = dtq::Task::deserialize(payload);
-        
-        // Send acknowledgment to the server
-        if (!conn.sendMessage(dtq::MessageType::WORKER_TASK_RECEIVED, ""))
+
+        std::vector<dtq::Task> tasks = copyTasks(views);
+
+        // Send one acknowledgment for the whole batch, correlated with the assignment
+        if (!client.notify(dtq::MessageType::WORKER_TASK_RECEIVED, response.requestId, ""))
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to send acknowledgment: " + conn.getLastError());
-            conn.disconnect();
+            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Fetcher] Failed to send acknowledgment: " + client.getLastError());
             std::this_thread::sleep_for(std::chrono::seconds(1));
             continue;
         }
-        
-        // Close the connection while processing
-        conn.disconnect();
-        
-        // Process the task
-        dtq::Logger::getInstance().log(dtq::LogLevel::INFO, 
-            "[Worker " + std::to_string(workerId) + "] Processing task ID=" + std::to_string(task.taskId));
-        
-        // Extract duration from payload if available
-        int processingTime = 1000; // Default 1 second
-        size_t durationPos = task.payload.find("Duration: ");
-        if (durationPos != std::string::npos) {
-            size_t msPos = task.payload.find("ms", durationPos);
-            if (msPos != std::string::npos) {
-                std::string durationStr = task.payload.substr(durationPos + 10, msPos - (durationPos + 10));
-                try {
-                    processingTime = std::stoi(durationStr);
-                } catch (const std::exception& e) {
-                    dtq::Logger::getInstance().log(dtq::LogLevel::WARN, 
-                        "[Worker " + std::to_string(workerId) + "] Failed to parse duration: " + e.what());
-                }
+        pool.submit(std::move(tasks));
+    }
+}
+
+// Submitter thread: sends finished tasks back as the pool produces them. All
+// results of one batch are in flight at once on the multiplexed connection;
+// only those that fail are retried one by one. In push mode the freed
+// credits go out right behind the results, so the next tasks are pushed
+// while the confirmations are still on their way.
+static void submitLoop(dtq::Network::Client &client, dtq::WorkerPool &pool, const std::atomic<bool> &poolStopped,
+                       bool returnCredits)
+{
+    for (;;)
+    {
+        bool lastPass = poolStopped.load();
+        std::vector<dtq::Task> results = pool.takeResults(std::chrono::milliseconds(100));
+        if (results.empty())
+        {
+            if (lastPass)
+            {
+                return;
             }
+            continue;
+        }
+
+        std::vector<std::future<dtq::Message>> confirmations;
+        confirmations.reserve(results.size());
+        for (dtq::Task &task : results)
+        {
+            // The server still has the payload; only the result needs to go back
+            task.payload.clear();
+            dtq::MessageType type = task.status == dtq::TaskStatus::FAILED ? dtq::MessageType::WORKER_REPORT_FAILURE
+                                                                            : dtq::MessageType::WORKER_SUBMIT_RESULT;
+            confirmations.push_back(client.request(type, task.serialize()));
+        }
+        if (returnCredits)
+        {
+            outstanding.fetch_sub(results.size());
+            freedCredits.fetch_add(static_cast<uint32_t>(results.size()));
+            sendHeartbeat(client);
         }
-        
-        // Simulate task processing
-        std::this_thread::sleep_for(std::chrono::milliseconds(processingTime));
-        
-        // Update task status and result
-        task.status = dtq::TaskStatus::COMPLETED;
-        task.result = "Processed by Worker " + std::to_string(workerId) + " in " + std::to_string(processingTime) + "ms";
-        
-        // Create a new connection to submit the result
-        dtq::Network::Connection resultConn(serverAddress, serverPort);
-        
-        // Connect to the server with retries
-        connected = false;
-        retries = 0;
-        
-        while (!connected && retries < maxRetries && !stopWorkers.load())
+        for (size_t i = 0; i < results.size(); ++i)
         {
-            if (resultConn.connect())
+            const dtq::Task &task = results[i];
+            if (confirmations[i].wait_for(dtq::Config::NetworkTimeout) == std::future_status::ready &&
+                confirmations[i].get().type == dtq::MessageType::SERVER_RESULT_CONFIRMED)
             {
-                connected = true;
+                DTQ_LOG(INFO, "[Submitter] Result for task ID=" + std::to_string(task.taskId) + " confirmed by server");
+                continue;
             }
-            else
+            // Keep the result while retrying; if it never gets through, the
+            // server redelivers the task when its lease expires
+            int attempts = 1;
+            while (!submitResult(client, task) && !stopWorkers.load())
             {
-                dtq::Logger::getInstance().log(dtq::LogLevel::WARN, 
-                    "[Worker " + std::to_string(workerId) + "] Result connection failed: " + resultConn.getLastError() + 
-                    ". Retrying in " + std::to_string(retryDelayMs) + "ms...");
-                
-                // Wait before retrying
-                std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMs));
-                retries++;
+                if (attempts++ > dtq::Config::TaskRetryLimit)
+                {
+                    dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "[Submitter] Giving up on result for task ID=" +
+                                                                           std::to_string(task.taskId) + "; the server will redeliver it");
+                    break;
+                }
             }
         }
-        
-        if (!connected)
+        // Their buffers take the next tasks received
+        dtq::TaskPool::getInstance().release(std::move(results));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // --threads=N: compute threads, default Config::ThreadPoolSize
+    // --prefetch=N: tasks kept queued locally, default Config::WorkerPrefetch
+    // --batch=N: most tasks fetched per WORKER_POLL_TASKS round trip
+    // --poll: long-poll for tasks instead of registering for pushed ones
+    int threads = dtq::Config::ThreadPoolSize;
+    int prefetch = dtq::Config::WorkerPrefetch;
+    int fetchBatch = dtq::Config::BatchSize;
+    bool poll = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg.rfind("--threads=", 0) == 0)
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to connect for result submission after " + 
-                std::to_string(maxRetries) + " retries. Retrying task later...");
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
+            threads = std::max(1, std::atoi(arg.c_str() + 10));
         }
-        
-        // Submit the result to the server
-        std::string serializedResult = task.serialize();
-        if (!resultConn.sendMessage(dtq::MessageType::WORKER_SUBMIT_RESULT, serializedResult))
+        else if (arg.rfind("--prefetch=", 0) == 0)
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to submit result: " + resultConn.getLastError());
-            resultConn.disconnect();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
+            prefetch = std::max(1, std::atoi(arg.c_str() + 11));
         }
-        
-        // Receive confirmation from the server
-        dtq::MessageType confirmationType;
-        std::string confirmationPayload;
-        
-        if (!resultConn.receiveMessage(confirmationType, confirmationPayload))
+        else if (arg.rfind("--batch=", 0) == 0)
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Failed to receive result confirmation: " + resultConn.getLastError());
-            resultConn.disconnect();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
+            fetchBatch = std::max(1, std::atoi(arg.c_str() + 8));
         }
-        
-        if (confirmationType != dtq::MessageType::SERVER_RESULT_CONFIRMED)
+        else if (arg == "--poll")
         {
-            dtq::Logger::getInstance().log(dtq::LogLevel::ERR, 
-                "[Worker " + std::to_string(workerId) + "] Received unexpected confirmation type: " + 
-                std::to_string(static_cast<int>(confirmationType)));
-            resultConn.disconnect();
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
+            poll = true;
         }
-        
-        dtq::Logger::getInstance().log(dtq::LogLevel::INFO, 
-            "[Worker " + std::to_string(workerId) + "] Result for task ID=" + std::to_string(task.taskId) + " confirmed by server");
-        
-        // Close the result connection
-        resultConn.disconnect();
     }
-}
 
-int main()
-{
     // Initialize Windows sockets
     if (!dtq::Network::initialize())
     {
@@ -233,26 +371,67 @@ int main()
     }
 
     dtq::Logger::getInstance().setLogFile("worker.log");
+    // Task threads only queue log records; a background thread writes them
+    dtq::Logger::getInstance().setAsync(true);
     dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "Starting Distributed Task Queue Worker");
-    dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "Starting 2 worker threads");
+    dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "Starting " + std::to_string(threads) + " worker threads, prefetching " +
+                                                            std::to_string(prefetch) + " tasks");
+
+    // Get server address and port from config
+    std::string serverAddress = "127.0.0.1"; // Default value
+    int serverPort = 5555; // Default value
+    dtq::Network::Client client(serverAddress, serverPort);
 
-    std::vector<std::thread> workers;
-    for (int i = 1; i <= 2; i++)
+    // Compute threads never touch the network: tasks arrive by push (or from
+    // the fetcher with --poll) and one thread submits the results
+    int64_t startUs = dtq::monotonicUs();
+    dtq::WorkerPool pool(static_cast<size_t>(threads), processTask);
+    std::atomic<bool> poolStopped{false};
+    std::thread fetcher;
+    if (poll)
     {
-        workers.emplace_back(std::thread(workerThread, i));
+        fetcher = std::thread(fetchLoop, std::ref(client), std::ref(pool), fetchBatch, prefetch);
     }
+    else
+    {
+        // Runs on the connection's reader thread
+        client.setPushHandler([&client, &pool](dtq::Message &&message) {
+            std::vector<dtq::TaskView> views;
+            if (message.type != dtq::MessageType::SERVER_PUSH_TASKS || !dtq::Task::decodeBatch(message.payload, views))
+            {
+                dtq::Logger::getInstance().log(dtq::LogLevel::ERR, "Received unexpected push: " +
+                                                                       std::to_string(static_cast<int>(message.type)));
+                return;
+            }
+            std::vector<dtq::Task> tasks = copyTasks(views);
+            client.notify(dtq::MessageType::WORKER_TASK_RECEIVED, message.requestId, "");
+            outstanding.fetch_add(tasks.size());
+            pool.submit(std::move(tasks));
+        });
+        // Credits cover every running thread plus the prefetch depth
+        fetcher = std::thread(heartbeatLoop, std::ref(client), static_cast<size_t>(threads + prefetch));
+    }
+    std::thread submitter(submitLoop, std::ref(client), std::ref(pool), std::cref(poolStopped), !poll);
     dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "Worker pool running. Press Enter to stop...");
 
     // Wait for user input
     std::cin.get();
     stopWorkers.store(true);
+    // Running tasks finish and their results go out; queued ones are left to
+    // their leases
+    pool.stop();
+    poolStopped.store(true);
+    submitter.join();
+    // Fails any parked long-poll so the fetcher notices the stop flag; the
+    // server reclaims whatever was pushed but not run
+    client.disconnect();
+    fetcher.join();
 
-    for (auto &th : workers)
-    {
-        if (th.joinable())
-            th.join();
-    }
-    dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "All workers stopped.");
+    double elapsedUs = static_cast<double>(std::max<int64_t>(1, dtq::monotonicUs() - startUs));
+    dtq::Logger::getInstance().log(dtq::LogLevel::INFO, "All workers stopped. Utilization " +
+                                                            std::to_string(static_cast<int>(100.0 * pool.busyUs() / (elapsedUs * threads))) +
+                                                            "%, " + std::to_string(pool.steals()) + " tasks stolen");
+    dtq::Logger::getInstance().setAsync(false);
     
     // Cleanup Windows sockets
     dtq::Network::cleanup();
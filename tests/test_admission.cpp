@@ -0,0 +1,62 @@
+#include "Admission.h"
+#include "Config.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+int main() {
+    const uint32_t lo = static_cast<uint32_t>(dtq::Config::RetryAfterMin.count());
+    const uint32_t hi = static_cast<uint32_t>(dtq::Config::RetryAfterMax.count());
+
+    // Test: The retry-after hint is the time to drain down to the target depth, clamped.
+    assert(dtq::retryAfterMs(1000, 500, 1000.0) == 500);
+    assert(dtq::retryAfterMs(1000, 500, 250.0) == 2000);
+    assert(dtq::retryAfterMs(600, 500, 1e6) == lo);
+    assert(dtq::retryAfterMs(400, 500, 1000.0) == lo);
+    assert(dtq::retryAfterMs(1000, 500, 1.0) == hi);
+    assert(dtq::retryAfterMs(1000, 500, 0.0) == hi);
+
+    // Test: Rejections round-trip through the wire payload.
+    uint32_t retryAfter = 0;
+    std::string reason;
+    assert(dtq::decodeRejection(dtq::encodeRejection(750, "Queue full"), retryAfter, reason));
+    assert(retryAfter == 750 && reason == "Queue full");
+    assert(dtq::decodeRejection(dtq::encodeRejection(0, ""), retryAfter, reason));
+    assert(retryAfter == 0 && reason.empty());
+    assert(!dtq::decodeRejection("ab", retryAfter, reason));
+
+    // Test: Tokens accrue at the current rate, up to 100ms worth.
+    int64_t now = 1000000;
+    dtq::AimdRate rate(1000.0, 10.0, 2000.0, 100.0);
+    assert(rate.available(now) == 1);
+    rate.take(1);
+    assert(rate.available(now + 10000) == 10);
+    assert(rate.available(now + 10000000) == 100);
+    rate.take(100);
+    assert(rate.available(now + 10000000) == 0);
+    assert(rate.nextSendUs() == now + 10000000 + 1000);
+
+    // Test: Accepted tasks raise the rate additively, about increasePerSec per second of them.
+    now += 10000000;
+    rate.onAccepted(1000);
+    assert(rate.perSecond() > 1099.0 && rate.perSecond() < 1101.0);
+
+    // Test: A rejection halves the rate once and pauses sending for the retry-after.
+    rate.onRejected(200, now);
+    assert(rate.perSecond() > 549.0 && rate.perSecond() < 551.0);
+    assert(rate.available(now + 199000) == 0 && rate.nextSendUs() == now + 200000);
+    // More rejections from the same burst do not cut it again
+    rate.onRejected(200, now + 1000);
+    assert(rate.perSecond() > 549.0 && rate.perSecond() < 551.0);
+    // Tokens start accruing when the pause ends
+    assert(rate.available(now + 201000) == 0);
+    assert(rate.available(now + 211000) == 5);
+
+    // Test: Later rejections cut again, but never below the minimum.
+    for (int i = 1; i <= 20; ++i)
+        rate.onRejected(200, now + i * 1000000);
+    assert(rate.perSecond() == 10.0);
+
+    std::cout << "All admission tests passed." << std::endl;
+    return 0;
+}
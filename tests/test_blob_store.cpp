@@ -0,0 +1,133 @@
+#include "BlobStore.h"
+#include "Task.h"
+#include "TaskStore.h"
+#include "TcpServer.h"
+#include "Network.h"
+#include "Logger.h"
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main() {
+    dtq::Logger::getInstance().setMinLevel(dtq::LogLevel::ERR);
+
+    // Test: A stored blob reads back unchanged.
+    dtq::BlobStore blobs("/tmp", 4096);
+    assert(blobs.open());
+    assert(blobs.bytesStored() == 4096);
+    std::string bytes(3000, 'a');
+    bytes[0] = 'x';
+    bytes[2999] = 'y';
+    dtq::BlobRef first = blobs.put(bytes);
+    assert(!first.empty() && first.size == 3000 && first.view() == bytes);
+    assert(blobs.put("").empty());
+
+    // Test: A full segment is sealed for a new one, an oversized blob gets its
+    // own, and segments are freed once their blobs are gone.
+    dtq::BlobRef second = blobs.put(std::string(3000, 'b'));
+    assert(second.segment != first.segment && second.offset == 0);
+    dtq::BlobRef huge = blobs.put(std::string(10000, 'h'));
+    assert(huge.segment->capacity() == 10000 && huge.view() == std::string(10000, 'h'));
+    assert(blobs.bytesStored() == 4096 + 4096 + 10000);
+    first = dtq::BlobRef();
+    huge = dtq::BlobRef();
+    assert(blobs.bytesStored() == 4096); // the segment second is in is still being filled
+    dtq::BlobRef third = blobs.put(std::string(1000, 'c'));
+    assert(third.segment == second.segment && third.offset == 3000);
+    assert(second.view() == std::string(3000, 'b'));
+
+    // Test: A task with a blob payload encodes exactly as with the payload inline.
+    dtq::Task inlined;
+    inlined.taskId = 5;
+    inlined.priority = 1;
+    inlined.payload = std::string(2000, 'p');
+    dtq::Task blobbed = inlined;
+    blobbed.payload.clear();
+    blobbed.payloadBlob = blobs.put(inlined.payload);
+    assert(!blobbed.payloadBlob.empty());
+    assert(blobbed.serialize() == inlined.serialize());
+    dtq::SplicedPayload spliced;
+    blobbed.serializeTo(spliced);
+    assert(spliced.splices.size() == 1 && spliced.bytes.size() < 100);
+    assert(spliced.size() == inlined.serialize().size() && spliced.flatten() == inlined.serialize());
+    dtq::TaskView view;
+    std::string flat = spliced.flatten();
+    assert(dtq::Task::decode(flat, view) && view.taskId == 5 && view.payload == inlined.payload);
+
+    // Test: A spliced batch flattens to the inline batch encoding.
+    dtq::Task small;
+    small.taskId = 6;
+    small.payload = "small";
+    std::vector<dtq::Task> inlineBatch{inlined, small};
+    std::vector<dtq::Task> blobBatch{blobbed, small};
+    dtq::SplicedPayload batch;
+    dtq::Task::serializeBatch(blobBatch, batch);
+    assert(batch.splices.size() == 1);
+    assert(batch.flatten() == dtq::Task::serializeBatch(inlineBatch));
+    std::vector<dtq::TaskView> views;
+    std::string flatBatch = batch.flatten();
+    assert(dtq::Task::decodeBatch(flatBatch, views) && views.size() == 2 && views[1].payload == "small");
+
+    // Test: A result kept in a blob is served as if inline and counts against the store's budget.
+    dtq::TaskStore store(1, 2500);
+    store.markPending(1);
+    store.transition(1, dtq::TaskStatus::IN_PROGRESS);
+    assert(store.transition(1, dtq::TaskStatus::COMPLETED, "", blobs.put(std::string(2000, 'r'))));
+    std::optional<dtq::TaskRecord> record = store.lookup(1);
+    assert(record && record->result.empty() && record->resultBlob.size == 2000);
+    std::string plain;
+    dtq::TaskStore::encodeRecord(plain, 1, record);
+    dtq::SplicedPayload reply;
+    dtq::TaskStore::encodeRecord(reply, 1, record);
+    assert(reply.splices.size() == 1 && reply.flatten() == plain);
+    std::string_view in = plain;
+    int taskId = 0;
+    std::optional<dtq::TaskRecord> decoded;
+    assert(dtq::TaskStore::decodeRecord(in, taskId, decoded) && taskId == 1 && decoded->result == std::string(2000, 'r'));
+    store.markPending(2);
+    store.transition(2, dtq::TaskStatus::IN_PROGRESS);
+    store.transition(2, dtq::TaskStatus::COMPLETED, "", blobs.put(std::string(2000, 's')));
+    assert(!store.lookup(1) && store.lookup(2)); // the older blob result was evicted
+
+    // Test: A spliced reply arrives whole over the server transport.
+    dtq::BlobStore large("/tmp");
+    assert(large.open());
+    std::string big(4 * 1024 * 1024, 'z');
+    big[12345] = 'q';
+    dtq::BlobRef bigBlob = large.put(big);
+    struct Handler : dtq::SessionHandler
+    {
+        dtq::BlobRef blob;
+        void onMessage(const dtq::SessionPtr &session, dtq::MessageType, uint32_t requestId,
+                       std::string &) override
+        {
+            dtq::SplicedPayload out;
+            out.bytes = "head";
+            out.appendBlob(blob);
+            out.bytes += "middle";
+            out.appendBlob(blob);
+            out.bytes += "tail";
+            session->send(dtq::MessageType::SERVER_TASK_RESULT, requestId, std::move(out));
+        }
+    };
+    assert(dtq::Network::initialize());
+    dtq::TcpServer server(0, dtq::TcpServer::defaultMode(), 2);
+    assert(server.start([&bigBlob]() {
+        auto handler = std::make_unique<Handler>();
+        handler->blob = bigBlob;
+        return handler;
+    }));
+    dtq::Network::Client client("127.0.0.1", server.boundPort());
+    assert(client.connect());
+    dtq::Message response;
+    assert(client.call(dtq::MessageType::CLIENT_GET_RESULT, "", response, std::chrono::seconds(10)));
+    assert(response.payload == "head" + big + "middle" + big + "tail");
+    client.disconnect();
+    server.stop();
+    dtq::Network::cleanup();
+
+    std::cout << "All BlobStore tests passed." << std::endl;
+    return 0;
+}
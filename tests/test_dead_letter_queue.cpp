@@ -0,0 +1,64 @@
+#include "DeadLetterQueue.h"
+#include "Config.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+
+static dtq::Task makeTask(int id)
+{
+    dtq::Task task;
+    task.taskId = id;
+    task.status = dtq::TaskStatus::FAILED;
+    task.result = "error " + std::to_string(id);
+    return task;
+}
+
+int main() {
+    // Test: Entries are listed oldest first, and a full queue drops the oldest.
+    dtq::DeadLetterQueue deadLetters(3);
+    assert(deadLetters.add(makeTask(1)));
+    assert(deadLetters.add(makeTask(2)));
+    assert(deadLetters.add(makeTask(3)));
+    assert(!deadLetters.add(makeTask(4)));
+    assert(deadLetters.size() == 3 && deadLetters.dropped() == 1);
+    std::vector<dtq::Task> listed = deadLetters.list(0);
+    assert(listed.size() == 3 && listed[0].taskId == 2 && listed[2].taskId == 4);
+    assert(listed[0].result == "error 2");
+    assert(deadLetters.list(2).size() == 2 && deadLetters.size() == 3);
+
+    // Test: Adding a task already present replaces it and moves it to the back.
+    dtq::Task again = makeTask(2);
+    again.result = "error again";
+    assert(deadLetters.add(std::move(again)));
+    listed = deadLetters.list(0);
+    assert(listed.size() == 3 && listed[2].taskId == 2 && listed[2].result == "error again");
+
+    // Test: Taking a subset returns the present ones in queue order and leaves the rest.
+    std::vector<dtq::Task> taken = deadLetters.take({2, 99, 3});
+    assert(taken.size() == 2 && taken[0].taskId == 3 && taken[1].taskId == 2);
+    assert(deadLetters.size() == 1 && deadLetters.list(0)[0].taskId == 4);
+
+    // Test: An empty id list takes everything.
+    assert(deadLetters.add(makeTask(5)));
+    taken = deadLetters.take({});
+    assert(taken.size() == 2 && taken[0].taskId == 4 && taken[1].taskId == 5);
+    assert(deadLetters.size() == 0 && deadLetters.take({}).empty());
+
+    // Test: Backoff doubles per retry, stays within its jitter range and is capped.
+    int64_t base = dtq::Config::RetryBackoffBase.count();
+    int64_t cap = dtq::Config::RetryBackoffMax.count();
+    assert(dtq::retryBackoffMs(1, 1.0) == base);
+    assert(dtq::retryBackoffMs(1, 0.0) == base - base / 2);
+    assert(dtq::retryBackoffMs(2, 1.0) == 2 * base);
+    assert(dtq::retryBackoffMs(3, 1.0) == 4 * base);
+    for (double jitter : {0.0, 0.25, 0.5, 0.99})
+    {
+        int64_t delay = dtq::retryBackoffMs(2, jitter);
+        assert(delay >= base && delay <= 2 * base);
+    }
+    assert(dtq::retryBackoffMs(64, 1.0) == cap);
+    assert(dtq::retryBackoffMs(1000, 0.0) == cap - cap / 2);
+
+    std::cout << "All DeadLetterQueue tests passed." << std::endl;
+    return 0;
+}
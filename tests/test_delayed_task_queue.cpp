@@ -0,0 +1,56 @@
+#include "DelayedTaskQueue.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+
+static dtq::Task makeTask(int id)
+{
+    dtq::Task task;
+    task.taskId = id;
+    task.payload = "delayed " + std::to_string(id);
+    return task;
+}
+
+int main() {
+    // Test: Tasks are held until due and come back together, earliest first.
+    dtq::DelayedTaskQueue delayed(0, 3);
+    assert(delayed.schedule(makeTask(1), 500));
+    assert(delayed.schedule(makeTask(2), 100));
+    assert(delayed.schedule(makeTask(3), 100));
+    assert(delayed.size() == 3);
+    assert(delayed.takeDue(99).empty());
+    std::vector<dtq::Task> due = delayed.takeDue(100);
+    assert(due.size() == 2 && due[0].taskId != 1 && due[1].taskId != 1);
+    assert(due[0].payload == "delayed " + std::to_string(due[0].taskId));
+    assert(delayed.size() == 1);
+
+    // Test: A full queue rejects the task and leaves it untouched.
+    assert(delayed.schedule(makeTask(4), 200));
+    assert(delayed.schedule(makeTask(5), 300));
+    dtq::Task rejected = makeTask(6);
+    assert(!delayed.schedule(std::move(rejected), 400));
+    assert(rejected.payload == "delayed 6");
+
+    // Test: Freed slots are reused and every held task comes back exactly once.
+    due = delayed.takeDue(10000);
+    assert(due.size() == 3 && due[0].taskId == 4 && due[1].taskId == 5 && due[2].taskId == 1);
+    assert(delayed.size() == 0 && delayed.takeDue(20000).empty());
+
+    // Test: Many delayed tasks spread over a long horizon all come due in order.
+    dtq::DelayedTaskQueue many(0, 200000);
+    for (int i = 0; i < 200000; ++i)
+        assert(many.schedule(makeTask(i), 1 + (i * 7919LL) % 3600000));
+    size_t total = 0;
+    for (int64_t now = 0; now <= 3600000; now += 60000)
+    {
+        for (const dtq::Task &task : many.takeDue(now))
+        {
+            assert(1 + (task.taskId * 7919LL) % 3600000 <= now);
+            ++total;
+        }
+    }
+    assert(total == 200000 && many.size() == 0);
+
+    std::cout << "All DelayedTaskQueue tests passed." << std::endl;
+    return 0;
+}
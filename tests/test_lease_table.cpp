@@ -0,0 +1,123 @@
+#include "LeaseTable.h"
+#include "TimingWheel.h"
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+int main() {
+    // Test: Timers fire on the first advance past their deadline, never before.
+    dtq::TimingWheel wheel(10, 1000);
+    std::vector<uint64_t> fired;
+    dtq::TimingWheel::TimerId a = wheel.schedule(1050, 1);
+    wheel.schedule(1001, 2); // rounds up to the 1010 tick
+    wheel.schedule(500, 3);  // already due: next tick
+    assert(wheel.size() == 3);
+    wheel.advance(1005, fired);
+    assert(fired.empty());
+    wheel.advance(1010, fired);
+    assert(fired.size() == 2 && std::count(fired.begin(), fired.end(), 2) && std::count(fired.begin(), fired.end(), 3));
+    fired.clear();
+
+    // Test: Cancelled and fired timers are gone; their ids go stale.
+    assert(wheel.cancel(a));
+    assert(!wheel.cancel(a));
+    wheel.advance(2000, fired);
+    assert(fired.empty() && wheel.size() == 0);
+    dtq::TimingWheel::TimerId reused = wheel.schedule(2100, 4);
+    assert(reused != a && !wheel.cancel(a));
+
+    // Test: Deadlines spanning several levels cascade down and fire in order.
+    fired.clear();
+    wheel.advance(3000, fired);
+    assert(fired.size() == 1 && fired[0] == 4);
+    std::vector<int64_t> deadlines = {3010, 3000 + 2560, 3000 + 2570, 3000 + 655360, 3000 + 700000, 3000 + 168000000};
+    for (size_t i = 0; i < deadlines.size(); ++i)
+        wheel.schedule(deadlines[i], i);
+    fired.clear();
+    for (int64_t now = 3000; now <= 3000 + 168000000; now += 25000)
+    {
+        size_t before = fired.size();
+        wheel.advance(now, fired);
+        for (size_t i = before; i < fired.size(); ++i)
+            assert(deadlines[fired[i]] <= now && deadlines[fired[i]] > now - 25000 - 10);
+    }
+    assert(fired == std::vector<uint64_t>({0, 1, 2, 3, 4, 5}));
+
+    // Test: Random schedules and cancels match a brute-force reference.
+    std::mt19937 rng(7);
+    dtq::TimingWheel random(1, 0);
+    struct Ref { int64_t deadline; dtq::TimingWheel::TimerId id; bool live; };
+    std::vector<Ref> refs;
+    int64_t now = 0;
+    for (int step = 0; step < 2000; ++step)
+    {
+        int op = rng() % 10;
+        if (op < 6)
+        {
+            int64_t deadline = now + 1 + rng() % (op < 3 ? 300 : 100000);
+            refs.push_back({deadline, random.schedule(deadline, refs.size()), true});
+        }
+        else if (op < 8 && !refs.empty())
+        {
+            Ref &ref = refs[rng() % refs.size()];
+            assert(random.cancel(ref.id) == ref.live);
+            ref.live = false;
+        }
+        else
+        {
+            now += rng() % 5000;
+            std::vector<uint64_t> expired;
+            random.advance(now, expired);
+            for (uint64_t key : expired)
+            {
+                assert(refs[key].live && refs[key].deadline <= now);
+                refs[key].live = false;
+            }
+            for (const Ref &ref : refs)
+                assert(!ref.live || ref.deadline > now);
+        }
+    }
+
+    // Test: A lease expires unless its result releases it first.
+    dtq::LeaseTable leases(std::chrono::milliseconds(1000), 0);
+    dtq::Task first;
+    first.taskId = 1;
+    first.payload = "one";
+    dtq::Task second = first;
+    second.taskId = 2;
+    leases.grant(first, 0);
+    leases.grant(second, 500);
+    assert(leases.size() == 2);
+    assert(leases.release(2));
+    assert(!leases.release(2));
+    assert(leases.expire(999).empty());
+    std::vector<dtq::Task> expired = leases.expire(1000);
+    assert(expired.size() == 1 && expired[0].taskId == 1 && expired[0].payload == "one");
+    assert(leases.size() == 0 && !leases.release(1));
+
+    // Test: Granting again restarts the lease.
+    leases.grant(first, 2000);
+    leases.grant(first, 2800);
+    assert(leases.expire(3500).empty());
+    assert(leases.expire(3800).size() == 1);
+
+    // Test: Revoking ends the lease early and hands back the task.
+    leases.grant(first, 4000);
+    std::optional<dtq::Task> revoked = leases.revoke(1);
+    assert(revoked && revoked->taskId == 1 && revoked->payload == "one");
+    assert(!leases.revoke(1) && !leases.release(1));
+    assert(leases.expire(10000).empty() && leases.size() == 0);
+
+    // Test: Only the holder's revoke ends a lease; a regrant moves it to the new holder.
+    leases.grant(first, 11000, 7);
+    assert(!leases.revoke(1, 8) && leases.size() == 1);
+    leases.grant(first, 11500, 8);
+    assert(!leases.revoke(1, 7));
+    revoked = leases.revoke(1, 8);
+    assert(revoked && revoked->taskId == 1 && leases.size() == 0);
+
+    std::cout << "All LeaseTable tests passed." << std::endl;
+    return 0;
+}
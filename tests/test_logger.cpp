@@ -0,0 +1,79 @@
+#include "Logger.h"
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int evaluated = 0;
+
+static std::string expensive()
+{
+    ++evaluated;
+    return "expensive";
+}
+
+static int countLines(const std::string &text, const std::string &needle)
+{
+    int count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        ++count;
+    return count;
+}
+
+int main() {
+    dtq::Logger &logger = dtq::Logger::getInstance();
+    std::ostringstream captured;
+    std::streambuf *original = std::cout.rdbuf(captured.rdbuf());
+
+    // Test: Records below the minimum level are dropped; DTQ_LOG skips building them.
+    logger.setMinLevel(dtq::LogLevel::WARN);
+    logger.log(dtq::LogLevel::INFO, "hidden");
+    DTQ_LOG(INFO, expensive());
+    DTQ_LOG(WARN, "shown " + expensive());
+    assert(evaluated == 1);
+    assert(captured.str().find("hidden") == std::string::npos);
+    assert(captured.str().find("[WARN] shown expensive\n") != std::string::npos);
+    logger.setMinLevel(dtq::LogLevel::INFO);
+
+    // Test: In async mode every record is written, in order per thread, by flush().
+    captured.str("");
+    logger.setAsync(true);
+    const int threads = 4;
+    const int perThread = 500;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t)
+    {
+        producers.emplace_back([&logger, t]() {
+            for (int i = 0; i < perThread; ++i)
+                logger.log(dtq::LogLevel::INFO, "t" + std::to_string(t) + " #" + std::to_string(i));
+        });
+    }
+    for (auto &producer : producers)
+        producer.join();
+    logger.flush();
+    std::string out = captured.str();
+    assert(countLines(out, "[INFO] t") == threads * perThread);
+    for (int t = 0; t < threads; ++t)
+    {
+        size_t last = 0;
+        for (int i = 0; i < perThread; ++i)
+        {
+            size_t pos = out.find("] t" + std::to_string(t) + " #" + std::to_string(i) + "\n");
+            assert(pos != std::string::npos && pos >= last);
+            last = pos;
+        }
+    }
+
+    // Test: Switching back to sync drains the queue before later records.
+    logger.log(dtq::LogLevel::ERR, "queued last");
+    logger.setAsync(false);
+    logger.log(dtq::LogLevel::ERR, "written directly");
+    out = captured.str();
+    assert(out.find("[ERROR] queued last") < out.find("[ERROR] written directly"));
+
+    std::cout.rdbuf(original);
+    std::cout << "All Logger tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "Histogram.h"
+#include "Metrics.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    // Test: Small values are exact; larger ones land within ~3% above.
+    for (uint64_t v : {0ULL, 1ULL, 31ULL, 32ULL, 63ULL})
+        assert(dtq::Histogram::upperBound(dtq::Histogram::bucketFor(v)) == v);
+    for (uint64_t v = 64; v < (1ULL << 36); v = v * 3 + 7)
+    {
+        uint64_t bound = dtq::Histogram::upperBound(dtq::Histogram::bucketFor(v));
+        assert(bound >= v && bound - v <= v / 32);
+    }
+    assert(dtq::Histogram::bucketFor(1ULL << 50) == dtq::Histogram::kBuckets - 1);
+
+    // Test: Percentiles of 1..10000 match within bucket precision.
+    dtq::Histogram histogram;
+    for (int v = 1; v <= 10000; ++v)
+        histogram.record(v);
+    dtq::Histogram::Snapshot snap = histogram.snapshot();
+    assert(snap.total == 10000);
+    assert(snap.percentile(50) >= 5000 && snap.percentile(50) <= 5000 + 5000 / 32);
+    assert(snap.percentile(99) >= 9900 && snap.percentile(99) <= 9900 + 9900 / 32);
+    assert(snap.percentile(100) == snap.max() && snap.max() >= 10000);
+    assert(snap.mean() > 5000 && snap.mean() < 5001);
+
+    // Test: since() isolates what was recorded after an earlier snapshot; merge() adds.
+    for (int i = 0; i < 100; ++i)
+        histogram.record(1000000);
+    dtq::Histogram::Snapshot recent = histogram.snapshot().since(snap);
+    assert(recent.total == 100 && recent.percentile(50) >= 1000000 && recent.percentile(50) <= 1031250);
+    recent.merge(snap);
+    assert(recent.total == 10100);
+
+    // Test: Concurrent records are all counted.
+    dtq::Histogram shared;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&shared]() {
+            for (int i = 0; i < 10000; ++i)
+                shared.record(i);
+        });
+    for (auto &thread : threads)
+        thread.join();
+    assert(shared.snapshot().total == 40000);
+
+    // Test: The throughput window averages whole seconds and forgets old ones.
+    const int64_t second = 1000000;
+    int64_t start = 1000 * second;
+    dtq::ThroughputWindow window(4, start);
+    assert(window.perSecond(start) == 0.0);
+    window.add(10, start);
+    window.add(30, start + second);
+    assert(window.perSecond(start + 2 * second) == 20.0); // two complete seconds so far
+    window.add(5, start + 2 * second + 1);
+    assert(window.perSecond(start + 6 * second) == 5.0 / 4); // only second 2 is still in the window
+    window.add(7, start + 66 * second);                          // same slot as second 2, a lap later
+    assert(window.perSecond(start + 67 * second) == 7.0 / 4);
+
+    // Test: Each stage is recorded only when both of its stamps are set and ordered.
+    dtq::LifecycleMetrics lifecycle;
+    dtq::TaskTrace trace;
+    trace.submittedUs = 100;
+    trace.enqueuedUs = 150;
+    trace.assignedUs = 400;
+    trace.receivedUs = 0; // worker that predates tracing
+    trace.completedUs = 0;
+    lifecycle.recordCompletion(trace, 1100);
+    assert(lifecycle.snapshot(dtq::Stage::Submit).percentile(50) == 50);
+    assert(lifecycle.snapshot(dtq::Stage::Queue).total == 1);
+    assert(lifecycle.snapshot(dtq::Stage::Dispatch).total == 0);
+    assert(lifecycle.snapshot(dtq::Stage::Execute).total == 0);
+    assert(lifecycle.snapshot(dtq::Stage::EndToEnd).total == 1);
+    trace.enqueuedUs = 50; // another host's clock
+    lifecycle.recordCompletion(trace, 1200);
+    assert(lifecycle.snapshot(dtq::Stage::Submit).total == 1);
+
+    // Test: Striped counters sum every thread's adds.
+    dtq::Counter counter;
+    std::vector<std::thread> adders;
+    for (int t = 0; t < 8; ++t)
+        adders.emplace_back([&counter]() {
+            for (int i = 0; i < 1000; ++i)
+                counter.add();
+        });
+    for (auto &adder : adders)
+        adder.join();
+    counter.add(5);
+    assert(counter.value() == 8005);
+
+    // Test: Stats snapshots survive the SERVER_STATS encoding.
+    dtq::StatsSnapshot stats;
+    stats.queueDepth = 7;
+    stats.queueBytes = 1400;
+    stats.blobBytes = 1 << 20;
+    stats.delayed = 4;
+    stats.retried = 6;
+    stats.deadLetters = 2;
+    stats.shed = 5;
+    stats.inFlight = 2;
+    stats.accepted = 100;
+    stats.rejected = 3;
+    stats.completed = 90;
+    stats.failed = 1;
+    stats.tasksPerSec = 12.5;
+    stats.shardDepths = {4, 3};
+    stats.setStage(dtq::Stage::Queue, lifecycle.snapshot(dtq::Stage::Queue));
+    stats.workers.push_back({42, 90, 12.5});
+    std::string encoded;
+    stats.encode(encoded);
+    dtq::StatsSnapshot decoded;
+    assert(dtq::StatsSnapshot::decode(encoded, decoded));
+    assert(decoded.queueDepth == 7 && decoded.inFlight == 2 && decoded.accepted == 100 && decoded.rejected == 3);
+    assert(decoded.completed == 90 && decoded.failed == 1 && decoded.tasksPerSec == 12.5);
+    assert(decoded.shardDepths.size() == 2 && decoded.shardDepths[1] == 3 && decoded.delayed == 4);
+    assert(decoded.retried == 6 && decoded.deadLetters == 2 && decoded.shed == 5 && decoded.queueBytes == 1400);
+    assert(decoded.blobBytes == 1 << 20);
+    const dtq::StatsSnapshot::StageStats &queue = decoded.stages[static_cast<size_t>(dtq::Stage::Queue)];
+    assert(queue.count == 2 && queue.p50 > 0);
+    assert(decoded.workers.size() == 1 && decoded.workers[0].sessionId == 42 && decoded.workers[0].completed == 90);
+    assert(!dtq::StatsSnapshot::decode(encoded.substr(0, encoded.size() - 1), decoded));
+
+    // Test: The metrics endpoint renders Prometheus text.
+    std::string text = stats.toPrometheus();
+    assert(text.find("# TYPE dtq_queue_depth gauge\ndtq_queue_depth 7\n") != std::string::npos);
+    assert(text.find("dtq_queue_shard_depth{shard=\"1\"} 3\n") != std::string::npos);
+    assert(text.find("dtq_tasks_accepted_total 100\n") != std::string::npos);
+    assert(text.find("dtq_delayed_tasks 4\n") != std::string::npos);
+    assert(text.find("dtq_dead_letter_tasks 2\n") != std::string::npos);
+    assert(text.find("dtq_tasks_shed_total 5\n") != std::string::npos);
+    assert(text.find("dtq_queue_bytes 1400\n") != std::string::npos);
+    assert(text.find("dtq_queue_bytes_per_task 200\n") != std::string::npos);
+    assert(text.find("dtq_blob_bytes 1048576\n") != std::string::npos);
+    assert(text.find("dtq_stage_latency_seconds_count{stage=\"queue\"} 2\n") != std::string::npos);
+    assert(text.find("dtq_worker_tasks_per_second{session=\"42\"} 12.5\n") != std::string::npos);
+
+    std::cout << "All Metrics tests passed." << std::endl;
+    return 0;
+}
@@ -1,7 +1,46 @@
 #include "Network.h"
+#include "Config.h"
 #include "Logger.h"
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// Both ends of a loopback TCP connection
+static bool openLoopback(SOCKET &a, SOCKET &b) {
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+#ifdef _WIN32
+    int len = sizeof(addr);
+#else
+    socklen_t len = sizeof(addr);
+#endif
+    a = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    bool ok = bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 && listen(listener, 1) == 0 &&
+              getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len) == 0 &&
+              connect(a, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    b = ok ? accept(listener, nullptr, nullptr) : INVALID_SOCKET;
+    dtq::Network::closeSocket(listener);
+    return b != INVALID_SOCKET;
+}
+
+static std::string frame(dtq::MessageType type, uint32_t requestId, int32_t size, const std::string &payload) {
+    dtq::FrameHeader header{static_cast<int32_t>(type), requestId, size};
+    return std::string(reinterpret_cast<const char *>(&header), sizeof(header)) + payload;
+}
 
 int main() {
     // Test network initialization.
@@ -14,9 +53,72 @@ int main() {
     bool connectSuccess = conn.connect();
     // Since no server is running on this port, we expect connect() to return false.
     assert(!connectSuccess);
-    
-    std::cout << "Network tests passed. Error (as expected): " << conn.getLastError() << std::endl;
-    
+    std::cout << "Connect error (as expected): " << conn.getLastError() << std::endl;
+
+    // Test: A frame goes out in one socket call, and frames that arrive
+    // together are parsed from one recv().
+    SOCKET a, b;
+    assert(openLoopback(a, b));
+    {
+        dtq::Network::Connection sender(a);
+        dtq::Network::Connection receiver(b);
+        assert(sender.sendMessage(dtq::MessageType::CLIENT_ADD_TASK, 1, std::string(1000, 'x')));
+        assert(sender.sendMessage(dtq::MessageType::CLIENT_GET_STATS, 2, ""));
+        assert(sender.sendMessage(dtq::MessageType::CLIENT_GET_RESULT, 3, "abc"));
+        assert(sender.sendCalls() == 3);
+        dtq::MessageType type;
+        uint32_t requestId = 0;
+        std::string payload;
+        assert(receiver.receiveMessage(type, requestId, payload));
+        assert(type == dtq::MessageType::CLIENT_ADD_TASK && requestId == 1 && payload == std::string(1000, 'x'));
+        assert(receiver.receiveMessage(type, requestId, payload));
+        assert(type == dtq::MessageType::CLIENT_GET_STATS && requestId == 2 && payload.empty());
+        assert(receiver.receiveMessage(type, requestId, payload));
+        assert(type == dtq::MessageType::CLIENT_GET_RESULT && requestId == 3 && payload == "abc");
+        assert(receiver.recvCalls() == 1);
+
+        // Test: A body larger than the receive buffer arrives whole, as do the frames around it.
+        std::string big(3 * dtq::Network::Connection::kReceiveBufferBytes + 7, 'b');
+        big[12345] = 'q';
+        std::thread bigSender([&sender, &big]() {
+            sender.sendMessage(dtq::MessageType::SERVER_ASSIGN_TASK, 4, "before");
+            sender.sendMessage(dtq::MessageType::SERVER_ASSIGN_TASK, 5, big);
+            sender.sendMessage(dtq::MessageType::SERVER_ASSIGN_TASK, 6, "after");
+        });
+        assert(receiver.receiveMessage(type, requestId, payload) && requestId == 4 && payload == "before");
+        assert(receiver.receiveMessage(type, requestId, payload) && requestId == 5 && payload == big);
+        assert(receiver.receiveMessage(type, requestId, payload) && requestId == 6 && payload == "after");
+        bigSender.join();
+    }
+
+    // Test: A frame size over Config::MaxFrameBytes, or negative, is refused without allocating it.
+    for (int32_t bogus : {static_cast<int32_t>(dtq::Config::MaxFrameBytes + 1), -5}) {
+        assert(openLoopback(a, b));
+        dtq::Network::Connection receiver(b);
+        std::string bytes = frame(dtq::MessageType::CLIENT_ADD_TASK, 1, bogus, "");
+        assert(send(a, bytes.data(), static_cast<int>(bytes.size()), 0) == static_cast<int>(bytes.size()));
+        dtq::MessageType type;
+        uint32_t requestId = 0;
+        std::string payload;
+        assert(!receiver.receiveMessage(type, requestId, payload));
+        assert(receiver.getLastError().find("out of bounds") != std::string::npos && payload.capacity() < 1024);
+        dtq::Network::closeSocket(a);
+    }
+
+    // Test: A peer closing mid-frame fails the receive.
+    assert(openLoopback(a, b));
+    {
+        dtq::Network::Connection receiver(b);
+        std::string partial = frame(dtq::MessageType::CLIENT_ADD_TASK, 1, 100, "only part");
+        assert(send(a, partial.data(), static_cast<int>(partial.size()), 0) == static_cast<int>(partial.size()));
+        dtq::Network::closeSocket(a);
+        dtq::MessageType type;
+        std::string payload;
+        assert(!receiver.receiveMessage(type, payload));
+    }
+
+    std::cout << "Network tests passed." << std::endl;
+
     dtq::Network::cleanup();
     return 0;
 }
@@ -0,0 +1,94 @@
+#include "PollRegistry.h"
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A stand-in ready queue the registry takes tasks from
+static std::mutex readyMutex;
+static std::vector<dtq::Task> ready;
+
+static void addReady(int taskId) {
+    dtq::Task task;
+    task.taskId = taskId;
+    std::lock_guard<std::mutex> lock(readyMutex);
+    ready.push_back(task);
+}
+
+static std::vector<dtq::Task> takeReady(size_t, size_t n) {
+    std::lock_guard<std::mutex> lock(readyMutex);
+    size_t count = std::min(n, ready.size());
+    std::vector<dtq::Task> taken(ready.begin(), ready.begin() + static_cast<std::ptrdiff_t>(count));
+    ready.erase(ready.begin(), ready.begin() + static_cast<std::ptrdiff_t>(count));
+    return taken;
+}
+
+int main() {
+    dtq::PollRegistry registry(takeReady);
+    registry.start();
+
+    // Test: A poll is served at once, without parking, when tasks are ready.
+    addReady(1);
+    addReady(2);
+    addReady(3);
+    std::vector<dtq::Task> served;
+    dtq::PollRegistry::PollId id = registry.park(0, 2, std::chrono::milliseconds(1000),
+                                                 [&](std::vector<dtq::Task> &&tasks) { served = std::move(tasks); });
+    assert(id == 0 && registry.parkedCount() == 0);
+    assert(served.size() == 2 && served[0].taskId == 1 && served[1].taskId == 2);
+    assert(takeReady(0, 8).size() == 1);
+
+    // Test: A poll nothing arrives for is answered with an empty batch once it times out.
+    std::promise<size_t> timedOut;
+    auto start = std::chrono::steady_clock::now();
+    id = registry.park(0, 4, std::chrono::milliseconds(50),
+                       [&](std::vector<dtq::Task> &&tasks) { timedOut.set_value(tasks.size()); });
+    assert(id != 0 && registry.parkedCount() == 1);
+    std::future<size_t> timeout = timedOut.get_future();
+    assert(timeout.wait_for(std::chrono::seconds(5)) == std::future_status::ready && timeout.get() == 0);
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+    assert(registry.parkedCount() == 0);
+
+    // Test: A cancelled poll is never answered, not even by its timeout.
+    bool answered = false;
+    id = registry.park(0, 1, std::chrono::milliseconds(30), [&](std::vector<dtq::Task> &&) { answered = true; });
+    assert(id != 0);
+    registry.cancel(id);
+    assert(registry.parkedCount() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    addReady(4);
+    registry.onTasksAvailable();
+    assert(!answered);
+    assert(takeReady(0, 8).size() == 1);
+
+    // Test: onTasksAvailable wakes parked polls first come, first served.
+    std::vector<int> order;
+    for (int poll = 1; poll <= 3; ++poll) {
+        id = registry.park(0, 1, std::chrono::milliseconds(5000), [&order, poll](std::vector<dtq::Task> &&tasks) {
+            assert(tasks.size() == 1);
+            order.push_back(poll * 100 + tasks[0].taskId);
+        });
+        assert(id != 0);
+    }
+    assert(registry.parkedCount() == 3);
+    addReady(5);
+    addReady(6);
+    registry.onTasksAvailable();
+    assert(order == std::vector<int>({105, 206}) && registry.parkedCount() == 1);
+    addReady(7);
+    registry.onTasksAvailable();
+    assert(order == std::vector<int>({105, 206, 307}) && registry.parkedCount() == 0);
+
+    // Test: stop() answers every parked poll with an empty batch.
+    size_t emptied = 1;
+    registry.park(0, 1, std::chrono::milliseconds(5000), [&](std::vector<dtq::Task> &&tasks) { emptied = tasks.size(); });
+    registry.stop();
+    assert(emptied == 0 && registry.parkedCount() == 0);
+
+    std::cout << "All PollRegistry tests passed." << std::endl;
+    return 0;
+}
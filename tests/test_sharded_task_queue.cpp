@@ -0,0 +1,54 @@
+#include "ShardedTaskQueue.h"
+#include "Config.h"
+#include "Logger.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+
+int main() {
+    dtq::Logger::getInstance().setMinLevel(dtq::LogLevel::WARN);
+
+    dtq::ShardedTaskQueue queue(4);
+    assert(queue.shardCount() == 4);
+    assert(queue.shardFor(6) == 2);
+    assert(queue.size() == 0);
+
+    dtq::Task task;
+    task.payload = "Test payload";
+
+    // Test: tasks land on their home shard and come back FIFO from it.
+    for (int i = 1; i <= 3; ++i) {
+        task.taskId = i;
+        assert(queue.enqueue(1, task));
+    }
+    std::vector<size_t> depths = queue.shardDepths();
+    assert(depths.size() == 4 && depths[0] == 0 && depths[1] == 3);
+    auto first = queue.dequeue(1);
+    assert(first.has_value() && first->taskId == 1);
+
+    // Test: an empty home shard steals a batch from a sibling.
+    std::vector<dtq::Task> stolen = queue.dequeueBulk(3, 8);
+    assert(stolen.size() == 2 && stolen[0].taskId == 2 && stolen[1].taskId == 3);
+    assert(queue.size() == 0);
+    assert(queue.dequeueBulk(0, 8).empty());
+
+    // Test: a full home shard spills to siblings; the total respects MaxQueueSize.
+    std::vector<dtq::Task> flood(dtq::Config::MaxQueueSize + 10, task);
+    assert(queue.enqueueBulk(2, std::move(flood)) == static_cast<size_t>(dtq::Config::MaxQueueSize));
+    assert(queue.size() == static_cast<size_t>(dtq::Config::MaxQueueSize));
+    assert(!queue.enqueue(0, task));
+
+    // Test: a delayed task (held PENDING) that comes due and is turned away
+    // by the full queue stays PENDING, as the promoter keeps it for later.
+    dtq::Task due = task;
+    due.taskId = 9000;
+    queue.store().markPending(due.taskId);
+    std::vector<dtq::Task> promoted(1, due);
+    assert(queue.enqueueBulk(1, std::move(promoted)) == 0);
+    std::optional<dtq::TaskRecord> held = queue.store().lookup(due.taskId);
+    assert(held && held->status == dtq::TaskStatus::PENDING);
+    assert(queue.dequeueBulk(2, dtq::Config::MaxQueueSize).size() == static_cast<size_t>(dtq::Config::MaxQueueSize));
+
+    std::cout << "All ShardedTaskQueue tests passed." << std::endl;
+    return 0;
+}
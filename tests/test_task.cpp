@@ -0,0 +1,90 @@
+#include "Task.h"
+#include "Wire.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+
+int main() {
+    dtq::Task task;
+    task.taskId = 42;
+    task.payload = "a|b|c";
+    task.status = dtq::TaskStatus::COMPLETED;
+    task.result = "done";
+    task.retryCount = 2;
+    task.enqueueTimeMs = 1234567890123LL;
+    task.priority = 2;
+    task.deadlineMs = 1234567899999LL;
+    task.trace.submittedUs = 10;
+    task.trace.enqueuedUs = 20;
+    task.trace.completedUs = 50;
+    task.notBeforeMs = 1234567900000LL;
+
+    // Test: Binary round trip keeps a payload containing the text delimiter.
+    std::string binary = task.serialize();
+    assert(static_cast<unsigned char>(binary[0]) == static_cast<unsigned char>(dtq::WireFormat::Binary));
+    dtq::Task decoded = dtq::Task::deserialize(binary);
+    assert(decoded.taskId == 42);
+    assert(decoded.payload == "a|b|c");
+    assert(decoded.status == dtq::TaskStatus::COMPLETED);
+    assert(decoded.result == "done");
+    assert(decoded.retryCount == 2);
+    assert(decoded.enqueueTimeMs == 1234567890123LL);
+    assert(decoded.priority == 2 && decoded.deadlineMs == 1234567899999LL);
+    assert(decoded.trace.submittedUs == 10 && decoded.trace.enqueuedUs == 20 && decoded.trace.assignedUs == 0 &&
+           decoded.trace.completedUs == 50);
+    assert(decoded.notBeforeMs == 1234567900000LL);
+
+    // Test: The zero-copy view points into the source buffer.
+    dtq::TaskView view;
+    assert(dtq::Task::decode(binary, view));
+    assert(view.payload.data() >= binary.data() && view.payload.data() < binary.data() + binary.size());
+    assert(view.result == "done");
+
+    // Test: Text format stays available behind its version byte.
+    task.payload = "Process Data XYZ";
+    std::string text = task.serialize(dtq::WireFormat::Text);
+    assert(text[0] == static_cast<char>(dtq::WireFormat::Text));
+    decoded = dtq::Task::deserialize(text);
+    assert(decoded.taskId == 42 && decoded.payload == "Process Data XYZ" && decoded.retryCount == 2);
+
+    // Test: Unversioned legacy text is still understood.
+    decoded = dtq::Task::deserialize("7|legacy|0||0|99");
+    assert(decoded.taskId == 7 && decoded.payload == "legacy" && decoded.enqueueTimeMs == 99);
+
+    // Test: A binary header without the priority/deadline fields still decodes.
+    std::string base;
+    dtq::wire::putU8(base, static_cast<uint8_t>(dtq::WireFormat::Binary));
+    dtq::wire::putU8(base, 0);
+    dtq::wire::putU16(base, 28);
+    dtq::wire::putI32(base, 5);
+    dtq::wire::putI32(base, 0);
+    dtq::wire::putI64(base, 77);
+    dtq::wire::putU32(base, 0);
+    dtq::wire::putU32(base, 3);
+    base += "old";
+    decoded = dtq::Task::deserialize(base);
+    assert(decoded.taskId == 5 && decoded.payload == "old" && decoded.priority == 0 && decoded.deadlineMs == 0);
+    assert(decoded.trace.submittedUs == 0 && decoded.notBeforeMs == 0);
+
+    // Test: Truncated input is rejected instead of read past the end.
+    assert(!dtq::Task::decode(std::string_view(binary.data(), binary.size() - 1), view));
+    assert(!dtq::Task::decode("", view));
+
+    // Test: Batches round trip with per-task framing.
+    std::vector<dtq::Task> batch(2, task);
+    batch[1].taskId = 43;
+    batch[1].payload = "";
+    std::string encoded = dtq::Task::serializeBatch(batch);
+    std::vector<dtq::TaskView> views;
+    assert(dtq::Task::decodeBatch(encoded, views));
+    assert(views.size() == 2 && views[0].taskId == 42 && views[1].taskId == 43 && views[1].payload.empty());
+    views.clear();
+    assert(dtq::Task::decodeBatch(dtq::Task::serializeBatch({}), views) && views.empty());
+    assert(!dtq::Task::decodeBatch(encoded.substr(0, encoded.size() - 1), views));
+    // A count larger than the body can hold is refused without reserving for it
+    std::vector<dtq::TaskView> none;
+    assert(!dtq::Task::decodeBatch(std::string(4, '\xff'), none) && none.capacity() == 0);
+
+    std::cout << "All Task tests passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "TaskPool.h"
+#include "MapNodeCache.h"
+#include "LeaseTable.h"
+#include "TaskQueue.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+int main() {
+    // Test: A released task comes back with default fields but its buffers kept.
+    dtq::TaskPool pool(64);
+    dtq::Task task = pool.acquire();
+    assert(pool.created() == 1 && pool.reused() == 0);
+    task.taskId = 7;
+    task.payload.assign(1000, 'p');
+    task.result = std::string(300, 'r');
+    task.status = dtq::TaskStatus::COMPLETED;
+    task.retryCount = 2;
+    const char *payloadBuffer = task.payload.data();
+    pool.release(std::move(task));
+    assert(pool.idle() == 1);
+    dtq::Task reused = pool.acquire();
+    assert(pool.reused() == 1 && pool.idle() == 0);
+    assert(reused.taskId == 0 && reused.payload.empty() && reused.result.empty());
+    assert(reused.status == dtq::TaskStatus::PENDING && reused.retryCount == 0);
+    assert(reused.payload.capacity() >= 1000 && reused.payload.data() == payloadBuffer);
+
+    // Test: Decoding into a pooled task matches Task::fromView and reuses the buffer.
+    dtq::Task original;
+    original.taskId = 42;
+    original.payload = "compute";
+    original.priority = 2;
+    original.notBeforeMs = 123;
+    std::string encoded = original.serialize();
+    dtq::TaskView view;
+    assert(dtq::Task::decode(encoded, view));
+    pool.release(std::move(reused));
+    dtq::Task decoded = pool.acquire(view);
+    assert(decoded.taskId == 42 && decoded.payload == "compute" && decoded.priority == 2 && decoded.notBeforeMs == 123);
+    assert(decoded.payload.data() == payloadBuffer);
+
+    // Test: Oversized buffers are freed, and the pool keeps no more than its capacity.
+    dtq::Task big;
+    big.payload.assign(dtq::TaskPool::kMaxRetainedBytes + 1, 'b');
+    pool.release(std::move(big));
+    assert(pool.idle() == 0);
+    dtq::TaskPool small(32);
+    for (int i = 0; i < 100; ++i)
+        small.release(dtq::Task());
+    assert(small.idle() == 32);
+
+    // Test: A task released on one thread is reused by another.
+    dtq::TaskPool shared(64);
+    std::thread releaser([&shared]() {
+        dtq::Task task;
+        task.payload.assign(200, 's');
+        shared.release(std::move(task));
+    });
+    releaser.join();
+    dtq::Task fromOtherThread = shared.acquire();
+    assert(shared.reused() == 1 && fromOtherThread.payload.capacity() >= 200);
+
+    // Test: Erased map nodes are reused by later inserts, up to the cache capacity.
+    std::unordered_map<int, std::string> map;
+    dtq::MapNodeCache<std::unordered_map<int, std::string>> spare(1);
+    map[1] = std::string(100, 'a');
+    map[2] = "b";
+    spare.erase(map, map.find(1));
+    spare.erase(map, map.find(2));
+    assert(map.empty() && spare.size() == 1);
+    auto found = spare.findOrInsert(map, 3);
+    assert(found.second && found.first->first == 3 && spare.size() == 0);
+    assert(found.first->second.size() == 100); // old mapped value left for the caller
+    found = spare.findOrInsert(map, 3);
+    assert(!found.second && map.size() == 1);
+    found = spare.findOrInsert(map, 4);
+    assert(found.second && found.first->second.empty() && map.size() == 2);
+
+    // Test: A lease granted from an rvalue holds the task without a copy and hands it back on revoke.
+    dtq::LeaseTable leases(std::chrono::milliseconds(100), 0);
+    dtq::Task leased;
+    leased.taskId = 9;
+    leased.payload.assign(500, 'x');
+    const char *leasedBuffer = leased.payload.data();
+    leases.grant(std::move(leased), 0);
+    std::optional<dtq::Task> back = leases.revoke(9);
+    assert(back && back->payload.data() == leasedBuffer);
+    assert(!leases.revoke(9) && leases.size() == 0);
+    // A new lease after the old one ended reuses its node and starts fresh
+    dtq::Task again;
+    again.taskId = 10;
+    leases.grant(std::move(again), 0);
+    assert(leases.expire(50).empty());
+    std::vector<dtq::Task> expired = leases.expire(200);
+    assert(expired.size() == 1 && expired[0].taskId == 10);
+
+    // Test: The queue reports the memory its tasks take.
+    dtq::TaskQueue queue;
+    dtq::Task queued;
+    queued.taskId = 1;
+    queued.payload.assign(100, 'q');
+    assert(queue.bytesQueued() == 0);
+    assert(queue.enqueue(queued));
+    assert(queue.bytesQueued() == sizeof(dtq::Task) + 100);
+    queue.dequeue();
+    assert(queue.bytesQueued() == 0);
+
+    std::cout << "All TaskPool tests passed." << std::endl;
+    return 0;
+}
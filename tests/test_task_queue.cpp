@@ -1,8 +1,13 @@
 #include "TaskQueue.h"
 #include "Task.h"
 #include "Logger.h"
+#include "Config.h"
 #include <iostream>
+#include <atomic>
 #include <cassert>
+#include <thread>
+#include <chrono>
+#include <vector>
 
 int main() {
     // Create a TaskQueue instance.
@@ -33,6 +38,171 @@ int main() {
     bool updateSuccess = queue.updateTaskResult(task.taskId, "Test result", dtq::TaskStatus::COMPLETED);
     assert(updateSuccess);
 
+    // Test: Bulk enqueue/dequeue preserve FIFO order.
+    while (queue.dequeue().has_value()) {}
+    std::vector<dtq::Task> batch(3, task);
+    for (int i = 0; i < 3; ++i) batch[i].taskId = 10 + i;
+    assert(queue.enqueueBulk(batch) == 3);
+    assert(queue.size() == 3);
+    std::vector<dtq::Task> drained = queue.dequeueBulk(2);
+    assert(drained.size() == 2 && drained[0].taskId == 10 && drained[1].taskId == 11);
+    drained = queue.dequeueBulk(8);
+    assert(drained.size() == 1 && drained[0].taskId == 12);
+    assert(queue.dequeueBulk(8).empty());
+
+    // Test: dequeueFor times out on an empty queue and returns a queued task.
+    assert(!queue.dequeueFor(std::chrono::milliseconds(20)).has_value());
+    queue.enqueue(task);
+    auto polled = queue.dequeueFor(std::chrono::milliseconds(20));
+    assert(polled.has_value() && polled->taskId == task.taskId);
+
+    // Test: the lock-free ring backend keeps FIFO order, bulk prefixes and
+    // the capacity limit, and loses nothing under concurrent use.
+    dtq::TaskQueue ringQueue(dtq::QueueBackend::LockFreeRing);
+    assert(ringQueue.backend() == dtq::QueueBackend::LockFreeRing);
+    assert(!ringQueue.dequeue().has_value());
+    assert(ringQueue.enqueueBulk(batch) == 3);
+    assert(ringQueue.dequeue()->taskId == 10);
+    drained = ringQueue.dequeueBulk(8);
+    assert(drained.size() == 2 && drained[0].taskId == 11 && drained[1].taskId == 12);
+    assert(!ringQueue.dequeueFor(std::chrono::milliseconds(20)).has_value());
+
+    std::vector<dtq::Task> overflow(dtq::Config::MaxQueueSize + 5, task);
+    assert(ringQueue.enqueueBulk(std::move(overflow)) == static_cast<size_t>(dtq::Config::MaxQueueSize));
+    assert(!ringQueue.enqueue(task));
+    assert(ringQueue.dequeueBulk(dtq::Config::MaxQueueSize + 5).size() == static_cast<size_t>(dtq::Config::MaxQueueSize));
+
+    dtq::Logger::getInstance().setMinLevel(dtq::LogLevel::ERR);
+    const int perProducer = 5000;
+    std::atomic<long long> idSum{0};
+    std::atomic<int> received{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&, p]() {
+            dtq::Task t;
+            for (int i = 1; i <= perProducer; ++i) {
+                t.taskId = p * perProducer + i;
+                while (!ringQueue.enqueue(t)) std::this_thread::yield();
+            }
+        });
+        threads.emplace_back([&]() {
+            while (received.load() < 2 * perProducer) {
+                auto t = ringQueue.dequeueFor(std::chrono::milliseconds(5));
+                if (t) { idSum += t->taskId; ++received; }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    long long n = 2 * perProducer;
+    assert(received.load() == n && idSum.load() == n * (n + 1) / 2);
+    assert(ringQueue.size() == 0);
+
+    // Test: PriorityScheduler runs higher levels first, earliest deadline
+    // first within a level, and ages waiting tasks up a level.
+    dtq::PriorityScheduler scheduler(3, 1000, 60000);
+    dtq::Task p;
+    p.taskId = 1; p.priority = 0; scheduler.push(p, 0);
+    p.taskId = 2; p.priority = 2; p.deadlineMs = 900; scheduler.push(p, 0);
+    p.taskId = 3; p.priority = 2; p.deadlineMs = 500; scheduler.push(p, 0);
+    p.taskId = 4; p.priority = 1; p.deadlineMs = 0; scheduler.push(p, 0);
+    dtq::Task out;
+    assert(scheduler.pop(out, 0) && out.taskId == 3);
+    assert(scheduler.pop(out, 0) && out.taskId == 2);
+    p.taskId = 5; p.priority = 1; scheduler.push(p, 1500);
+    // After a full interval task 4 has aged to the top level and task 1 to
+    // level 1, where its earlier implicit deadline puts it ahead of task 5.
+    assert(scheduler.pop(out, 1500) && out.taskId == 4);
+    assert(scheduler.pop(out, 1500) && out.taskId == 1);
+    assert(scheduler.pop(out, 1500) && out.taskId == 5);
+    assert(!scheduler.pop(out, 1500) && scheduler.size() == 0);
+
+    // Test: The Priority backend orders TaskQueue dequeues by priority.
+    dtq::TaskQueue priorityQueue(dtq::QueueBackend::Priority);
+    p.deadlineMs = 0;
+    p.taskId = 20; p.priority = 0; priorityQueue.enqueue(p);
+    p.taskId = 21; p.priority = 2; priorityQueue.enqueue(p);
+    assert(priorityQueue.size() == 2);
+    drained = priorityQueue.dequeueBulk(8);
+    assert(drained.size() == 2 && drained[0].taskId == 21 && drained[1].taskId == 20);
+
+    // Test: With a latency target, new tasks are shed only once every task
+    // dequeued for a whole interval waited longer than the target, and are
+    // admitted again once a dequeued task waited less.
+    for (dtq::QueueBackend kind : {dtq::QueueBackend::Mutex, dtq::QueueBackend::LockFreeRing})
+    {
+        dtq::TaskQueue codel(kind);
+        codel.setLatencyTarget(std::chrono::milliseconds(5), std::chrono::milliseconds(20));
+        dtq::Task c;
+        for (int i = 0; i < 10; ++i)
+        {
+            c.taskId = 300 + i;
+            assert(codel.enqueue(c));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        assert(codel.dequeue()); // over target: the interval starts
+        assert(!codel.shedding());
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        assert(codel.dequeue()); // still over a whole interval later
+        assert(codel.shedding());
+        c.taskId = 400;
+        assert(!codel.enqueue(c) && codel.shed() == 1);
+        assert(codel.enqueueBulk(std::vector<dtq::Task>(3, c)) == 0 && codel.shed() == 4);
+        assert(codel.size() == 8);
+        // The backlog drains; the last dequeue leaves the queue empty
+        assert(codel.dequeueBulk(16).size() == 8);
+        assert(!codel.shedding());
+        assert(codel.enqueue(c));
+        // A task dequeued under the target resets the interval
+        assert(codel.dequeue() && !codel.shedding());
+
+        // Without a target nothing is ever shed
+        codel.setLatencyTarget(std::chrono::microseconds(0));
+        for (int i = 0; i < 3; ++i)
+        {
+            c.taskId = 500 + i;
+            assert(codel.enqueue(c));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        assert(codel.dequeue() && codel.dequeue() && !codel.shedding());
+    }
+
+    // Test: A rejected push leaves the store as it found it: a finished
+    // task's result survives, an in-progress task keeps its state, and an
+    // id the queue never took stays unknown.
+    for (dtq::QueueBackend kind : {dtq::QueueBackend::Mutex, dtq::QueueBackend::LockFreeRing})
+    {
+        dtq::TaskQueue full(kind, 2);
+        dtq::Task r;
+        for (int id : {600, 601})
+        {
+            r.taskId = id;
+            assert(full.enqueue(r));
+        }
+        assert(full.dequeueBulk(2).size() == 2);
+        assert(full.updateTaskResult(600, "done", dtq::TaskStatus::COMPLETED));
+        r.taskId = 602;
+        assert(full.enqueue(r));
+        r.taskId = 603;
+        assert(full.enqueue(r));
+        for (int id : {600, 601, 604})
+        {
+            r.taskId = id;
+            assert(!full.enqueue(r));
+        }
+        std::vector<dtq::Task> resubmitted(3, r);
+        resubmitted[0].taskId = 600;
+        resubmitted[1].taskId = 604;
+        resubmitted[2].taskId = 601;
+        assert(full.enqueueBulk(resubmitted) == 0);
+        std::optional<dtq::TaskRecord> kept = full.store().lookup(600);
+        assert(kept && kept->status == dtq::TaskStatus::COMPLETED && kept->result == "done");
+        kept = full.store().lookup(601);
+        assert(kept && kept->status == dtq::TaskStatus::IN_PROGRESS);
+        assert(!full.store().lookup(604));
+        // The restored record is final again: a second result is refused
+        assert(!full.updateTaskResult(600, "again", dtq::TaskStatus::COMPLETED));
+    }
+
     std::cout << "All TaskQueue tests passed." << std::endl;
     return 0;
 }
@@ -0,0 +1,72 @@
+#include "TaskStore.h"
+#include "TaskQueue.h"
+#include "Logger.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+
+int main() {
+    dtq::Logger::getInstance().setMinLevel(dtq::LogLevel::WARN);
+
+    // Test: Status transitions follow PENDING -> IN_PROGRESS -> COMPLETED.
+    dtq::TaskStore store(4);
+    assert(!store.lookup(1).has_value());
+    assert(!store.transition(1, dtq::TaskStatus::IN_PROGRESS));
+    store.markPending(1);
+    assert(store.lookup(1)->status == dtq::TaskStatus::PENDING);
+    assert(store.transition(1, dtq::TaskStatus::IN_PROGRESS));
+    assert(!store.transition(1, dtq::TaskStatus::IN_PROGRESS));
+    assert(store.transition(1, dtq::TaskStatus::PENDING)); // requeued
+    assert(store.transition(1, dtq::TaskStatus::IN_PROGRESS));
+    assert(store.transition(1, dtq::TaskStatus::COMPLETED, "ok"));
+    assert(!store.transition(1, dtq::TaskStatus::FAILED, "late"));
+    auto record = store.lookup(1);
+    assert(record && record->status == dtq::TaskStatus::COMPLETED && record->result == "ok");
+
+    // Test: Records survive the wire encoding used by CLIENT_GET_RESULT(S_BATCH).
+    std::string encoded;
+    dtq::TaskStore::encodeRecord(encoded, 1, record);
+    dtq::TaskStore::encodeRecord(encoded, 2, std::nullopt);
+    std::string_view in(encoded);
+    int taskId = 0;
+    std::optional<dtq::TaskRecord> decoded;
+    assert(dtq::TaskStore::decodeRecord(in, taskId, decoded));
+    assert(taskId == 1 && decoded && decoded->result == "ok");
+    assert(dtq::TaskStore::decodeRecord(in, taskId, decoded));
+    assert(taskId == 2 && !decoded && in.empty());
+
+    // Test: Finished entries are evicted oldest first over the memory budget.
+    dtq::TaskStore small(1, 2048);
+    for (int id = 0; id < 100; ++id) {
+        small.markPending(id);
+        small.transition(id, dtq::TaskStatus::COMPLETED, std::string(64, 'r'));
+    }
+    assert(!small.lookup(0).has_value());
+    assert(small.lookup(99).has_value());
+    assert(small.size() < 100);
+
+    // Test: ... and once they are older than the TTL.
+    dtq::TaskStore shortLived(1, 0, std::chrono::milliseconds(20));
+    shortLived.markPending(7);
+    shortLived.transition(7, dtq::TaskStatus::FAILED, "boom");
+    assert(shortLived.lookup(7).has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(!shortLived.lookup(7).has_value());
+
+    // Test: TaskQueue records enqueue/dequeue in its store.
+    dtq::TaskQueue queue;
+    dtq::Task task;
+    task.taskId = 42;
+    queue.enqueue(task);
+    assert(queue.store().lookup(42)->status == dtq::TaskStatus::PENDING);
+    queue.dequeue();
+    assert(queue.store().lookup(42)->status == dtq::TaskStatus::IN_PROGRESS);
+    assert(queue.updateTaskResult(42, "done", dtq::TaskStatus::COMPLETED));
+    assert(queue.store().lookup(42)->result == "done");
+    assert(!queue.updateTaskResult(43, "unknown", dtq::TaskStatus::COMPLETED));
+
+    std::cout << "All TaskStore tests passed." << std::endl;
+    return 0;
+}
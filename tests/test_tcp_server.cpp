@@ -0,0 +1,103 @@
+#include "TcpServer.h"
+#include "Config.h"
+#include "Network.h"
+#include "Logger.h"
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define SHUT_WR SD_SEND
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// Echoes every frame back with the same requestId
+struct EchoHandler : dtq::SessionHandler
+{
+    void onMessage(const dtq::SessionPtr &session, dtq::MessageType, uint32_t requestId,
+                   std::string &payload) override
+    {
+        session->send(dtq::MessageType::SERVER_TASK_ACCEPTED, requestId, payload);
+    }
+};
+
+static SOCKET connectTo(int port) {
+    SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    assert(connect(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    return sock;
+}
+
+static std::string frame(uint32_t requestId, int32_t size, const std::string &payload) {
+    dtq::FrameHeader header{static_cast<int32_t>(dtq::MessageType::CLIENT_ADD_TASK), requestId, size};
+    return std::string(reinterpret_cast<const char *>(&header), sizeof(header)) + payload;
+}
+
+static void sendAll(SOCKET sock, const std::string &bytes) {
+    assert(send(sock, bytes.data(), static_cast<int>(bytes.size()), 0) == static_cast<int>(bytes.size()));
+}
+
+int main() {
+    dtq::Logger::getInstance().setMinLevel(dtq::LogLevel::ERR);
+    assert(dtq::Network::initialize());
+    dtq::TcpServer server(0, dtq::TcpServer::defaultMode(), 1);
+    assert(server.start([]() { return std::make_unique<EchoHandler>(); }));
+
+    // Test: Frames written together are all answered, in order.
+    SOCKET sock = connectTo(server.boundPort());
+    {
+        dtq::Network::Connection conn(sock);
+        std::string burst;
+        for (uint32_t i = 1; i <= 50; ++i)
+            burst += frame(i, 3, "abc");
+        burst += frame(51, 200000, std::string(200000, 'z'));
+        sendAll(sock, burst);
+        dtq::MessageType type;
+        uint32_t requestId = 0;
+        std::string payload;
+        for (uint32_t i = 1; i <= 50; ++i)
+            assert(conn.receiveMessage(type, requestId, payload) && requestId == i && payload == "abc");
+        assert(conn.receiveMessage(type, requestId, payload) && requestId == 51 && payload.size() == 200000);
+    }
+
+    // Test: Replies to requests sent before the peer half-closes still arrive.
+    sock = connectTo(server.boundPort());
+    {
+        dtq::Network::Connection conn(sock);
+        sendAll(sock, frame(7, 5, "hello") + frame(8, 100000, std::string(100000, 'y')));
+        shutdown(sock, SHUT_WR);
+        dtq::MessageType type;
+        uint32_t requestId = 0;
+        std::string payload;
+        assert(conn.receiveMessage(type, requestId, payload) && requestId == 7 && payload == "hello");
+        assert(conn.receiveMessage(type, requestId, payload) && requestId == 8 && payload.size() == 100000);
+        assert(!conn.receiveMessage(type, requestId, payload)); // then the server closes
+    }
+
+    // Test: A frame over Config::MaxFrameBytes closes the connection unanswered.
+    sock = connectTo(server.boundPort());
+    {
+        dtq::Network::Connection conn(sock);
+        sendAll(sock, frame(9, static_cast<int32_t>(dtq::Config::MaxFrameBytes + 1), ""));
+        dtq::MessageType type;
+        uint32_t requestId = 0;
+        std::string payload;
+        assert(!conn.receiveMessage(type, requestId, payload));
+    }
+
+    server.stop();
+    dtq::Network::cleanup();
+    std::cout << "All TcpServer tests passed." << std::endl;
+    return 0;
+}
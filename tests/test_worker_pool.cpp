@@ -0,0 +1,107 @@
+#include "WorkerPool.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+static std::vector<dtq::Task> makeTasks(int first, int count)
+{
+    std::vector<dtq::Task> tasks(count);
+    for (int i = 0; i < count; ++i)
+    {
+        tasks[i].taskId = first + i;
+        tasks[i].payload = std::to_string(first + i);
+    }
+    return tasks;
+}
+
+static std::vector<dtq::Task> collect(dtq::WorkerPool &pool, size_t count)
+{
+    std::vector<dtq::Task> done;
+    auto giveUpAt = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (done.size() < count && std::chrono::steady_clock::now() < giveUpAt)
+    {
+        for (dtq::Task &task : pool.takeResults(std::chrono::milliseconds(100)))
+            done.push_back(std::move(task));
+    }
+    return done;
+}
+
+int main() {
+    // Test: Every submitted task runs exactly once and comes back with its result.
+    {
+        dtq::WorkerPool pool(4, [](dtq::Task &task, int workerId) {
+            assert(workerId >= 1 && workerId <= 4);
+            task.status = dtq::TaskStatus::COMPLETED;
+            task.result = "done " + task.payload;
+        });
+        assert(pool.threadCount() == 4);
+        for (int batch = 0; batch < 10; ++batch)
+            pool.submit(makeTasks(batch * 100, 100));
+        std::vector<dtq::Task> done = collect(pool, 1000);
+        assert(done.size() == 1000);
+        std::set<int> ids;
+        for (const dtq::Task &task : done)
+        {
+            assert(task.status == dtq::TaskStatus::COMPLETED && task.result == "done " + std::to_string(task.taskId));
+            ids.insert(task.taskId);
+        }
+        assert(ids.size() == 1000 && *ids.begin() == 0 && *ids.rbegin() == 999);
+        assert(pool.queued() == 0);
+    }
+
+    // Test: An idle thread steals the tasks queued behind a long-running one.
+    {
+        dtq::WorkerPool pool(2, [](dtq::Task &task, int) {
+            if (task.taskId == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        });
+        auto start = std::chrono::steady_clock::now();
+        pool.submit(makeTasks(0, 20));
+        assert(collect(pool, 19).size() >= 19);
+        assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300));
+        assert(pool.steals() > 0);
+        assert(collect(pool, 1).size() == 1);
+    }
+
+    // Test: waitForRoom blocks while the pool is full and returns once tasks start.
+    {
+        std::atomic<bool> release{false};
+        dtq::WorkerPool pool(1, [&](dtq::Task &, int) {
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+        pool.submit(makeTasks(0, 4));
+        // One task is running, so three are queued
+        auto giveUpAt = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (pool.queued() != 3 && std::chrono::steady_clock::now() < giveUpAt)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        assert(pool.queued() == 3);
+        assert(!pool.waitForRoom(3, std::chrono::milliseconds(20)));
+        assert(pool.waitForRoom(4, std::chrono::milliseconds(0)));
+        release.store(true);
+        assert(pool.waitForRoom(1, std::chrono::seconds(5)));
+        assert(collect(pool, 4).size() == 4);
+    }
+
+    // Test: stop() lets the running task finish and drops the ones not started.
+    {
+        dtq::WorkerPool pool(1, [](dtq::Task &, int) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        });
+        pool.submit(makeTasks(0, 10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        pool.stop();
+        assert(pool.queued() == 0);
+        std::vector<dtq::Task> done = pool.takeResults(std::chrono::milliseconds(0));
+        assert(done.size() == 1 && done[0].taskId == 0);
+        assert(pool.takeResults(std::chrono::seconds(5)).empty());
+        assert(!pool.waitForRoom(100, std::chrono::seconds(5)));
+    }
+
+    std::cout << "All WorkerPool tests passed." << std::endl;
+    return 0;
+}
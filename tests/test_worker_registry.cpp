@@ -0,0 +1,81 @@
+#include "WorkerRegistry.h"
+#include <iostream>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <vector>
+
+static std::deque<int> ready;
+
+static std::vector<dtq::Task> takeTasks(size_t, size_t n)
+{
+    std::vector<dtq::Task> tasks;
+    while (tasks.size() < n && !ready.empty())
+    {
+        dtq::Task task;
+        task.taskId = ready.front();
+        ready.pop_front();
+        tasks.push_back(task);
+    }
+    return tasks;
+}
+
+static void addTasks(int first, int count)
+{
+    for (int i = 0; i < count; ++i)
+        ready.push_back(first + i);
+}
+
+int main() {
+    std::map<uint64_t, std::vector<int>> pushed;
+    std::map<uint64_t, int> evicted;
+    auto pushTo = [&](uint64_t id) {
+        return [&pushed, id](std::vector<dtq::Task> &&tasks) {
+            assert(!tasks.empty());
+            for (const dtq::Task &task : tasks)
+                pushed[id].push_back(task.taskId);
+        };
+    };
+    auto evictOf = [&](uint64_t id) { return [&evicted, id]() { ++evicted[id]; }; };
+
+    // Test: Registering pushes what is already ready, up to the worker's credit.
+    dtq::WorkerRegistry registry(takeTasks, 4);
+    addTasks(0, 3);
+    registry.add(1, 0, 2, 0, pushTo(1), evictOf(1));
+    assert(pushed[1] == std::vector<int>({0, 1}));
+    assert(ready.size() == 1 && registry.credits() == 0);
+
+    // Test: New tasks wait for credit; a heartbeat's credit releases them.
+    addTasks(3, 2);
+    registry.onTasksAvailable();
+    assert(pushed[1].size() == 2 && ready.size() == 3);
+    assert(registry.heartbeat(1, 5, 10));
+    assert(pushed[1].size() == 5 && ready.empty() && registry.credits() == 2);
+
+    // Test: Workers with credit are served round-robin, at most maxBatch per push.
+    registry.add(2, 0, 10, 10, pushTo(2), evictOf(2));
+    addTasks(100, 12);
+    registry.onTasksAvailable();
+    // Worker 1 is first in line with 2 credits left, then worker 2 takes 4,
+    // then worker 2 again (worker 1 is out of credit) for 4, then 2 more
+    assert(pushed[1].size() == 7 && pushed[2].size() == 10);
+    assert(ready.size() == 0 && registry.credits() == 0);
+
+    // Test: Heartbeats keep workers alive; silent ones are evicted once.
+    assert(registry.heartbeat(2, 0, 5000));
+    std::vector<dtq::WorkerRegistry::Evict> dead = registry.expire(1000);
+    assert(dead.size() == 1 && registry.size() == 1);
+    dead[0]();
+    assert(evicted[1] == 1 && evicted.count(2) == 0);
+    assert(!registry.heartbeat(1, 3, 6000));
+    assert(registry.expire(1000).empty());
+
+    // Test: A removed worker gets nothing more.
+    registry.remove(2);
+    addTasks(200, 2);
+    registry.onTasksAvailable();
+    assert(pushed[2].size() == 10 && ready.size() == 2 && registry.size() == 0);
+
+    std::cout << "All WorkerRegistry tests passed." << std::endl;
+    return 0;
+}